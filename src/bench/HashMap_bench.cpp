@@ -0,0 +1,159 @@
+/** @file HashMap_bench.cpp
+ *
+ * 'MHashMap' against 'std::unordered_map' with the same hasher, for integer keys, string keys and
+ * the 'GridMap' workload of 'MGL.h', 'ivec2' cells hashed by 'CoordHash' holding a small vector of
+ * elements each, both maps drawing from 'slab_resource()'.  Times inserting every key, finding
+ * every key, finding keys that are not there and erasing every key, and prints the nanoseconds
+ * per operation.  Lookups and erases go in a shuffled order, in insertion order a node based map
+ * walks its nodes in allocation order and looks faster then it is.  The first argument is the
+ * number of keys, default 1M.
+ *
+ * Built from 'src' with the library sources it logs through:
+ *
+ *   g++ -std=c++23 -O2 -include cstdarg -Iinclude bench/HashMap_bench.cpp cpp/Alloc_stats.cpp cpp/Debug.cpp \
+ *     cpp/Sys.cpp cpp/Error.cpp cpp/Io.cpp cpp/Str_prim.cpp cpp/Str_intern.cpp cpp/Profile.cpp \
+ *     cpp/Mem_resource.cpp cpp/Obj_pool.cpp cpp/Mem_pool.cpp cpp/Conv.cpp cpp/Utf8.cpp -lpthread -o hashmap_bench
+ */
+#include "../include/HashMap.h"
+#include "../include/Mem_resource.h"
+#include "../include/SmallVector.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* The layout and equality of 'ivec2' from 'openGL/vec.h', which pulls in the gl headers. */
+struct bench_ivec2_t {
+  int x;
+  int y;
+
+  bool operator==(const bench_ivec2_t &other) const noexcept {
+    return (x == other.x && y == other.y);
+  }
+};
+
+/* 'CoordHash' from 'MGL.h' as is. */
+struct bench_coord_hash_t {
+  Ulong operator()(const bench_ivec2_t &coord) const {
+    Ulong hash_x = std::hash<int>()(coord.x);
+    Ulong hash_y = std::hash<int>()(coord.y);
+    return hash_x ^ (hash_y * 0x9e3779b9 + (hash_x << 6) + (hash_x >> 2));
+  }
+};
+
+/* A grid cell, like 'GridMap' stores. */
+typedef MSmallVector<void *, 4> bench_cell_t;
+
+/* Keeps results alive so the lookups are not optimized out. */
+static volatile Ulong bench_sink;
+
+struct bench_result_t {
+  double insert;
+  double find_hit;
+  double find_miss;
+  double erase;
+};
+
+/* Return`s the nanoseconds per call of 'fn' for each of 'n' keys. */
+template <class F>
+static double bench_time(Ulong n, F fn) {
+  auto start = std::chrono::steady_clock::now();
+  for (Ulong i = 0; i < n; ++i) {
+    fn(i);
+  }
+  return (std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / n);
+}
+
+/* Integer and string keys map to their index, grid cells get an element appended like
+ * 'GridMap::set()' does. */
+template <class Map, class K>
+static void bench_insert(Map &map, const K &key, Ulong i) {
+  if constexpr (std::is_same_v<typename Map::value_type::second_type, bench_cell_t>) {
+    map[key].emplace_back((void *)i);
+  }
+  else {
+    map.insert({key, i});
+  }
+}
+
+/* 'keys' are inserted in order, then found and erased in the order of 'order'.  'misses' are
+ * looked up and never inserted. */
+template <class Map, class K>
+static bench_result_t bench_map(Map &map, const std::vector<K> &keys, const std::vector<Ulong> &order, const std::vector<K> &misses) {
+  bench_result_t result;
+  Ulong          n     = keys.size();
+  Ulong          found = 0;
+  result.insert    = bench_time(n, [&](Ulong i) { bench_insert(map, keys[i], i); });
+  result.find_hit  = bench_time(n, [&](Ulong i) { found += (map.find(keys[order[i]]) != map.end()); });
+  result.find_miss = bench_time(n, [&](Ulong i) { found += (map.find(misses[i]) != map.end()); });
+  result.erase     = bench_time(n, [&](Ulong i) { found += map.erase(keys[order[i]]); });
+  bench_sink = found;
+  return result;
+}
+
+static void bench_print(const char *name, const bench_result_t &mine, const bench_result_t &std) {
+  printf("%s\n", name);
+  printf("  %-10s %14s %14s\n", "", "MHashMap ns", "unordered ns");
+  printf("  %-10s %14.2f %14.2f\n", "insert", mine.insert, std.insert);
+  printf("  %-10s %14.2f %14.2f\n", "find hit", mine.find_hit, std.find_hit);
+  printf("  %-10s %14.2f %14.2f\n", "find miss", mine.find_miss, std.find_miss);
+  printf("  %-10s %14.2f %14.2f\n", "erase", mine.erase, std.erase);
+}
+
+template <class K>
+static void bench_keys(const char *name, const std::vector<K> &keys, const std::vector<Ulong> &order, const std::vector<K> &misses) {
+  MHashMap<K, Ulong>                       mine;
+  std::unordered_map<K, Ulong, mhash_t<K>> std;
+  bench_result_t                           a = bench_map(mine, keys, order, misses);
+  bench_result_t                           b = bench_map(std, keys, order, misses);
+  bench_print(name, a, b);
+}
+
+int main(int argc, char **argv) {
+  Ulong              n = ((argc > 1) ? strtoul(argv[1], nullptr, 10) : 1000000ul);
+  std::mt19937_64    rng(42);
+  std::vector<Ulong> order(n);
+  for (Ulong i = 0; i < n; ++i) {
+    order[i] = i;
+  }
+  std::shuffle(order.begin(), order.end(), rng);
+  std::vector<Ulong>       ints(n);
+  std::vector<Ulong>       int_misses(n);
+  std::vector<std::string> strs(n);
+  std::vector<std::string> str_misses(n);
+  /* Odd and even multiples of a large odd constant, so hits and misses never collide. */
+  for (Ulong i = 0; i < n; ++i) {
+    ints[i]       = (((2 * i) + 1) * 0x9E3779B97F4A7C15ul);
+    int_misses[i] = ((2 * i) * 0x9E3779B97F4A7C15ul);
+    strs[i]       = ("key_" + std::to_string(ints[i]));
+    str_misses[i] = ("key_" + std::to_string(int_misses[i]));
+  }
+  bench_keys("Ulong keys", ints, order, int_misses);
+  bench_keys("std::string keys", strs, order, str_misses);
+  /* A square of cells centered on the origin, like elements spread over and past a window,
+   * misses are the cells of the same square shifted past its right edge. */
+  std::vector<bench_ivec2_t> cells(n);
+  std::vector<bench_ivec2_t> cell_misses(n);
+  int                        side = 1;
+  while ((Ulong)side * side < n) {
+    ++side;
+  }
+  for (Ulong i = 0; i < n; ++i) {
+    int x = (int)(i % side) - (side / 2);
+    int y = (int)(i / side) - (side / 2);
+    cells[i]       = {x, y};
+    cell_misses[i] = {(x + side), y};
+  }
+  MHashMap<bench_ivec2_t, bench_cell_t, bench_coord_hash_t, std::equal_to<>, pmr_alloc_t> grid {pmr_alloc_t(slab_resource())};
+  std::pmr::unordered_map<bench_ivec2_t, bench_cell_t, bench_coord_hash_t>                std_grid(slab_resource());
+  bench_result_t a = bench_map(grid, cells, order, cell_misses);
+  bench_result_t b = bench_map(std_grid, cells, order, cell_misses);
+  bench_print("ivec2 keys, CoordHash (GridMap)", a, b);
+  return 0;
+}
@@ -0,0 +1,73 @@
+/** @file Str_search_bench.cpp
+ *
+ * 'mstrmem()' against 'strstr()', 'memmem()' and 'std::string::find()' on a large haystack of
+ * random words, with needles of a few lengths that only match at the very end.  The short ones
+ * start with bytes that are rare in the text or with common ones, 'strstr()' is only fast in the
+ * rare case.  Prints the throughput of each in GB/s, and exits with 1 when they disagree on where
+ * the match is.  The first argument is the haystack size in bytes, default 1 MiB.
+ *
+ * Built from 'src' with the library sources it logs through:
+ *
+ *   g++ -std=c++23 -O2 -include cstdarg -Iinclude bench/Str_search_bench.cpp cpp/String.cpp cpp/Alloc_stats.cpp \
+ *     cpp/Debug.cpp cpp/Sys.cpp cpp/Error.cpp cpp/Io.cpp cpp/Str_prim.cpp cpp/Str_intern.cpp cpp/Profile.cpp \
+ *     cpp/Mem_resource.cpp cpp/Obj_pool.cpp cpp/Mem_pool.cpp cpp/Conv.cpp cpp/Utf8.cpp -lpthread -o str_search_bench
+ */
+#include "../include/String.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+
+#define BENCH_BYTES (1ul << 30)
+
+/* Return`s the offset found by 'fn' and sets 'gbs' to the throughput over 'hay_len' bytes,
+ * repeating the search until about 'BENCH_BYTES' have been scanned. */
+template <class F>
+static Ulong bench_search(Ulong hay_len, double *gbs, F fn) {
+  Ulong rounds = ((BENCH_BYTES / hay_len) + 1);
+  Ulong found  = 0;
+  auto  start  = std::chrono::steady_clock::now();
+  for (Ulong i = 0; i < rounds; ++i) {
+    found = fn();
+    /* The searches are pure, without this they would run once. */
+    __asm__ __volatile__("" : "+r"(found) : : "memory");
+  }
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  *gbs = ((double)(hay_len * rounds) / ns);
+  return found;
+}
+
+int main(int argc, char **argv) {
+  Ulong       hay_len  = ((argc > 1) ? strtoul(argv[1], nullptr, 10) : (1ul << 20));
+  const char *needles[] = {"xz", "tz", "xyzzy", "e zap", "the quick brown fox jumps", "a needle that is rather long, longer then most words in the text"};
+  std::string hay;
+  /* Plain words, so first bytes of the needles match often and the last byte check has to work. */
+  const char *words[] = {"the ", "a ", "quick ", "brown ", "fox ", "jumps ", "over ", "lazy ", "dog ", "needle ", "that ", "is "};
+  std::mt19937_64 rng(42);
+  while (hay.size() < hay_len) {
+    hay += words[rng() % (sizeof(words) / sizeof(*words))];
+  }
+  hay.resize(hay_len);
+  printf("%-4s %-12s %12s %12s %12s %12s\n", "len", "needle", "mstrmem", "strstr", "memmem", "find");
+  for (const char *needle : needles) {
+    Ulong       needle_len = strlen(needle);
+    std::string text       = hay;
+    text.replace((hay_len - needle_len), needle_len, needle);
+    const char *data = text.data();
+    double      gbs[4];
+    Ulong       at[4];
+    at[0] = bench_search(hay_len, &gbs[0], [&] { return (Ulong)(mstrmem(data, hay_len, needle, needle_len) - data); });
+    at[1] = bench_search(hay_len, &gbs[1], [&] { return (Ulong)(strstr(data, needle) - data); });
+    at[2] = bench_search(hay_len, &gbs[2], [&] { return (Ulong)((const char *)memmem(data, hay_len, needle, needle_len) - data); });
+    at[3] = bench_search(hay_len, &gbs[3], [&] { return (Ulong)text.find(needle, 0, needle_len); });
+    printf("%-4lu %-12.12s %7.2f GB/s %7.2f GB/s %7.2f GB/s %7.2f GB/s\n", needle_len, needle, gbs[0], gbs[1], gbs[2], gbs[3]);
+    if (at[0] != at[1] || at[0] != at[2] || at[0] != at[3]) {
+      fprintf(stderr, "Searches disagree for '%s': %lu %lu %lu %lu\n", needle, at[0], at[1], at[2], at[3]);
+      return 1;
+    }
+  }
+  return 0;
+}
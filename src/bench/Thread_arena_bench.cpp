@@ -0,0 +1,86 @@
+/** @file Thread_arena_bench.cpp
+ *
+ * Thread scaling of 'thread_arena_t' against malloc/free.  Every thread makes small allocations
+ * of mixed sizes and starts over every 'BENCH_ROUND' of them, 'reset()' for the arena and freeing
+ * each block for malloc.  A round spans several slabs, so every thread keeps popping slabs from
+ * the shared list and pushing them back on reset, which is the contended path.  Prints the time
+ * per allocation for 1 thread upto the number of cores, or upto the first argument when given.
+ *
+ * Built from 'src' with the library sources it logs through:
+ *
+ *   g++ -std=c++23 -O2 -include cstdarg -Iinclude bench/Thread_arena_bench.cpp cpp/Thread_arena.cpp \
+ *     cpp/Mem_pool.cpp cpp/Alloc_stats.cpp cpp/Debug.cpp cpp/Sys.cpp cpp/Error.cpp cpp/Io.cpp cpp/Str_prim.cpp \
+ *     cpp/Str_intern.cpp cpp/Profile.cpp cpp/Mem_resource.cpp cpp/Obj_pool.cpp cpp/Conv.cpp cpp/Utf8.cpp \
+ *     -lpthread -o thread_arena_bench
+ */
+#include "../include/Thread_arena.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#define BENCH_ALLOCS 20000000ul
+/* Allocations average about 140 bytes with padding, so a round fills about four slabs. */
+#define BENCH_ROUND  65536ul
+
+/* Sizes from 8 to 256 bytes, the same sequence for both allocators. */
+static __inline__ Ulong bench_size(Ulong i) {
+  return (8 + ((i * 2654435761ul) % 249));
+}
+
+static void bench_arena(Ulong allocs) {
+  thread_arena_t &arena = thread_arena_t::local();
+  for (Ulong i = 0; i < allocs; ++i) {
+    char *p = (char *)arena.alloc(bench_size(i));
+    *p      = (char)i;
+    if ((i % BENCH_ROUND) == (BENCH_ROUND - 1)) {
+      arena.reset();
+    }
+  }
+  arena.reset();
+}
+
+static void bench_malloc(Ulong allocs) {
+  std::vector<void *> live(BENCH_ROUND);
+  for (Ulong i = 0; i < allocs; ++i) {
+    char *p = (char *)malloc(bench_size(i));
+    *p      = (char)i;
+    live[i % BENCH_ROUND] = p;
+    if ((i % BENCH_ROUND) == (BENCH_ROUND - 1)) {
+      for (Ulong k = 0; k < BENCH_ROUND; ++k) {
+        free(live[k]);
+      }
+    }
+  }
+  for (Ulong k = 0; k < (allocs % BENCH_ROUND); ++k) {
+    free(live[k]);
+  }
+}
+
+/* Return`s the nanoseconds per allocation with 'threads' threads, each doing an equal share. */
+static double bench_run(void (*fn)(Ulong), Uint threads) {
+  std::vector<std::thread> pool;
+  Ulong per_thread = (BENCH_ALLOCS / threads);
+  auto  start      = std::chrono::steady_clock::now();
+  for (Uint t = 0; t < threads; ++t) {
+    pool.emplace_back(fn, per_thread);
+  }
+  for (std::thread &thread : pool) {
+    thread.join();
+  }
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  return (ns / (per_thread * threads));
+}
+
+int main(int argc, char **argv) {
+  Uint max_threads = ((argc > 1) ? (Uint)atoi(argv[1]) : std::thread::hardware_concurrency());
+  printf("%-8s %14s %14s\n", "threads", "arena ns/op", "malloc ns/op");
+  for (Uint threads = 1; threads <= (max_threads ? max_threads : 1); threads *= 2) {
+    double arena = bench_run(bench_arena, threads);
+    double heap  = bench_run(bench_malloc, threads);
+    printf("%-8u %14.2f %14.2f\n", threads, arena, heap);
+  }
+  return 0;
+}
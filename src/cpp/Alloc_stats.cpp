@@ -0,0 +1,100 @@
+#include "../include/Alloc_stats.h"
+
+#ifdef MLIB_ALLOC_STATS
+
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+static std::mutex    alloc_site_mutex;
+static alloc_site_t *alloc_site_head = nullptr;
+
+static void alloc_site_raise_peak(alloc_site_t *site, Ulong live) noexcept {
+  Ulong peak = site->peak_bytes.load(std::memory_order_relaxed);
+  while (live > peak && !site->peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+  }
+}
+
+void alloc_site_t::record_alloc(Ulong bytes, Ulong padding) noexcept {
+  allocs.fetch_add(1, std::memory_order_relaxed);
+  total_bytes.fetch_add(bytes, std::memory_order_relaxed);
+  padding_bytes.fetch_add(padding, std::memory_order_relaxed);
+  alloc_site_raise_peak(this, (live_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes));
+}
+
+void alloc_site_t::record_free(Ulong bytes) noexcept {
+  frees.fetch_add(1, std::memory_order_relaxed);
+  live_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+void alloc_site_t::record_realloc(Ulong old_bytes, Ulong new_bytes) noexcept {
+  allocs.fetch_add(1, std::memory_order_relaxed);
+  if (old_bytes) {
+    frees.fetch_add(1, std::memory_order_relaxed);
+  }
+  total_bytes.fetch_add(new_bytes, std::memory_order_relaxed);
+  alloc_site_raise_peak(this, (live_bytes.fetch_add((new_bytes - old_bytes), std::memory_order_relaxed) + (new_bytes - old_bytes)));
+}
+
+void alloc_site_t::record_waste(Ulong bytes) noexcept {
+  wasted_bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void alloc_site_t::record_resize(Ulong new_bytes) noexcept {
+  allocs.fetch_add(1, std::memory_order_relaxed);
+  total_bytes.fetch_add(new_bytes, std::memory_order_relaxed);
+}
+
+alloc_site_t *alloc_stats_site(const char *tag) noexcept {
+  std::lock_guard<std::mutex> lock(alloc_site_mutex);
+  for (alloc_site_t *site = alloc_site_head; site; site = site->next) {
+    if (strcmp(site->tag, tag) == 0) {
+      return site;
+    }
+  }
+  /* Sites are never freed, the profiler reports them at exit. */
+  alloc_site_t *site = new (std::nothrow) alloc_site_t {};
+  if (!site) {
+    /* Fall back to a shared site so callers never see nullptr. */
+    static alloc_site_t overflow {
+      .tag           = "<untracked>",
+      .next          = nullptr,
+      .allocs        = 0,
+      .frees         = 0,
+      .total_bytes   = 0,
+      .live_bytes    = 0,
+      .peak_bytes    = 0,
+      .padding_bytes = 0,
+      .wasted_bytes  = 0,
+    };
+    return &overflow;
+  }
+  site->tag       = tag;
+  site->next      = alloc_site_head;
+  alloc_site_head = site;
+  return site;
+}
+
+std::vector<std::string> alloc_stats_lines(void) {
+  std::vector<std::string>    lines;
+  std::lock_guard<std::mutex> lock(alloc_site_mutex);
+  if (!alloc_site_head) {
+    return lines;
+  }
+  lines.push_back("\n\nAllocation report:\n");
+  char buffer[4096];
+  for (alloc_site_t *site = alloc_site_head; site; site = site->next) {
+    if (!site->allocs.load()) {
+      continue;
+    }
+    snprintf(buffer, sizeof(buffer),
+             "%s: Allocs = %lu, Frees = %lu, Total = %lu B, Live = %lu B, Peak = %lu B, Padding = %lu B, Wasted = %lu B\n",
+             site->tag, site->allocs.load(), site->frees.load(), site->total_bytes.load(), site->live_bytes.load(),
+             site->peak_bytes.load(), site->padding_bytes.load(), site->wasted_bytes.load());
+    lines.push_back(buffer);
+  }
+  return lines;
+}
+
+#endif
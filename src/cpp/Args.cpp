@@ -1,7 +1,56 @@
 #include "../include/Args.h"
+#include "../include/Str_prim.h"
+#include "../include/constexpr.hpp"
+
+#if defined(__x86_64__)
+#  include <immintrin.h>
+#endif
 
 using namespace std;
 
+/* Inside double quotes a backslash only escapes these, like in a shell, before anything else it
+ * is kept as is. */
+__inline__ static bool __attribute((__always_inline__)) args_dquote_escapes(char c) {
+  return (c == '"' || c == '\\' || c == '$' || c == '`' || c == '\n');
+}
+
+#if defined(__x86_64__)
+
+static bool args_resolve_avx2(void) noexcept {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+}
+
+/* Resolved once by the first caller, so arguments tokenized from static constructors in other
+ * files still get the avx2 scan. */
+__inline__ static bool __attribute((__always_inline__)) args_avx2(void) noexcept {
+  static const bool avx2 = args_resolve_avx2();
+  return avx2;
+}
+
+/* First byte at or after 'i' whose low and high nibble lookups share a bit, or the start of the
+ * last partial block.  Bytes that share a bit by accident are possible when there are more then
+ * eight special bytes, so the caller checks every hit. */
+__attribute((__target__("avx2"))) static Ulong args_scan_avx2(const char *str, Ulong i, Ulong len, const Uchar *lut_lo, const Uchar *lut_hi) noexcept {
+  const __m256i lo     = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)lut_lo));
+  const __m256i hi     = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)lut_hi));
+  const __m256i nibble = _mm256_set1_epi8(0x0F);
+  for (; (i + 32) <= len; i += 32) {
+    __m256i input = _mm256_loadu_si256((const __m256i *)(str + i));
+    __m256i bits  = _mm256_and_si256(
+      _mm256_shuffle_epi8(lo, _mm256_and_si256(input, nibble)),
+      _mm256_shuffle_epi8(hi, _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble))
+    );
+    Uint mask = ~(Uint)_mm256_movemask_epi8(_mm256_cmpeq_epi8(bits, _mm256_setzero_si256()));
+    if (mask) {
+      return (i + __builtin_ctz(mask));
+    }
+  }
+  return i;
+}
+
+#endif
+
 namespace Mlib::Args {
   vector<string> argvToStrVec(int argc, char **argv) {
     vector<string> args;
@@ -22,21 +71,21 @@ namespace Mlib::Args {
     return cmd;
   }
 
-  string flagValue(const string &flag, int argC, char **argV) {
+  string flagValue(string_view flag, int argC, char **argV) {
     for (int i = 0; i < argC; ++i) {
       if (argV[i] == flag) {
         if (i + 1 < argC) {
           return argV[i + 1];
         }
         else {
-          throw runtime_error("Flag '" + flag + "' has no value.");
+          throw runtime_error("Flag '" + string(flag) + "' has no value.");
         }
       }
     }
-    throw runtime_error("Flag '" + flag + "' not found.");
+    throw runtime_error("Flag '" + string(flag) + "' not found.");
   }
 
-  bool flagExists(const string &flag, int argC, char **argV) {
+  bool flagExists(string_view flag, int argC, char **argV) {
     for (int i = 0; i < argC; ++i) {
       if (argV[i] == flag) {
         return true;
@@ -63,20 +112,29 @@ namespace Mlib::Args {
 
   vector<string> strVecFromStr(const string &str, char delim) {
     vector<string> args;
-    for (size_t i = 0, start = 0; i < str.size(); ++i) {
-      if (str[i] == delim) {
-        string s1 = str.substr(start, i - start);
-        args.push_back(s1);
-        start = i + 1;
-      }
-      if (i == str.size() - 1) {
-        string s2 = str.substr(start, i - start + 1);
-        args.push_back(s2);
-      }
+    for (string_view part : strViewVecFromStr(str, delim)) {
+      args.emplace_back(part);
     }
     return args;
   }
 
+  /* Every delimiter ends a part, and the text after the last one is a part as well, even when
+   * empty.  Only an empty 'str' has no parts. */
+  vector<string_view> strViewVecFromStr(string_view str, char delim) {
+    vector<string_view> parts;
+    if (str.empty()) {
+      return parts;
+    }
+    Ulong start = 0;
+    for (const char *found; (found = (const char *)mmemchr((str.data() + start), delim, (str.size() - start)));) {
+      Ulong at = (found - str.data());
+      parts.push_back(str.substr(start, (at - start)));
+      start = (at + 1);
+    }
+    parts.push_back(str.substr(start));
+    return parts;
+  }
+
   string strFromStrVec(const vector<string> &strVec) {
     string str;
     for (size_t i = 0; i < strVec.size(); ++i) {
@@ -88,29 +146,222 @@ namespace Mlib::Args {
     return str;
   }
 
+  /** @class @c Tokenizer */
+
+  Tokenizer::Tokenizer(string_view str, string_view delims, bool quotes) noexcept
+    : _str(str.data()), _len(str.size()), _pos(0), _delim{}, _special{}, _lut_lo{}, _lut_hi{} {
+    for (char c : delims) {
+      _delim[(Uchar)c] = true;
+    }
+    memcpy(_special, _delim, sizeof(_special));
+    if (quotes) {
+      _special[(Uchar)'"']  = true;
+      _special[(Uchar)'\''] = true;
+      _special[(Uchar)'\\'] = true;
+    }
+    /* Give every special byte one of the eight bits in the entry of both its nibbles. */
+    for (Uint c = 0, bit = 0; c < 256; ++c) {
+      if (_special[c]) {
+        _lut_lo[c & 0x0F] |= (1 << bit);
+        _lut_hi[c >> 4]   |= (1 << bit);
+        bit = ((bit + 1) % 8);
+      }
+    }
+  }
+
+  Ulong Tokenizer::_find_special(Ulong i) const noexcept {
+    for (; i < _len; ++i) {
+#if defined(__x86_64__)
+      if (args_avx2() && (i + 32) <= _len) {
+        i = args_scan_avx2(_str, i, _len, _lut_lo, _lut_hi);
+        if (i == _len) {
+          break;
+        }
+      }
+#endif
+      if (_special[(Uchar)_str[i]]) {
+        return i;
+      }
+    }
+    return _len;
+  }
+
+  /* The closing 'quote' of a string opened before 'i', or '_len' when it is never closed.  Only
+   * double quoted strings have escapes, 'escaped' is set when there are any. */
+  Ulong Tokenizer::_find_quote(Ulong i, char quote, bool &escaped) const noexcept {
+    const char *close = (const char *)mmemchr((_str + i), quote, (_len - i));
+    Ulong       end   = (close ? (Ulong)(close - _str) : _len);
+    escaped = false;
+    if (quote == '\'' || !mmemchr((_str + i), '\\', (end - i))) {
+      return end;
+    }
+    for (; i < _len; ++i) {
+      if (_str[i] == '\\' && (i + 1) < _len && args_dquote_escapes(_str[i + 1])) {
+        escaped = true;
+        ++i;
+      }
+      else if (_str[i] == quote) {
+        return i;
+      }
+    }
+    return _len;
+  }
+
+  bool Tokenizer::next(Token &token) noexcept {
+    while (_pos < _len && _delim[(Uchar)_str[_pos]]) {
+      ++_pos;
+    }
+    if (_pos == _len) {
+      return false;
+    }
+    Ulong start = _pos;
+    Ulong i     = _pos;
+    bool  raw   = false;
+    /* Set while the token so far is one quoted string starting at 'start', ending at 'whole_end'. */
+    bool  whole     = false;
+    Ulong whole_end = 0;
+    while ((i = _find_special(i)) < _len && !_delim[(Uchar)_str[i]]) {
+      char c = _str[i];
+      whole  = (!raw && i == start && c != '\\');
+      raw    = true;
+      if (c == '\\') {
+        i = (((i + 2) < _len) ? (i + 2) : _len);
+        continue;
+      }
+      bool  escaped;
+      Ulong close = _find_quote((i + 1), c, escaped);
+      if (close == _len) {
+        whole = false;
+        i     = _len;
+        break;
+      }
+      whole     = (whole && !escaped);
+      whole_end = (close + 1);
+      i         = (close + 1);
+    }
+    _pos = i;
+    if (whole && i == whole_end) {
+      token.text = string_view((_str + start + 1), (i - start - 2));
+      token.raw  = false;
+    }
+    else {
+      token.text = string_view((_str + start), (i - start));
+      token.raw  = raw;
+    }
+    return true;
+  }
+
+  Ulong Tokenizer::unquote(string_view raw, char *out) noexcept {
+    char *start = out;
+    char  quote = '\0';
+    for (Ulong i = 0; i < raw.size(); ++i) {
+      char c = raw[i];
+      if (quote == '\'') {
+        if (c == '\'') {
+          quote = '\0';
+        }
+        else {
+          *out++ = c;
+        }
+      }
+      else if (c == '\\') {
+        if (quote && ((i + 1) == raw.size() || !args_dquote_escapes(raw[i + 1]))) {
+          *out++ = c;
+        }
+        else if (++i < raw.size()) {
+          *out++ = raw[i];
+        }
+      }
+      else if (c == '"') {
+        quote = (quote ? '\0' : '"');
+      }
+      else if (c == '\'' && !quote) {
+        quote = '\'';
+      }
+      else {
+        *out++ = c;
+      }
+    }
+    return (out - start);
+  }
+
   vector<string_view> tokenizeCommand(string_view command) {
     vector<string_view> tokens;
+    Tokenizer           tokenizer(command, " ", false);
+    for (Token token; tokenizer.next(token);) {
+      tokens.push_back(token.text);
+    }
+    return tokens;
+  }
 
-    u64 start = 0;
-    u64 end   = command.find(' ');
+  /** @class @c ArgIndex */
 
-    while (end != std::string_view::npos) {
-      if (end != start) {
-        tokens.emplace_back(command.substr(start, end - start));
+  ArgIndex::ArgIndex(int argc, char **argv) : _argc(argc), _argv(argv) {
+    /* Keep the load under one half. */
+    Ulong cap = 16;
+    while (cap < ((Ulong)argc * 2)) {
+      cap *= 2;
+    }
+    _slots.resize(cap, {string_view(), 0});
+    for (int i = 1; i < argc; ++i) {
+      string_view arg(argv[i]);
+      if (arg == "--") {
+        break;
+      }
+      else if (arg.size() < 2 || arg[0] != '-') {
+        continue;
+      }
+      string_view flag = arg.substr(0, arg.find('='));
+      for (Ulong at = (Constexpr::fnv1a_64(flag) & (cap - 1));; at = ((at + 1) & (cap - 1))) {
+        if (!_slots[at].flag.data()) {
+          _slots[at] = {flag, i};
+          break;
+        }
+        else if (_slots[at].flag == flag) {
+          break;
+        }
       }
-      start = end + 1;
-      end   = command.find(' ', start);
     }
+  }
 
-    if (start < command.size()) {
-      tokens.emplace_back(command.substr(start));
+  const ArgIndex::slot_t *ArgIndex::_find(string_view flag) const noexcept {
+    Ulong cap = _slots.size();
+    for (Ulong at = (Constexpr::fnv1a_64(flag) & (cap - 1)); _slots[at].flag.data(); at = ((at + 1) & (cap - 1))) {
+      if (_slots[at].flag == flag) {
+        return &_slots[at];
+      }
     }
+    return nullptr;
+  }
 
-    return tokens;
+  bool ArgIndex::exists(string_view flag) const noexcept {
+    return _find(flag);
+  }
+
+  bool ArgIndex::value(string_view flag, string_view &out) const noexcept {
+    const slot_t *slot = _find(flag);
+    if (!slot) {
+      return false;
+    }
+    const char *arg = _argv[slot->index];
+    if (arg[slot->flag.size()] == '=') {
+      out = (arg + slot->flag.size() + 1);
+      return true;
+    }
+    else if ((slot->index + 1) < _argc) {
+      out = _argv[slot->index + 1];
+      return true;
+    }
+    return false;
   }
 
   void constructArgumentListWFile(s8 **&arguments, string_view command, string_view file_name) {
-    auto tokens = tokenizeCommand(command);
+    /* Quoted arguments may hold spaces.  Only spaces split, tabs and newlines stay in arguments. */
+    vector<Token> tokens;
+    Tokenizer     tokenizer(command, " ");
+    for (Token token; tokenizer.next(token);) {
+      tokens.push_back(token);
+    }
     //
     //  +1 for filename, +1 for nullptr terminator
     //
@@ -125,11 +376,17 @@ namespace Mlib::Args {
     //
     u64 i = 0;
     for (; i < tokens.size(); ++i) {
-      const auto &token = tokens[i];
-      s8         *arg   = new s8[token.size() + 1];
-      std::memcpy(arg, token.data(), token.size());
-      arg[token.size()] = '\0';
-      arguments[i]      = arg;
+      const Token &token = tokens[i];
+      s8          *arg   = new s8[token.text.size() + 1];
+      Ulong        len   = token.text.size();
+      if (token.raw) {
+        len = Tokenizer::unquote(token.text, arg);
+      }
+      else {
+        std::memcpy(arg, token.text.data(), len);
+      }
+      arg[len]     = '\0';
+      arguments[i] = arg;
     }
 
     //
@@ -0,0 +1,177 @@
+#include "../include/Conv.h"
+
+#include <charconv>
+#include <cstring>
+
+/* ---------------------------------------------------------- Format ---------------------------------------------------------- */
+
+/* Every pair of digits, so each division by 100 writes two at once. */
+static const char conv_pairs[201] =
+  "0001020304050607080910111213141516171819"
+  "2021222324252627282930313233343536373839"
+  "4041424344454647484950515253545556575859"
+  "6061626364656667686970717273747576777879"
+  "8081828384858687888990919293949596979899";
+
+static const Ulong conv_pow10[20] = {
+  1ul, 10ul, 100ul, 1000ul, 10000ul, 100000ul, 1000000ul, 10000000ul, 100000000ul, 1000000000ul,
+  10000000000ul, 100000000000ul, 1000000000000ul, 10000000000000ul, 100000000000000ul,
+  1000000000000000ul, 10000000000000000ul, 100000000000000000ul, 1000000000000000000ul,
+  10000000000000000000ul
+};
+
+/* The bit width times log10(2), as 1233 / 4096, is the digit count or one less. */
+Uint conv_digits(Ulong value) noexcept {
+  Uint guess = (((64 - __builtin_clzl(value | 1)) * 1233) >> 12);
+  return (guess + ((value | 1) >= conv_pow10[guess]));
+}
+
+Uint conv_u64(Ulong value, char *buf) noexcept {
+  Uint  len = conv_digits(value);
+  char *p   = (buf + len);
+  while (value >= 100) {
+    p -= 2;
+    memcpy(p, &conv_pairs[(value % 100) * 2], 2);
+    value /= 100;
+  }
+  if (value >= 10) {
+    memcpy((p - 2), &conv_pairs[value * 2], 2);
+  }
+  else {
+    *(p - 1) = ('0' + value);
+  }
+  return len;
+}
+
+Uint conv_i64(long value, char *buf) noexcept {
+  if (value < 0) {
+    *buf = '-';
+    /* Negate unsigned, so 'LONG_MIN' works as well. */
+    return (conv_u64((0ul - (Ulong)value), (buf + 1)) + 1);
+  }
+  return conv_u64(value, buf);
+}
+
+/* Both of these are ryu in libstdc++, shortest round trip and exact fixed precision. */
+Uint conv_f64(double value, char *buf) noexcept {
+  return (std::to_chars(buf, (buf + CONV_F64_MAX), value).ptr - buf);
+}
+
+Uint conv_f64_fixed(double value, int precision, char *buf, Ulong size) noexcept {
+  std::to_chars_result result = std::to_chars(buf, (buf + size), value, std::chars_format::fixed, precision);
+  if (result.ec != std::errc {}) {
+    return 0;
+  }
+  return (result.ptr - buf);
+}
+
+/* ---------------------------------------------------------- Parse ---------------------------------------------------------- */
+
+#define CONV_ONES   0x0101010101010101ul
+#define CONV_PAGE   4096ul
+
+/* Whether all eight bytes of 'word' are '0' to '9'.  Each byte must have a high nibble of three,
+ * and still have it after adding six, which carries out of every byte above '9'. */
+__inline__ static bool __attribute((__always_inline__)) conv_eight_digits(Ulong word) {
+  return (((word & (0xF0 * CONV_ONES)) | (((word + (0x06 * CONV_ONES)) & (0xF0 * CONV_ONES)) >> 4)) == (0x33 * CONV_ONES));
+}
+
+/* The value of eight digits in one word, first digit in the lowest byte.  Adjacent digits are
+ * folded into pairs, then pairs into fours and fours into the eight with two multiplies. */
+__inline__ static Ulong __attribute((__always_inline__)) conv_eight_value(Ulong word) {
+  const Ulong mask = 0x000000FF000000FFul;
+  const Ulong mul1 = (100 + (1000000ul << 32));
+  const Ulong mul2 = (1 + (10000ul << 32));
+  word -= (0x30 * CONV_ONES);
+  word  = ((word * 10) + (word >> 8));
+  return ((((word & mask) * mul1) + (((word >> 16) & mask) * mul2)) >> 32);
+}
+
+/* Whether eight bytes can be loaded at 'i'.  Without a length only loads that stay on the page of
+ * 'str + i' are safe, the digits end somewhere on that page or the terminator is further on. */
+__inline__ static bool __attribute((__always_inline__)) conv_can_load(const char *str, Ulong i, Ulong len) {
+  if (len == CONV_TERMINATED) {
+    return ((((Ulong)(str + i)) % CONV_PAGE) <= (CONV_PAGE - 8));
+  }
+  return ((len - i) >= 8);
+}
+
+/* Eight bytes at 'p', which may pass the end of the string when it is terminated.  That stays on
+ * the page, but AddressSanitizer would report it, so this load is not instrumented.  Compilers do
+ * not inline it into instrumented code, without sanitizers it inlines as usual. */
+typedef Ulong __attribute((__may_alias__, __aligned__(1))) conv_word_t;
+
+static Ulong __attribute((__no_sanitize__("address", "hwaddress"))) conv_load(const char *p) {
+  return *(const conv_word_t *)p;
+}
+
+bool conv_parse_u64(const char *str, Ulong len, Ulong *out, Ulong *used) noexcept {
+  Ulong value    = 0;
+  Ulong i        = 0;
+  bool  overflow = false;
+  while (true) {
+    if (conv_can_load(str, i, len)) {
+      Ulong word = conv_load(str + i);
+      if (conv_eight_digits(word)) {
+        overflow |= __builtin_mul_overflow(value, 100000000ul, &value);
+        overflow |= __builtin_add_overflow(value, conv_eight_value(word), &value);
+        i += 8;
+        continue;
+      }
+    }
+    /* Less then eight digits left. */
+    if (i == len || str[i] < '0' || str[i] > '9') {
+      break;
+    }
+    overflow |= __builtin_mul_overflow(value, 10ul, &value);
+    overflow |= __builtin_add_overflow(value, (Ulong)(str[i] - '0'), &value);
+    ++i;
+  }
+  if (used) {
+    *used = i;
+  }
+  if (!i || overflow) {
+    return false;
+  }
+  *out = value;
+  return true;
+}
+
+bool conv_parse_i64(const char *str, Ulong len, long *out, Ulong *used) noexcept {
+  Ulong sign = (len && (*str == '-' || *str == '+'));
+  Ulong digits;
+  Ulong value;
+  bool  ok = conv_parse_u64((str + sign), ((len == CONV_TERMINATED) ? len : (len - sign)), &value, &digits);
+  if (used) {
+    *used = (digits ? (digits + sign) : 0);
+  }
+  if (!ok) {
+    return false;
+  }
+  if (*str == '-') {
+    if (value > (1ul << 63)) {
+      return false;
+    }
+    *out = (long)(0ul - value);
+  }
+  else {
+    if (value > (Ulong)s64_MAX) {
+      return false;
+    }
+    *out = value;
+  }
+  return true;
+}
+
+bool conv_parse_f64(const char *str, Ulong len, double *out, Ulong *used) noexcept {
+  double                 value;
+  std::from_chars_result result = std::from_chars(str, (str + len), value);
+  if (used) {
+    *used = (result.ptr - str);
+  }
+  if (result.ec != std::errc {}) {
+    return false;
+  }
+  *out = value;
+  return true;
+}
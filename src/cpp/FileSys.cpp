@@ -115,9 +115,9 @@ namespace Mlib ::FileSys {
     }
     if (!fs::create_directories(path)) {
       if ((mode & MKDIR_RECURSIVE) == true) {
-        string         recursivePath = "";
-        vector<string> dirs          = Args::strVecFromStr(path, '/');
-        for (const string &dir : dirs) {
+        string              recursivePath = "";
+        vector<string_view> dirs          = Args::strViewVecFromStr(path, '/');
+        for (string_view dir : dirs) {
           recursivePath += dir;
           if (!fs::exists(recursivePath)) {
             if (!fs::create_directory(recursivePath)) {
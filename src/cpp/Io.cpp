@@ -6,6 +6,9 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 namespace Mlib::Io {
@@ -49,29 +52,98 @@ namespace Mlib::Io {
 
 }
 
+/* Map the file at 'path' and count its lines, a last line without a newline still counts.
+ * Return`s false on failure, an empty file gives an empty 'text' that must not be unmapped. */
+static bool map_file_lines(const char *path, const char **text, Ulong *size, Ulong *count) {
+  int fd;
+  struct stat st;
+  if ((fd = open(path, O_RDONLY)) < 0) {
+    nerr("open");
+    return false;
+  }
+  if (fstat(fd, &st) < 0) {
+    nerr("fstat");
+    close(fd);
+    return false;
+  }
+  *size = st.st_size;
+  *text = "";
+  if (*size && (*text = (const char *)mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED) {
+    nerr("mmap");
+    close(fd);
+    return false;
+  }
+  close(fd);
+  *count = 0;
+  for (const char *p = *text, *end = (*text + *size); (p = (const char *)memchr(p, '\n', (end - p))); ++p) {
+    ++*count;
+  }
+  if (*size && (*text)[*size - 1] != '\n') {
+    ++*count;
+  }
+  return true;
+}
+
+/* Every line is its own allocation, as callers have always freed them one by one. */
 char **get_file_lines(const char *path) {
-  Ulong size, len, i, cap;
-  char         *buf, *line, **lines;
-  FILE         *f;
-  if ((f = fopen(path, "rb")) == NULL) {
-    nerr("fopen");
+  const char *text;
+  Ulong       size;
+  Ulong       count;
+  if (!map_file_lines(path, &text, &size, &count)) {
     return NULL;
   }
-  i = 0, cap = 10;
-  lines = (char **)malloc(sizeof(char *) * cap);
-  while ((len = getline(&buf, &size, f)) != EOF) {
-    if (i == cap) {
-      cap *= 2;
-      lines = (char **)realloc(lines, sizeof(char *) * cap);
+  char **lines = (char **)malloc(sizeof(char *) * (count + 1));
+  if (lines) {
+    const char *p   = text;
+    const char *end = (text + size);
+    for (Ulong i = 0; i < count; ++i) {
+      const char *nl  = (const char *)memchr(p, '\n', (end - p));
+      Ulong       len = ((nl ? nl : end) - p);
+      if (!(lines[i] = (char *)malloc(len + 1))) {
+        while (i) {
+          free(lines[--i]);
+        }
+        free(lines);
+        lines = NULL;
+        break;
+      }
+      memcpy(lines[i], p, len);
+      lines[i][len] = '\0';
+      p += (len + 1);
+    }
+    if (lines) {
+      lines[count] = NULL;
     }
-    if (buf[len - 1] == '\n') {
-      buf[--len] = '\0';
+  }
+  if (size) {
+    munmap((void *)text, size);
+  }
+  return lines;
+}
+
+/* The pointer array and the text share one allocation, release it with a single 'free()'. */
+char **get_file_lines_block(const char *path) {
+  const char *text;
+  Ulong       size;
+  Ulong       count;
+  if (!map_file_lines(path, &text, &size, &count)) {
+    return NULL;
+  }
+  char **lines = (char **)malloc((sizeof(char *) * (count + 1)) + size + 1);
+  if (lines) {
+    char *buf = (char *)(lines + count + 1);
+    memcpy(buf, text, size);
+    buf[size] = '\0';
+    for (Ulong i = 0; i < count; ++i) {
+      lines[i] = buf;
+      if ((buf = (char *)memchr(buf, '\n', ((char *)(lines + count + 1) + size - buf)))) {
+        *buf++ = '\0';
+      }
     }
-    line = (char *)malloc(len);
-    strcpy(line, buf);
-    lines[i++] = line;
+    lines[count] = NULL;
+  }
+  if (size) {
+    munmap((void *)text, size);
   }
-  lines[i] = NULL;
-  fclose(f);
   return lines;
 }
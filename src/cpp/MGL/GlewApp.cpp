@@ -1,6 +1,10 @@
 #include "../../include/MGL/MGL.h"
 // #include "def.h"
 #include "../../include/openGL/shader.h"
+#include "../../include/Mem_resource.h"
+#include "../../include/Utf8.h"
+
+#include <cstring>
 
 __glewApp *__glewApp::_instance = nullptr;
 
@@ -21,6 +25,7 @@ void __glewApp::_delete_data(void) {
 }
 
 void __glewApp::_register_element(Element *e) {
+  e->handle = element_slots.insert(e);
   elements[e->name] = e;
 }
 
@@ -222,24 +227,24 @@ bool __glewApp::_put_element_over(Element *e_under, Element *e_over) {
 }
 
 void __glewApp::_remove_element(const std::string &name) {
-  Element *e = get_element(name);
-  if (name == "root" || !e) {
+  _remove_element(get_element(name));
+}
+
+void __glewApp::_remove_element(Element *e) {
+  if (!e || e->name == "root") {
     return;
   }
   /* Recursive deletion of children */
   for (Element *child : e->children) {
-    _remove_element(child->name);
+    _remove_element(child);
   }
   /* Remove from grid map and element data */
   grid_map->remove(e);
-  elements.erase(name);
+  elements.erase(e->name);
+  element_slots.remove(e->handle);
   element_vec.erase(e);
   /* Remove related animation data */
-  for (Uint i = 0; i < animation_data.size(); ++i) {
-    if (animation_data[i].first == e) {
-      animation_data.erase_at(i--);
-    }
-  }
+  animation_data.erase_if([e](const auto &it) { return it.first == e; });
   /* Delete the element itself */
   delete e;
 }
@@ -251,7 +256,7 @@ Element *__glewApp::_root(void) {
 __glewApp *__glewApp::instance(void) {
   if (!_instance) {
     _instance = new __glewApp();
-    _instance->grid_map = new GridMap(20);
+    _instance->grid_map = new GridMap(20, slab_resource());
     _instance->_frame_timer = new FrameTimer();
     atexit(_destroy);
   }
@@ -333,7 +338,13 @@ DropDownMenu *__glewApp::new_dropdown_menu(const std::string &parent, const std:
 }
 
 Element *__glewApp::get_element(const std::string &name) {
-  return elements.count(name) ? elements[name] : nullptr;
+  auto it = elements.find(name);
+  return (it != elements.end()) ? it->second : nullptr;
+}
+
+Element *__glewApp::get_element(slot_handle_t handle) {
+  Element **e = element_slots.get(handle);
+  return e ? *e : nullptr;
 }
 
 Element *__glewApp::get_element_from_mouse(void) {
@@ -382,23 +393,25 @@ void __glewApp::animate_element(Element *e, const vec2 &end_pos, const vec2 &end
 }
 
 void __glewApp::render_text(std::string text, vec2 pos, float scale, vec3 color) {
-  if (flag.is_set<GLAPP_HAS_ACTIVE_FONT>()) {
-    /* Activate the font shader. */
-    glUseProgram(_fontshader);
-    glUniform3f(glGetUniformLocation(_fontshader, "textColor"), color.x, color.y, color.z);
-    glActiveTexture(GL_TEXTURE0);
-    glBindVertexArray(_fontVAO);
-    /* Iterate through all characters. */
-    std::string::const_iterator c;
-    for (c = text.begin(); c != text.end(); ++c) {
-      Character ch = _font.characters[*c];
+  if (flag.is_set<GLAPP_HAS_ACTIVE_FONT>() && !text.empty()) {
+    /* Build the quads for the whole string in frame scratch memory, so the VBO is updated once per string. */
+    typedef float glyph_quad_t[6][4];
+    char32_t     *codepoints = frame_alloc.alloc_array<char32_t>(text.size());
+    glyph_quad_t *vertices   = frame_alloc.alloc_array<glyph_quad_t>(text.size());
+    Uint         *textures   = frame_alloc.alloc_array<Uint>(text.size());
+    if (!codepoints || !vertices || !textures) {
+      return;
+    }
+    /* One quad per codepoint, the font only has glyphs for ascii so anything else is drawn as '?'. */
+    Ulong count = utf8_to_utf32(text.data(), text.size(), codepoints);
+    for (Ulong i = 0; i < count; ++i) {
+      Character &ch = _font.characters[(codepoints[i] < 128) ? (char)codepoints[i] : '?'];
       /* Define parameters for glyph. */
       float xpos = (pos.x + ch.Bearing.x * scale);
       float ypos = (pos.y + (ch.Size.y - ch.Bearing.y) * scale);
       float w = (ch.Size.x * scale);
       float h = (ch.Size.y * scale);
-      /* Update VBO for each character. */
-      float vertices[6][4] = {
+      const glyph_quad_t quad = {
         /* Vertices data. */
         {  xpos,      (ypos - h),  0.0f, 0.0f },
         {  xpos,       ypos,       0.0f, 1.0f },
@@ -408,17 +421,25 @@ void __glewApp::render_text(std::string text, vec2 pos, float scale, vec3 color)
         { (xpos + w),  ypos,       1.0f, 1.0f },
         { (xpos + w), (ypos - h),  1.0f, 0.0f }  
       };
-      /* render glyph texture over quad */
-      glBindTexture(GL_TEXTURE_2D, ch.textureID);
-      /* Update content of VBO memory. */
-      glBindBuffer(GL_ARRAY_BUFFER, _fontVBO);
-      glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices); 
-      glBindBuffer(GL_ARRAY_BUFFER, 0);
-      /* Render quad. */
-      glDrawArrays(GL_TRIANGLES, 0, 6);
+      memcpy(vertices[i], quad, sizeof(glyph_quad_t));
+      textures[i] = ch.textureID;
       /* Now advance cursors for next glyph (note that advance is number of 1/64 pixels). */
       pos.x += ((ch.Advance >> 6) * scale); /* Bitshift by 6 to get value in pixels (2^6 = 64) */
     }
+    /* Activate the font shader. */
+    glUseProgram(_fontshader);
+    glUniform3f(glGetUniformLocation(_fontshader, "textColor"), color.x, color.y, color.z);
+    glActiveTexture(GL_TEXTURE0);
+    glBindVertexArray(_fontVAO);
+    /* Upload every quad at once, this orphans the old storage so we never wait on the previous draw. */
+    glBindBuffer(GL_ARRAY_BUFFER, _fontVBO);
+    glBufferData(GL_ARRAY_BUFFER, (sizeof(glyph_quad_t) * count), vertices, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    for (Ulong i = 0; i < count; ++i) {
+      /* render glyph texture over quad */
+      glBindTexture(GL_TEXTURE_2D, textures[i]);
+      glDrawArrays(GL_TRIANGLES, (i * 6), 6);
+    }
     glBindVertexArray(0);
     glBindTexture(GL_TEXTURE_2D, 0);
   }
@@ -473,7 +494,7 @@ void __glewApp::draw(void) {
         }
       }
       if (element_vec[i]->flag.is_set<DELETE_ELEMENT>()) {
-        _remove_element(element_vec[i--]->name);
+        _remove_element(element_vec[i--]);
         continue;
       }
       Element *mouse_element = get_element_from_mouse();
@@ -521,6 +542,7 @@ void __glewApp::run(void) {
   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
   while (!glfwWindowShouldClose(win) && flag.is_set<GL_APP_RUNNING>()) {
     _frame_timer->start();
+    frame_alloc.next_frame();
     glClear(GL_COLOR_BUFFER_BIT);
     draw();
     if (flag.is_set<GL_HAS_MAIN_LOOP_LAMBDA>()) {
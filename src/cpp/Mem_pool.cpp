@@ -0,0 +1,64 @@
+#include "../include/Mem_pool.h"
+
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static Ulong mem_pool_round_up(Ulong size, Ulong to) noexcept {
+  return ((size + to - 1) & ~(to - 1));
+}
+
+mem_pool_chunk_t *mem_pool_map_chunk(Ulong size, Uint flags) noexcept {
+  const Ulong page_size   = (Ulong)sysconf(_SC_PAGESIZE);
+  const Ulong granularity = (flags & MEM_POOL_HUGEPAGE) ? MEM_POOL_HUGEPAGE_SIZE : page_size;
+  const Ulong len         = mem_pool_round_up((size + sizeof(mem_pool_chunk_t)), granularity);
+  int         map_flags   = (MAP_PRIVATE | MAP_ANONYMOUS);
+  /* Huge pages need a 2MB aligned range, so we over-map and trim.  Populating is then
+   * done after 'madvise', otherwise the pages would be faulted in as normal pages. */
+  Ulong map_len = len;
+  if (flags & MEM_POOL_HUGEPAGE) {
+    map_len += granularity;
+  }
+  else if (flags & MEM_POOL_POPULATE) {
+    map_flags |= MAP_POPULATE;
+  }
+  char *map = (char *)mmap(nullptr, map_len, (PROT_READ | PROT_WRITE), map_flags, -1, 0);
+  if (map == MAP_FAILED) {
+    logE("mmap of %lu bytes failed: %s.", map_len, strerror(errno));
+    return nullptr;
+  }
+  char *base = map;
+  if (flags & MEM_POOL_HUGEPAGE) {
+    base       = (char *)mem_pool_round_up((Ulong)map, granularity);
+    Ulong head = (Ulong)(base - map);
+    Ulong tail = (map_len - head - len);
+    if (head) {
+      munmap(map, head);
+    }
+    if (tail) {
+      munmap((base + len), tail);
+    }
+#ifdef MADV_HUGEPAGE
+    madvise(base, len, MADV_HUGEPAGE);
+#endif
+    if (flags & MEM_POOL_POPULATE) {
+#ifdef MADV_POPULATE_WRITE
+      if (madvise(base, len, MADV_POPULATE_WRITE) != 0)
+#endif
+      {
+        for (Ulong i = 0; i < len; i += page_size) {
+          ((volatile char *)base)[i] = 0;
+        }
+      }
+    }
+  }
+  mem_pool_chunk_t *chunk = (mem_pool_chunk_t *)base;
+  chunk->next             = nullptr;
+  chunk->size             = len;
+  return chunk;
+}
+
+void mem_pool_unmap_chunk(mem_pool_chunk_t *chunk) noexcept {
+  munmap(chunk, chunk->size);
+}
@@ -0,0 +1,35 @@
+#include "../include/Mem_resource.h"
+
+void *slab_resource_t::do_allocate(Ulong bytes, Ulong alignment) {
+  void *ptr;
+  if (alignment <= 16) {
+    ptr = slab_alloc(bytes);
+  }
+  else {
+    ptr = ::operator new(bytes, std::align_val_t(alignment), std::nothrow);
+  }
+  if (!ptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void slab_resource_t::do_deallocate(void *ptr, Ulong bytes, Ulong alignment) {
+  if (alignment <= 16) {
+    slab_free(ptr, bytes);
+  }
+  else {
+    ::operator delete(ptr, std::align_val_t(alignment));
+  }
+}
+
+bool slab_resource_t::do_is_equal(const std::pmr::memory_resource &other) const noexcept {
+  /* Every instance draws from the same shared pools. */
+  return (dynamic_cast<const slab_resource_t *>(&other) != nullptr);
+}
+
+std::pmr::memory_resource *slab_resource(void) noexcept {
+  alignas(slab_resource_t) static char storage[sizeof(slab_resource_t)];
+  static slab_resource_t *resource = new (storage) slab_resource_t();
+  return resource;
+}
@@ -0,0 +1,201 @@
+#include "../include/Obj_pool.h"
+
+#include <atomic>
+#include <cstdlib>
+
+fixed_pool_t::fixed_pool_t(Ulong obj_size, Ulong chunk_size, Uint flags) noexcept
+    : _free(nullptr)
+    , _cursor(nullptr)
+    , _end(nullptr)
+    , _chunks(nullptr)
+    , _obj_size((obj_size + 15) & ~15UL)
+    , _chunk_size(chunk_size)
+    , _flags(flags & (MEM_POOL_HUGEPAGE | MEM_POOL_POPULATE)) {
+  if (_chunk_size < _obj_size) {
+    _chunk_size = _obj_size;
+  }
+}
+
+fixed_pool_t::~fixed_pool_t(void) noexcept {
+  while (_chunks) {
+    mem_pool_chunk_t *next = _chunks->next;
+    mem_pool_unmap_chunk(_chunks);
+    _chunks = next;
+  }
+}
+
+void *fixed_pool_t::_grow(void) noexcept {
+  mem_pool_chunk_t *chunk = mem_pool_map_chunk(_chunk_size, _flags);
+  if (!chunk) {
+    logE("fixed_pool_t failed to map a new chunk.");
+    return nullptr;
+  }
+  chunk->next = _chunks;
+  _chunks     = chunk;
+  /* The chunk header is 16 bytes, so the first object stays 16 byte aligned. */
+  _cursor   = ((char *)chunk + sizeof(mem_pool_chunk_t));
+  _end      = ((char *)chunk + chunk->size);
+  void *ptr = _cursor;
+  _cursor += _obj_size;
+  return ptr;
+}
+
+Ulong fixed_pool_t::alloc_batch(void **first, Ulong count) noexcept {
+  node_t *head = nullptr;
+  Ulong   i    = 0;
+  for (; i < count; ++i) {
+    node_t *node = (node_t *)alloc();
+    if (!node) {
+      break;
+    }
+    node->next = head;
+    head       = node;
+  }
+  *first = head;
+  return i;
+}
+
+void fixed_pool_t::free_batch(void *first, void *last) noexcept {
+  ((node_t *)last)->next = _free;
+  _free                  = (node_t *)first;
+}
+
+/* ---------------------------------------------------------- Size classes ---------------------------------------------------------- */
+
+static constexpr Ulong slab_class_size[SLAB_CLASS_COUNT] = {
+  16, 32, 48, 64, 80, 96, 112, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048, 3072, SLAB_MAX_SIZE,
+};
+
+/* Class index for sizes above 128, indexed by '(size - 1) >> 6'.  Every class above 128 is a
+ * multiple of 64, so each bucket maps to the smallest class that fits all of it. */
+struct slab_class_table_t {
+  Uchar index[SLAB_MAX_SIZE / 64];
+};
+
+static constexpr slab_class_table_t slab_large_class = [] {
+  slab_class_table_t table {};
+  Ulong              c = 8;
+  for (Ulong i = 2; i < (SLAB_MAX_SIZE / 64); ++i) {
+    while (slab_class_size[c] < ((i + 1) * 64)) {
+      ++c;
+    }
+    table.index[i] = (Uchar)c;
+  }
+  return table;
+}();
+
+static __inline__ Ulong slab_class_of(Ulong size) noexcept {
+  if (size <= 128) {
+    return (size ? ((size + 15) >> 4) - 1 : 0);
+  }
+  return slab_large_class.index[(size - 1) >> 6];
+}
+
+/* ---------------------------------------------------------- Shared pools ---------------------------------------------------------- */
+
+struct slab_central_t {
+  std::atomic_flag lock = ATOMIC_FLAG_INIT;
+  fixed_pool_t     pool;
+
+  explicit slab_central_t(Ulong size) noexcept : pool(size) {
+  }
+
+  __inline__ void acquire(void) noexcept {
+    while (lock.test_and_set(std::memory_order_acquire)) {
+      __builtin_ia32_pause();
+    }
+  }
+
+  __inline__ void release(void) noexcept {
+    lock.clear(std::memory_order_release);
+  }
+};
+
+/* The shared pools are never destroyed, thread caches can still flush into them during exit. */
+static slab_central_t *slab_central(void) noexcept {
+  alignas(slab_central_t) static char storage[SLAB_CLASS_COUNT][sizeof(slab_central_t)];
+  static slab_central_t *central = [] {
+    for (Ulong i = 0; i < SLAB_CLASS_COUNT; ++i) {
+      new (storage[i]) slab_central_t(slab_class_size[i]);
+    }
+    return (slab_central_t *)storage;
+  }();
+  return central;
+}
+
+/* ---------------------------------------------------------- Thread caches ---------------------------------------------------------- */
+
+struct slab_cache_t {
+  void *head[SLAB_CLASS_COUNT] {};
+  Uint  count[SLAB_CLASS_COUNT] {};
+
+  /* Hand everything back to the shared pools when the thread exits. */
+  ~slab_cache_t(void) noexcept {
+    slab_central_t *central = slab_central();
+    for (Ulong c = 0; c < SLAB_CLASS_COUNT; ++c) {
+      if (!head[c]) {
+        continue;
+      }
+      void *last = head[c];
+      while (*(void **)last) {
+        last = *(void **)last;
+      }
+      central[c].acquire();
+      central[c].pool.free_batch(head[c], last);
+      central[c].release();
+      head[c]  = nullptr;
+      count[c] = 0;
+    }
+  }
+};
+
+static thread_local slab_cache_t slab_cache;
+
+void *slab_alloc(Ulong size) noexcept {
+  if (size > SLAB_MAX_SIZE) {
+    return malloc(size);
+  }
+  Ulong c = slab_class_of(size);
+  if (!slab_cache.head[c]) [[unlikely]] {
+    slab_central_t *central = slab_central();
+    central[c].acquire();
+    slab_cache.count[c] = (Uint)central[c].pool.alloc_batch(&slab_cache.head[c], SLAB_BATCH);
+    central[c].release();
+    if (!slab_cache.head[c]) {
+      logE("slab_alloc failed to refill size class %lu.", slab_class_size[c]);
+      return nullptr;
+    }
+  }
+  void *ptr           = slab_cache.head[c];
+  slab_cache.head[c]  = *(void **)ptr;
+  --slab_cache.count[c];
+  return ptr;
+}
+
+void slab_free(void *ptr, Ulong size) noexcept {
+  if (!ptr) {
+    return;
+  }
+  if (size > SLAB_MAX_SIZE) {
+    free(ptr);
+    return;
+  }
+  Ulong c             = slab_class_of(size);
+  *(void **)ptr       = slab_cache.head[c];
+  slab_cache.head[c]  = ptr;
+  if (++slab_cache.count[c] < (SLAB_BATCH * 2)) [[likely]] {
+    return;
+  }
+  /* The cache is full, move the most recently freed batch back to the shared pool. */
+  void *first = slab_cache.head[c];
+  void *last  = first;
+  for (Ulong i = 1; i < SLAB_BATCH; ++i) {
+    last = *(void **)last;
+  }
+  slab_cache.head[c] = *(void **)last;
+  slab_cache.count[c] -= SLAB_BATCH;
+  slab_central_t *central = slab_central();
+  central[c].acquire();
+  central[c].pool.free_batch(first, last);
+  central[c].release();
+}
@@ -3,6 +3,7 @@
 #include "../include/Compress.h"
 #include "../include/Error.h"
 #include "../include/Socket.h"
+#include "../include/String.h"
 #include "../include/def.h"
 
 using namespace Mlib;
@@ -59,8 +60,8 @@ packy *packy::Instance(void)
 char *packy::find_package(const char *package, unsigned repo_mask, unsigned *repo_index)
 {
     int           i = 0;
-    unsigned long package_len, ext_len;
-    const char   *found, *ext, *end;
+    unsigned long package_len, ext_len, size;
+    const char   *data, *found, *ext, *end;
     static char   full_package_name[PATH_MAX];
     ext         = ".pkg.tar.zst";
     package_len = strlen(package);
@@ -71,16 +72,18 @@ char *packy::find_package(const char *package, unsigned repo_mask, unsigned *rep
         {
             continue;
         }
-        if ((found = ssl_retrieve_url_data(&Entry.value[0])) == nullptr)
+        if ((data = ssl_retrieve_url_data(&Entry.value[0], &size)) == nullptr)
         {
             prog_err("ssl_retrieve_url_data", "Failed to get data from: ['%s']", &Entry.value[0]);
             return nullptr;
         }
-        while ((found = strstr(found, package)) != nullptr)
+        /* The index pages are large, search them by length instead of rescanning for the nul. */
+        found = data;
+        while ((found = mstrmem(found, (size - (found - data)), package, package_len)) != nullptr)
         {
-            if (*(found - 1) == '"')
+            if (found > data && *(found - 1) == '"')
             {
-                if ((end = strstr(found, ext)) != nullptr)
+                if ((end = mstrmem(found, (size - (found - data)), ext, ext_len)) != nullptr)
                 {
                     end += ext_len;
                     memmove(full_package_name, found, end - found);
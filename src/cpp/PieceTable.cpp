@@ -0,0 +1,406 @@
+#include "../include/PieceTable.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MPieceTable::MPieceTable(void) noexcept
+    : _orig(nullptr)
+    , _orig_len(0)
+    , _root(PIECE_NONE)
+    , _free(PIECE_NONE)
+    , _seed(0x9E3779B9u) {
+}
+
+MPieceTable::~MPieceTable(void) noexcept {
+  _reset();
+}
+
+void MPieceTable::_reset(void) noexcept {
+  if (_orig) {
+    munmap((void *)_orig, _orig_len);
+  }
+  _orig     = nullptr;
+  _orig_len = 0;
+  _add.clear();
+  _nl[ORIGINAL].clear();
+  _nl[ADDED].clear();
+  _nodes.clear();
+  _root = PIECE_NONE;
+  _free = PIECE_NONE;
+}
+
+Ulong MPieceTable::_nl_rank(Uchar buf, Ulong pos) const noexcept {
+  return (std::lower_bound(_nl[buf].begin(), _nl[buf].end(), pos) - _nl[buf].begin());
+}
+
+Uint MPieceTable::_count_nl(Uchar buf, Ulong start, Ulong len) const noexcept {
+  return (_nl_rank(buf, (start + len)) - _nl_rank(buf, start));
+}
+
+Uint MPieceTable::_new_node(Uchar buf, Ulong start, Ulong len) noexcept {
+  Uint n;
+  if (_free != PIECE_NONE) {
+    n     = _free;
+    _free = _nodes[n].right;
+  }
+  else {
+    n = _nodes.size();
+    _nodes.push_back({});
+  }
+  /* Xorshift, the priorities only need to be well spread, not unpredictable. */
+  _seed ^= (_seed << 13);
+  _seed ^= (_seed >> 17);
+  _seed ^= (_seed << 5);
+  node_t &node = _nodes[n];
+  node.start   = start;
+  node.len     = len;
+  node.nl      = _count_nl(buf, start, len);
+  node.left    = PIECE_NONE;
+  node.right   = PIECE_NONE;
+  node.prio    = _seed;
+  node.buf     = buf;
+  _update(n);
+  return n;
+}
+
+void MPieceTable::_free_tree(Uint n) noexcept {
+  while (n != PIECE_NONE) {
+    _free_tree(_nodes[n].left);
+    Uint right      = _nodes[n].right;
+    _nodes[n].right = _free;
+    _free           = n;
+    n               = right;
+  }
+}
+
+Uint MPieceTable::_merge(Uint l, Uint r) noexcept {
+  if (l == PIECE_NONE) {
+    return r;
+  }
+  else if (r == PIECE_NONE) {
+    return l;
+  }
+  if (_nodes[l].prio > _nodes[r].prio) {
+    Uint right      = _merge(_nodes[l].right, r);
+    _nodes[l].right = right;
+    _update(l);
+    return l;
+  }
+  Uint left      = _merge(l, _nodes[r].left);
+  _nodes[r].left = left;
+  _update(r);
+  return r;
+}
+
+/* Split 'n' so that 'l' holds the first 'offset' bytes and 'r' the rest.  A piece that straddles
+ * 'offset' is cut in two, nothing is copied. */
+void MPieceTable::_split(Uint n, Ulong offset, Uint &l, Uint &r) noexcept {
+  if (n == PIECE_NONE) {
+    l = PIECE_NONE;
+    r = PIECE_NONE;
+    return;
+  }
+  Uint  a, b;
+  Ulong llen = _sub_len(_nodes[n].left);
+  Ulong len  = _nodes[n].len;
+  if (offset <= llen) {
+    _split(_nodes[n].left, offset, a, b);
+    _nodes[n].left = b;
+    _update(n);
+    l = a;
+    r = n;
+  }
+  else if (offset >= (llen + len)) {
+    _split(_nodes[n].right, (offset - llen - len), a, b);
+    _nodes[n].right = a;
+    _update(n);
+    l = n;
+    r = b;
+  }
+  else {
+    Ulong inner = (offset - llen);
+    Uchar buf   = _nodes[n].buf;
+    Ulong start = _nodes[n].start;
+    /* May grow '_nodes', so no reference into it is held across this. */
+    Uint tail = _new_node(buf, (start + inner), (len - inner));
+    Uint right      = _nodes[n].right;
+    _nodes[n].len   = inner;
+    _nodes[n].nl    = _count_nl(buf, start, inner);
+    _nodes[n].right = PIECE_NONE;
+    _update(n);
+    l = n;
+    r = _merge(tail, right);
+  }
+}
+
+/* Grow the last piece of 'n' in place when it ends right where the new text was appended, so
+ * typing a run of characters keeps a single piece instead of one per keystroke. */
+bool MPieceTable::_extend_last(Uint n, Ulong start, Ulong len, Uint nl) noexcept {
+  if (n == PIECE_NONE) {
+    return false;
+  }
+  else if (_nodes[n].right != PIECE_NONE) {
+    if (_extend_last(_nodes[n].right, start, len, nl)) {
+      _update(n);
+      return true;
+    }
+    return false;
+  }
+  node_t &node = _nodes[n];
+  if (node.buf != ADDED || (node.start + node.len) != start) {
+    return false;
+  }
+  node.len += len;
+  node.nl  += nl;
+  _update(n);
+  return true;
+}
+
+Ulong MPieceTable::_copy(Uint n, Ulong offset, Ulong len, char *out) const noexcept {
+  Ulong copied = 0;
+  while (n != PIECE_NONE && len) {
+    const node_t &node = _nodes[n];
+    Ulong llen = _sub_len(node.left);
+    if (offset < llen) {
+      Ulong got = _copy(node.left, offset, len, out);
+      copied += got;
+      out    += got;
+      len    -= got;
+      offset  = 0;
+    }
+    else {
+      offset -= llen;
+    }
+    if (offset < node.len) {
+      Ulong take = std::min((node.len - offset), len);
+      memcpy(out, (_buf(node.buf) + node.start + offset), take);
+      copied += take;
+      out    += take;
+      len    -= take;
+      offset  = 0;
+    }
+    else {
+      offset -= node.len;
+    }
+    n = node.right;
+  }
+  return copied;
+}
+
+bool MPieceTable::load(const char *path) noexcept {
+  _reset();
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    logE("Failed to open '%s': %s.", path, strerror(errno));
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) < 0) {
+    logE("Failed to stat '%s': %s.", path, strerror(errno));
+    close(fd);
+    return false;
+  }
+  /* An empty file can not be mapped, and needs no piece anyway. */
+  if (st.st_size > 0) {
+    void *map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+      logE("Failed to map '%s': %s.", path, strerror(errno));
+      close(fd);
+      return false;
+    }
+    madvise(map, st.st_size, MADV_SEQUENTIAL);
+    _orig     = (const char *)map;
+    _orig_len = st.st_size;
+    for (const char *p = _orig, *end = (_orig + _orig_len); (p = (const char *)memchr(p, '\n', (end - p))); ++p) {
+      _nl[ORIGINAL].push_back(p - _orig);
+    }
+    _root = _new_node(ORIGINAL, 0, _orig_len);
+  }
+  close(fd);
+  return true;
+}
+
+void MPieceTable::assign(const char *str, Ulong len) noexcept {
+  _reset();
+  insert(0, str, len);
+}
+
+void MPieceTable::insert(Ulong offset, const char *str, Ulong len) noexcept {
+  if (!len) {
+    return;
+  }
+  offset = std::min(offset, size());
+  Ulong start = _add.size();
+  Uint  nl    = _nl[ADDED].size();
+  for (const char *p = str, *end = (str + len); (p = (const char *)memchr(p, '\n', (end - p))); ++p) {
+    _nl[ADDED].push_back(start + (p - str));
+  }
+  nl = (_nl[ADDED].size() - nl);
+  _add.append(str, len);
+  Uint l, r;
+  _split(_root, offset, l, r);
+  if (!_extend_last(l, start, len, nl)) {
+    l = _merge(l, _new_node(ADDED, start, len));
+  }
+  _root = _merge(l, r);
+}
+
+void MPieceTable::erase(Ulong offset, Ulong len) noexcept {
+  if (offset >= size() || !len) {
+    return;
+  }
+  Uint l, mid, r;
+  _split(_root, offset, l, r);
+  _split(r, len, mid, r);
+  _free_tree(mid);
+  _root = _merge(l, r);
+}
+
+Ulong MPieceTable::line_offset(Uint line) const noexcept {
+  if (!line) {
+    return 0;
+  }
+  else if (line > _sub_nl(_root)) {
+    return size();
+  }
+  Ulong acc = 0;
+  Uint  n   = _root;
+  while (n != PIECE_NONE) {
+    const node_t &node = _nodes[n];
+    Uint lnl = _sub_nl(node.left);
+    if (line <= lnl) {
+      n = node.left;
+      continue;
+    }
+    line -= lnl;
+    acc  += _sub_len(node.left);
+    if (line <= node.nl) {
+      Ulong pos = _nl[node.buf][_nl_rank(node.buf, node.start) + line - 1];
+      return (acc + (pos - node.start) + 1);
+    }
+    line -= node.nl;
+    acc  += node.len;
+    n     = node.right;
+  }
+  return size();
+}
+
+Uint MPieceTable::line_of(Ulong offset) const noexcept {
+  if (offset >= size()) {
+    return _sub_nl(_root);
+  }
+  Uint line = 0;
+  Uint n    = _root;
+  while (n != PIECE_NONE) {
+    const node_t &node = _nodes[n];
+    Ulong llen = _sub_len(node.left);
+    if (offset < llen) {
+      n = node.left;
+      continue;
+    }
+    offset -= llen;
+    line   += _sub_nl(node.left);
+    if (offset < node.len) {
+      return (line + _count_nl(node.buf, node.start, offset));
+    }
+    offset -= node.len;
+    line   += node.nl;
+    n       = node.right;
+  }
+  return line;
+}
+
+Ulong MPieceTable::line_length(Uint line) const noexcept {
+  Ulong start = line_offset(line);
+  if (line < _sub_nl(_root)) {
+    return (line_offset(line + 1) - start - 1);
+  }
+  return (size() - start);
+}
+
+char MPieceTable::at(Ulong offset) const noexcept {
+  char c = '\0';
+  _copy(_root, offset, 1, &c);
+  return c;
+}
+
+Ulong MPieceTable::copy(Ulong offset, Ulong len, char *out) const noexcept {
+  return _copy(_root, offset, len, out);
+}
+
+std::string MPieceTable::line(Uint line) const {
+  std::string ret(line_length(line), '\0');
+  _copy(_root, line_offset(line), ret.size(), ret.data());
+  return ret;
+}
+
+std::string MPieceTable::str(void) const {
+  std::string ret(size(), '\0');
+  _copy(_root, 0, ret.size(), ret.data());
+  return ret;
+}
+
+/* Written to a temporary file next to the real target that then replaces it, so saving over the
+ * file that is currently mapped never truncates the pages the original buffer still refers to.
+ * A symlink at 'path' is followed and kept, the target keeps its mode and, where permitted, its
+ * owner, and the data is on disk before the rename makes it visible. */
+bool MPieceTable::save(const char *path) const noexcept {
+  char       *real   = realpath(path, nullptr);
+  std::string target = (real ? real : path);
+  free(real);
+  std::string tmp = (target + ".XXXXXX");
+  int fd = mkstemp(tmp.data());
+  if (fd < 0) {
+    logE("Failed to create '%s': %s.", tmp.c_str(), strerror(errno));
+    return false;
+  }
+  bool ok = true;
+  for_each_piece([&](const char *data, Ulong len) {
+    while (ok && len) {
+      long wr = write(fd, data, len);
+      if (wr < 0 && errno == EINTR) {
+        continue;
+      }
+      else if (wr <= 0) {
+        logE("Failed to write '%s': %s.", tmp.c_str(), strerror(errno));
+        ok = false;
+        break;
+      }
+      data += wr;
+      len  -= wr;
+    }
+  });
+  struct stat st;
+  if (stat(target.c_str(), &st) == 0) {
+    /* Only root may give a file away, keep atleast the group when that fails. */
+    if (fchown(fd, st.st_uid, st.st_gid) < 0 && fchown(fd, (uid_t)-1, st.st_gid) < 0) {
+      logW("Could not keep the owner of '%s': %s.", target.c_str(), strerror(errno));
+    }
+    fchmod(fd, (st.st_mode & 07777));
+  }
+  else {
+    fchmod(fd, 0644);
+  }
+  if (ok && fsync(fd) < 0) {
+    logE("Failed to sync '%s': %s.", tmp.c_str(), strerror(errno));
+    ok = false;
+  }
+  if (close(fd) < 0 || !ok || rename(tmp.c_str(), target.c_str()) < 0) {
+    unlink(tmp.c_str());
+    return false;
+  }
+  /* Make the rename itself durable. */
+  std::string dir = target.substr(0, (target.rfind('/') + 1));
+  int dirfd = open((dir.empty() ? "." : dir.c_str()), (O_RDONLY | O_DIRECTORY));
+  if (dirfd >= 0) {
+    fsync(dirfd);
+    close(dirfd);
+  }
+  return true;
+}
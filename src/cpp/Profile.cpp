@@ -1,6 +1,8 @@
 /** @file Profile.cpp.  Contains the implementation of the profiling classes and functions. */
 #include "../include/Profile.h"
+#include "../include/Conv.h"
 #include "../include/def.h"
+#include "../include/Mem_resource.h"
 
 #include <algorithm>
 #include <chrono>
@@ -68,24 +70,56 @@ namespace Mlib::Profile {
     instance = nullptr;
   }
 
-  void GlobalProfiler::record(const string &name, const double duration) {
+  void GlobalProfiler::record(str_id_t name, const double duration) {
     stats[name].record(duration);
   }
 
+  void GlobalProfiler::record(string_view name, const double duration) {
+    record(str_intern(name), duration);
+  }
+
+  vector<pair<string_view, const ProfilerStats *>> GlobalProfiler::_by_name(void) const {
+    vector<pair<string_view, const ProfilerStats *>> ret;
+    ret.reserve(stats.size());
+    for (const auto &[name, stat] : stats) {
+      ret.emplace_back(str_intern_view(name), &stat);
+    }
+    std::sort(ret.begin(), ret.end(), [](const auto &a, const auto &b) {
+      return (a.first < b.first);
+    });
+    return ret;
+  }
+
   void GlobalProfiler::setOutputFile(string_view file_path) {
     output_file = file_path;
   }
  
   map<string, ProfilerStats> GlobalProfiler::getStatsCopy() const {
-    return stats;
-  }
-
-  string makeNamePadding(const string &s) {
-    std::stringstream ss;
-    for (int i = 0; (i + s.length()) < 30; ++i) {
-      ss << ' ';
+    map<string, ProfilerStats> copy;
+    for (const auto &[name, stat] : _by_name()) {
+      copy.emplace_hint(copy.end(), name, *stat);
     }
-    return ss.str();
+    return copy;
+  }
+
+  /* Append the report line of 'name' to 'out', without going through a stream or 'snprintf()'
+   * for every number.  Names are padded to 30 columns. */
+  static void append_stats_line(string &out, string_view name, const ProfilerStats *stats) {
+    static constexpr string_view labels[] = {": Mean = ", " ms, Stddev = ", " ms, Min = ", " ms, Max = "};
+    const double values[] = {stats->mean(), stats->stddev(), stats->min(), stats->max()};
+    /* Room for any double with six decimals. */
+    char num[320];
+    out.append(name);
+    if (name.size() < 30) {
+      out.append((30 - name.size()), ' ');
+    }
+    for (Ulong i = 0; i < (sizeof(values) / sizeof(*values)); ++i) {
+      out.append(labels[i]);
+      out.append(num, conv_f64_fixed(values[i], 6, num, sizeof(num)));
+    }
+    out.append(" ms, Count = ");
+    out.append(num, conv_u64(stats->count(), num));
+    out.push_back('\n');
   }
 
   string mili(void) {
@@ -113,30 +147,21 @@ namespace Mlib::Profile {
   }
 
   void GlobalProfiler ::report(void) {
+    string text = ("\n\nProfiling report: " + mili() + '\n');
+    for (const auto &[name, stats] : _by_name()) {
+      append_stats_line(text, name, stats);
+    }
+#ifdef MLIB_ALLOC_STATS
+    for (const string &line : alloc_stats_lines()) {
+      text += line;
+    }
+#endif
     if (output_file.empty()) {
-      cout << "\n\nProfiling report: " << mili() << '\n';
-      for (const auto &[first, second] : stats) {
-        cout << first << makeNamePadding(first) <<     /*  */
-          ": Mean = " << second.mean() << " ms, " <<   /* makeDoublePadding(pair.second.mean())   << */
-          "Stddev = " << second.stddev() << " ms, " << /* makeDoublePadding(pair.second.stddev()) << */
-          "   Min = " << second.min() << " ms, " <<    /* makeDoublePadding(pair.second.min())    << */
-          "   Max = " << second.max() << " ms, " <<    /* makeDoublePadding(pair.second.max())    << */
-          " Count = " << second.count() <<             /* makeDoublePadding(pair.second.count())  << */
-          "\n";
-      }
+      cout.write(text.data(), text.size());
     }
     else {
       std::ofstream file(output_file, std::ios::app);
-      file << "\n\nProfiling report: " << mili() << '\n';
-      for (const auto &pair : stats) {
-        file << pair.first << makeNamePadding(pair.first) << /*  */
-          ": Mean = " << pair.second.mean() << " ms, " <<    /* makeDoublePadding(pair.second.mean())   << */
-          "Stddev = " << pair.second.stddev() << " ms, " <<  /* makeDoublePadding(pair.second.stddev()) << */
-          "   Min = " << pair.second.min() << " ms, " <<     /* makeDoublePadding(pair.second.min())    << */
-          "   Max = " << pair.second.max() << " ms, " <<     /* makeDoublePadding(pair.second.max())    << */
-          " Count = " << pair.second.count() <<              /* makeDoublePadding(pair.second.count())  << */
-          "\n";
-      }
+      file.write(text.data(), text.size());
       file.close();
     }
   }
@@ -144,15 +169,14 @@ namespace Mlib::Profile {
   vector<string> GlobalProfiler::retrveFormatedStrVecStats(void) const {
     std::vector<std::string> formated_stats;
     formated_stats.push_back("\n\nProfiling report: " + mili() + '\n');
-    char buffer[4096];
-    for (const auto &[name, stats] : stats) {
-      snprintf(
-        buffer, sizeof(buffer),
-        "%s%s: Mean = %.6f ms, Stddev = %.6f ms, Min = %.6f ms, Max = %.6f, Count = %lu\n",
-        name.c_str(), makeNamePadding(name).c_str(), stats.mean(), stats.stddev(), stats.min(), stats.max(), stats.count()
-      );
-      formated_stats.push_back(buffer);
+    for (const auto &[name, stats] : _by_name()) {
+      append_stats_line(formated_stats.emplace_back(), name, stats);
     }
+#ifdef MLIB_ALLOC_STATS
+    for (string &line : alloc_stats_lines()) {
+      formated_stats.push_back(std::move(line));
+    }
+#endif
     return formated_stats;
   }
 
@@ -171,7 +195,9 @@ namespace Mlib::Profile {
 
   /** @class @c AutoTimer */
 
-  AutoTimer::AutoTimer(const string &name) : name(name), start(high_resolution_clock::now()) {}
+  AutoTimer::AutoTimer(str_id_t name) : name(name), start(high_resolution_clock::now()) {}
+
+  AutoTimer::AutoTimer(string_view name) : name(str_intern(name)), start(high_resolution_clock::now()) {}
 
   AutoTimer::~AutoTimer(void) {
     auto                    end      = high_resolution_clock::now();
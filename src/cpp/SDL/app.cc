@@ -31,7 +31,8 @@ app *app::_instance = nullptr;
 
 /*-<< Constructor >>-*/
 app::app(void) noexcept
-    : mem_pool(100 * MB) {
+    : mem_pool(2 * MB, (MEM_POOL_CHAINED | MEM_POOL_HUGEPAGE)) {
+  MEM_POOL_STATS_TAG(mem_pool, "app::mem_pool");
   if (!SDL_Init(SDL_INIT_VIDEO)) {
     logE("Failed to init sdl, SDL_ERROR: %s.", SDL_GetError());
     exit(1);
@@ -167,6 +168,7 @@ int app::run(void) noexcept {
   root->set_position(SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED);
   while (_flags.is_set<APP_RUNNING>()) {
     PROFILE_FUNCTION;
+    frame_alloc.next_frame();
     _frame_start();
     SDL_SetRenderDrawColor(root->ren, 0, 0, 0, 255);
     SDL_RenderClear(root->ren);
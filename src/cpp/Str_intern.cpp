@@ -0,0 +1,174 @@
+#include "../include/Str_intern.h"
+#include "../include/Debug.h"
+#include "../include/constexpr.hpp"
+
+#include <atomic>
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+/* Ids are handed out in order, the text of every id lives in 'str_intern_entries'.  That is split
+ * into chunks that double in size, chunk 'c' holding 'STR_INTERN_FIRST_CHUNK << c' entries, so the
+ * chunks never move once published and 'STR_INTERN_CHUNKS' of them cover every 32 bit id. */
+#define STR_INTERN_FIRST_CHUNK 1024u
+#define STR_INTERN_CHUNKS      32
+#define STR_INTERN_SHARD_BITS  6
+/* Bytes the arena of a shard allocates at a time, longer strings get a block of their own. */
+#define STR_INTERN_BLOCK       (64 * 1024)
+
+struct str_intern_entry_t {
+  const char *str;
+  Uint        len;
+};
+
+/* One open addressed table per shard, mapping a hash to the id that owns it. */
+struct str_intern_slot_t {
+  Ulong    hash;
+  str_id_t id; /* 'STR_ID_NONE' while empty. */
+};
+
+struct str_intern_shard_t {
+  std::mutex         mutex;
+  str_intern_slot_t *slots;
+  Uint               cap;
+  Uint               used;
+  char              *block; /* Free tail of the current arena block. */
+  Ulong              block_left;
+};
+
+static std::atomic<str_intern_entry_t *> str_intern_entries[STR_INTERN_CHUNKS];
+static std::atomic<Uint>                 str_intern_next;
+static str_intern_shard_t                str_intern_shards[1 << STR_INTERN_SHARD_BITS];
+
+__inline__ static void __attribute((__always_inline__)) str_intern_locate(str_id_t id, Uint &chunk, Uint &index) {
+  Uint k = ((id / STR_INTERN_FIRST_CHUNK) + 1);
+  chunk  = (std::bit_width(k) - 1);
+  index  = (id - (STR_INTERN_FIRST_CHUNK * ((1u << chunk) - 1)));
+}
+
+static void *str_intern_alloc(Ulong bytes) noexcept {
+  void *ptr = malloc(bytes);
+  if (!ptr) {
+    logE("Failed to allocate %lu bytes for interned strings.", bytes);
+    exit(1);
+  }
+  return ptr;
+}
+
+/* The entry for 'id', allocating its chunk when this is the first id in it. */
+static str_intern_entry_t *str_intern_entry(str_id_t id, bool create) noexcept {
+  Uint chunk, index;
+  str_intern_locate(id, chunk, index);
+  str_intern_entry_t *entries = str_intern_entries[chunk].load(std::memory_order_acquire);
+  if (!entries && create) {
+    str_intern_entry_t *fresh = (str_intern_entry_t *)str_intern_alloc(sizeof(str_intern_entry_t) * (STR_INTERN_FIRST_CHUNK << chunk));
+    /* Another shard may install the same chunk first, then use theirs. */
+    if (str_intern_entries[chunk].compare_exchange_strong(entries, fresh, std::memory_order_acq_rel)) {
+      entries = fresh;
+    }
+    else {
+      free(fresh);
+    }
+  }
+  return (entries + index);
+}
+
+/* Copy 'str' into the arena of 'shard', terminated. */
+static const char *str_intern_store(str_intern_shard_t *shard, std::string_view str) noexcept {
+  Ulong bytes = (str.size() + 1);
+  char *dst;
+  if (bytes > (STR_INTERN_BLOCK / 2)) {
+    dst = (char *)str_intern_alloc(bytes);
+  }
+  else {
+    if (bytes > shard->block_left) {
+      shard->block      = (char *)str_intern_alloc(STR_INTERN_BLOCK);
+      shard->block_left = STR_INTERN_BLOCK;
+    }
+    dst                = shard->block;
+    shard->block      += bytes;
+    shard->block_left -= bytes;
+  }
+  memcpy(dst, str.data(), str.size());
+  dst[str.size()] = '\0';
+  return dst;
+}
+
+static void str_intern_grow(str_intern_shard_t *shard) noexcept {
+  Uint               cap   = (shard->cap ? (shard->cap * 2) : 64);
+  str_intern_slot_t *slots = (str_intern_slot_t *)str_intern_alloc(sizeof(str_intern_slot_t) * cap);
+  for (Uint i = 0; i < cap; ++i) {
+    slots[i].id = STR_ID_NONE;
+  }
+  for (Uint i = 0; i < shard->cap; ++i) {
+    if (shard->slots[i].id != STR_ID_NONE) {
+      Uint at = (shard->slots[i].hash & (cap - 1));
+      while (slots[at].id != STR_ID_NONE) {
+        at = ((at + 1) & (cap - 1));
+      }
+      slots[at] = shard->slots[i];
+    }
+  }
+  free(shard->slots);
+  shard->slots = slots;
+  shard->cap   = cap;
+}
+
+/* Look 'str' up in its shard, adding it when 'create' is set.  The low hash bits pick the slot and
+ * the high ones the shard, so the two stay independent. */
+static str_id_t str_intern_lookup(std::string_view str, bool create) noexcept {
+  Ulong               hash  = Mlib::Constexpr::fnv1a_64(str);
+  str_intern_shard_t *shard = &str_intern_shards[hash >> (64 - STR_INTERN_SHARD_BITS)];
+  std::lock_guard<std::mutex> lock(shard->mutex);
+  if (shard->cap) {
+    for (Uint at = (hash & (shard->cap - 1)); shard->slots[at].id != STR_ID_NONE; at = ((at + 1) & (shard->cap - 1))) {
+      const str_intern_slot_t &slot = shard->slots[at];
+      if (slot.hash == hash) {
+        const str_intern_entry_t *entry = str_intern_entry(slot.id, false);
+        if (entry->len == str.size() && !memcmp(entry->str, str.data(), str.size())) {
+          return slot.id;
+        }
+      }
+    }
+  }
+  if (!create) {
+    return STR_ID_NONE;
+  }
+  /* Keep the load under one half. */
+  if ((shard->used + 1) * 2 > shard->cap) {
+    str_intern_grow(shard);
+  }
+  str_id_t id = str_intern_next.fetch_add(1, std::memory_order_relaxed);
+  if (id == STR_ID_NONE) {
+    logE("Ran out of interned string ids.");
+    exit(1);
+  }
+  str_intern_entry_t *entry = str_intern_entry(id, true);
+  entry->str = str_intern_store(shard, str);
+  entry->len = str.size();
+  Uint at = (hash & (shard->cap - 1));
+  while (shard->slots[at].id != STR_ID_NONE) {
+    at = ((at + 1) & (shard->cap - 1));
+  }
+  shard->slots[at] = {hash, id};
+  ++shard->used;
+  return id;
+}
+
+str_id_t str_intern(std::string_view str) noexcept {
+  return str_intern_lookup(str, true);
+}
+
+str_id_t str_intern_find(std::string_view str) noexcept {
+  return str_intern_lookup(str, false);
+}
+
+std::string_view str_intern_view(str_id_t id) noexcept {
+  const str_intern_entry_t *entry = str_intern_entry(id, false);
+  return std::string_view(entry->str, entry->len);
+}
+
+Uint str_intern_count(void) noexcept {
+  return str_intern_next.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,437 @@
+#include "../include/Str_prim.h"
+
+#include <cstring>
+#if defined(__x86_64__)
+#  include <immintrin.h>
+#endif
+
+/* Every scan starts at 'ptr' rounded down to the vector width and drops the mask bits of the bytes
+ * before 'ptr', the loads that follow are then aligned as well.  Bytes read outside the string
+ * always share an aligned block, and so a page, with a byte that belongs to it. */
+#define ALIGN_DOWN(ptr, width) ((const char *)((Ulong)(ptr) & ~(Ulong)((width) - 1)))
+/* Those bytes are outside the object as far as AddressSanitizer knows, so every function that
+ * loads whole blocks around a string is left uninstrumented.  The compares only read 'len' bytes
+ * and stay checked. */
+#define NO_ASAN __no_sanitize__("address", "hwaddress")
+
+#if defined(__x86_64__)
+
+/* ---------------------------------------------------------- Sse2 ---------------------------------------------------------- */
+
+__inline__ static Uint __attribute((__always_inline__, NO_ASAN)) sse2_eq(const char *p, __m128i v) {
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128((const __m128i *)p), v));
+}
+
+__attribute((NO_ASAN)) static Ulong strlen_sse2(const char *str) noexcept {
+  const __m128i zero = _mm_setzero_si128();
+  const char   *p    = ALIGN_DOWN(str, 16);
+  Uint mask = (sse2_eq(p, zero) >> (str - p));
+  if (mask) {
+    return __builtin_ctz(mask);
+  }
+  while (!(mask = sse2_eq((p += 16), zero)));
+  return ((p - str) + __builtin_ctz(mask));
+}
+
+__attribute((NO_ASAN)) static Ulong strnlen_sse2(const char *str, Ulong maxlen) noexcept {
+  if (!maxlen) {
+    return 0;
+  }
+  const __m128i zero = _mm_setzero_si128();
+  const char   *p    = ALIGN_DOWN(str, 16);
+  Uint  mask = (sse2_eq(p, zero) >> (str - p));
+  Ulong len  = (mask ? __builtin_ctz(mask) : maxlen);
+  for (p += 16; !mask && (Ulong)(p - str) < maxlen; p += 16) {
+    if ((mask = sse2_eq(p, zero))) {
+      len = ((p - str) + __builtin_ctz(mask));
+    }
+  }
+  return ((len < maxlen) ? len : maxlen);
+}
+
+__attribute((NO_ASAN)) static const void *memchr_sse2(const void *ptr, int c, Ulong len) noexcept {
+  if (!len) {
+    return nullptr;
+  }
+  const __m128i needle = _mm_set1_epi8((char)c);
+  const char   *str    = (const char *)ptr;
+  const char   *end    = (str + len);
+  const char   *p      = ALIGN_DOWN(str, 16);
+  const char   *at     = nullptr;
+  Uint mask = (sse2_eq(p, needle) >> (str - p));
+  if (mask) {
+    at = (str + __builtin_ctz(mask));
+  }
+  for (p += 16; !at && p < end; p += 16) {
+    if ((mask = sse2_eq(p, needle))) {
+      at = (p + __builtin_ctz(mask));
+    }
+  }
+  return ((at && at < end) ? at : nullptr);
+}
+
+__attribute((NO_ASAN)) static const void *memrchr_sse2(const void *ptr, int c, Ulong len) noexcept {
+  if (!len) {
+    return nullptr;
+  }
+  const __m128i needle = _mm_set1_epi8((char)c);
+  const char   *str    = (const char *)ptr;
+  const char   *last   = (str + len - 1);
+  const char   *p      = ALIGN_DOWN(last, 16);
+  /* Keep the bits upto and including 'last'. */
+  Uint mask = (sse2_eq(p, needle) & ((2u << (last - p)) - 1));
+  while (!mask && p > str) {
+    mask = sse2_eq((p -= 16), needle);
+  }
+  if (!mask) {
+    return nullptr;
+  }
+  const char *at = (p + (31 - __builtin_clz(mask)));
+  return ((at >= str) ? at : nullptr);
+}
+
+__attribute((NO_ASAN)) static const char *strchr_sse2(const char *str, int c) noexcept {
+  const __m128i needle = _mm_set1_epi8((char)c);
+  const __m128i zero   = _mm_setzero_si128();
+  const char   *p      = ALIGN_DOWN(str, 16);
+  __m128i block = _mm_load_si128((const __m128i *)p);
+  Uint    mask  = (_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(block, needle), _mm_cmpeq_epi8(block, zero))) >> (str - p));
+  const char *base = str;
+  while (!mask) {
+    block = _mm_load_si128((const __m128i *)(p += 16));
+    mask  = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(block, needle), _mm_cmpeq_epi8(block, zero)));
+    base  = p;
+  }
+  const char *at = (base + __builtin_ctz(mask));
+  return ((*at == (char)c) ? at : nullptr);
+}
+
+/* Compares never read past 'len', so unaligned loads are fine here.  Return`s the difference of
+ * the first differing bytes as unsigned chars. */
+static int memcmp_sse2(const void *a, const void *b, Ulong len) noexcept {
+  const Uchar *x = (const Uchar *)a;
+  const Uchar *y = (const Uchar *)b;
+  Ulong i = 0;
+  for (; (i + 16) <= len; i += 16) {
+    Uint mask = (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(x + i)), _mm_loadu_si128((const __m128i *)(y + i)))) ^ 0xFFFF);
+    if (mask) {
+      i += __builtin_ctz(mask);
+      return (x[i] - y[i]);
+    }
+  }
+  for (; i < len; ++i) {
+    if (x[i] != y[i]) {
+      return (x[i] - y[i]);
+    }
+  }
+  return 0;
+}
+
+/* ---------------------------------------------------------- Avx2 ---------------------------------------------------------- */
+
+__attribute((__target__("avx2"), __always_inline__, NO_ASAN)) static inline Uint avx2_eq(const char *p, __m256i v) {
+  return _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_load_si256((const __m256i *)p), v));
+}
+
+__attribute((__target__("avx2"), NO_ASAN)) static Ulong strlen_avx2(const char *str) noexcept {
+  const __m256i zero = _mm256_setzero_si256();
+  const char   *p    = ALIGN_DOWN(str, 32);
+  Uint mask = (avx2_eq(p, zero) >> (str - p));
+  if (mask) {
+    return __builtin_ctz(mask);
+  }
+  /* Two blocks per step, a long string has no terminator in nearly all of them. */
+  p += 32;
+  if ((Ulong)p & 32) {
+    if ((mask = avx2_eq(p, zero))) {
+      return ((p - str) + __builtin_ctz(mask));
+    }
+    p += 32;
+  }
+  while (true) {
+    __m256i a = _mm256_cmpeq_epi8(_mm256_load_si256((const __m256i *)p), zero);
+    __m256i b = _mm256_cmpeq_epi8(_mm256_load_si256((const __m256i *)(p + 32)), zero);
+    if (!_mm256_testz_si256(_mm256_or_si256(a, b), _mm256_or_si256(a, b))) {
+      Ulong both = ((Uint)_mm256_movemask_epi8(a) | ((Ulong)(Uint)_mm256_movemask_epi8(b) << 32));
+      return ((p - str) + __builtin_ctzl(both));
+    }
+    p += 64;
+  }
+}
+
+__attribute((__target__("avx2"), NO_ASAN)) static Ulong strnlen_avx2(const char *str, Ulong maxlen) noexcept {
+  if (!maxlen) {
+    return 0;
+  }
+  const __m256i zero = _mm256_setzero_si256();
+  const char   *p    = ALIGN_DOWN(str, 32);
+  Uint  mask = (avx2_eq(p, zero) >> (str - p));
+  Ulong len  = (mask ? __builtin_ctz(mask) : maxlen);
+  for (p += 32; !mask && (Ulong)(p - str) < maxlen; p += 32) {
+    if ((mask = avx2_eq(p, zero))) {
+      len = ((p - str) + __builtin_ctz(mask));
+    }
+  }
+  return ((len < maxlen) ? len : maxlen);
+}
+
+__attribute((__target__("avx2"), NO_ASAN)) static const void *memchr_avx2(const void *ptr, int c, Ulong len) noexcept {
+  if (!len) {
+    return nullptr;
+  }
+  const __m256i needle = _mm256_set1_epi8((char)c);
+  const char   *str    = (const char *)ptr;
+  const char   *end    = (str + len);
+  const char   *p      = ALIGN_DOWN(str, 32);
+  const char   *at     = nullptr;
+  Uint mask = (avx2_eq(p, needle) >> (str - p));
+  if (mask) {
+    at = (str + __builtin_ctz(mask));
+  }
+  for (p += 32; !at && p < end; p += 32) {
+    if ((mask = avx2_eq(p, needle))) {
+      at = (p + __builtin_ctz(mask));
+    }
+  }
+  return ((at && at < end) ? at : nullptr);
+}
+
+__attribute((__target__("avx2"), NO_ASAN)) static const void *memrchr_avx2(const void *ptr, int c, Ulong len) noexcept {
+  if (!len) {
+    return nullptr;
+  }
+  const __m256i needle = _mm256_set1_epi8((char)c);
+  const char   *str    = (const char *)ptr;
+  const char   *last   = (str + len - 1);
+  const char   *p      = ALIGN_DOWN(last, 32);
+  /* Keep the bits upto and including 'last', at bit 31 the shift wraps to zero and keeps all. */
+  Uint mask = (avx2_eq(p, needle) & ((2u << (last - p)) - 1));
+  while (!mask && p > str) {
+    mask = avx2_eq((p -= 32), needle);
+  }
+  if (!mask) {
+    return nullptr;
+  }
+  const char *at = (p + (31 - __builtin_clz(mask)));
+  return ((at >= str) ? at : nullptr);
+}
+
+__attribute((__target__("avx2"), NO_ASAN)) static const char *strchr_avx2(const char *str, int c) noexcept {
+  const __m256i needle = _mm256_set1_epi8((char)c);
+  const __m256i zero   = _mm256_setzero_si256();
+  const char   *p      = ALIGN_DOWN(str, 32);
+  __m256i block = _mm256_load_si256((const __m256i *)p);
+  Uint    mask  = ((Uint)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(block, needle), _mm256_cmpeq_epi8(block, zero))) >> (str - p));
+  const char *base = str;
+  while (!mask) {
+    block = _mm256_load_si256((const __m256i *)(p += 32));
+    mask  = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(block, needle), _mm256_cmpeq_epi8(block, zero)));
+    base  = p;
+  }
+  const char *at = (base + __builtin_ctz(mask));
+  return ((*at == (char)c) ? at : nullptr);
+}
+
+__attribute((__target__("avx2"))) static int memcmp_avx2(const void *a, const void *b, Ulong len) noexcept {
+  const Uchar *x = (const Uchar *)a;
+  const Uchar *y = (const Uchar *)b;
+  Ulong i = 0;
+  for (; (i + 32) <= len; i += 32) {
+    Uint mask = ~(Uint)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(x + i)), _mm256_loadu_si256((const __m256i *)(y + i))));
+    if (mask) {
+      i += __builtin_ctz(mask);
+      return (x[i] - y[i]);
+    }
+  }
+  return memcmp_sse2((x + i), (y + i), (len - i));
+}
+
+/* --------------------------------------------------------- Avx512 --------------------------------------------------------- */
+
+#define AVX512_TARGET __target__("avx512f,avx512bw,bmi2")
+
+__attribute((AVX512_TARGET, __always_inline__, NO_ASAN)) static inline Ulong avx512_eq(const char *p, __m512i v) {
+  return _mm512_cmpeq_epi8_mask(_mm512_load_si512((const void *)p), v);
+}
+
+__attribute((AVX512_TARGET, NO_ASAN)) static Ulong strlen_avx512(const char *str) noexcept {
+  const __m512i zero = _mm512_setzero_si512();
+  const char   *p    = ALIGN_DOWN(str, 64);
+  Ulong mask = (avx512_eq(p, zero) >> (str - p));
+  if (mask) {
+    return __builtin_ctzl(mask);
+  }
+  while (!(mask = avx512_eq((p += 64), zero)));
+  return ((p - str) + __builtin_ctzl(mask));
+}
+
+__attribute((AVX512_TARGET, NO_ASAN)) static Ulong strnlen_avx512(const char *str, Ulong maxlen) noexcept {
+  if (!maxlen) {
+    return 0;
+  }
+  const __m512i zero = _mm512_setzero_si512();
+  const char   *p    = ALIGN_DOWN(str, 64);
+  Ulong mask = (avx512_eq(p, zero) >> (str - p));
+  Ulong len  = (mask ? __builtin_ctzl(mask) : maxlen);
+  for (p += 64; !mask && (Ulong)(p - str) < maxlen; p += 64) {
+    if ((mask = avx512_eq(p, zero))) {
+      len = ((p - str) + __builtin_ctzl(mask));
+    }
+  }
+  return ((len < maxlen) ? len : maxlen);
+}
+
+__attribute((AVX512_TARGET, NO_ASAN)) static const void *memchr_avx512(const void *ptr, int c, Ulong len) noexcept {
+  if (!len) {
+    return nullptr;
+  }
+  const __m512i needle = _mm512_set1_epi8((char)c);
+  const char   *str    = (const char *)ptr;
+  const char   *end    = (str + len);
+  const char   *p      = ALIGN_DOWN(str, 64);
+  const char   *at     = nullptr;
+  Ulong mask = (avx512_eq(p, needle) >> (str - p));
+  if (mask) {
+    at = (str + __builtin_ctzl(mask));
+  }
+  for (p += 64; !at && p < end; p += 64) {
+    if ((mask = avx512_eq(p, needle))) {
+      at = (p + __builtin_ctzl(mask));
+    }
+  }
+  return ((at && at < end) ? at : nullptr);
+}
+
+__attribute((AVX512_TARGET, NO_ASAN)) static const void *memrchr_avx512(const void *ptr, int c, Ulong len) noexcept {
+  if (!len) {
+    return nullptr;
+  }
+  const __m512i needle = _mm512_set1_epi8((char)c);
+  const char   *str    = (const char *)ptr;
+  const char   *last   = (str + len - 1);
+  const char   *p      = ALIGN_DOWN(last, 64);
+  Ulong mask = (avx512_eq(p, needle) & ((2ul << (last - p)) - 1));
+  while (!mask && p > str) {
+    mask = avx512_eq((p -= 64), needle);
+  }
+  if (!mask) {
+    return nullptr;
+  }
+  const char *at = (p + (63 - __builtin_clzl(mask)));
+  return ((at >= str) ? at : nullptr);
+}
+
+__attribute((AVX512_TARGET, NO_ASAN)) static const char *strchr_avx512(const char *str, int c) noexcept {
+  const __m512i needle = _mm512_set1_epi8((char)c);
+  const __m512i zero   = _mm512_setzero_si512();
+  const char   *p      = ALIGN_DOWN(str, 64);
+  __m512i block = _mm512_load_si512((const void *)p);
+  Ulong   mask  = ((_mm512_cmpeq_epi8_mask(block, needle) | _mm512_cmpeq_epi8_mask(block, zero)) >> (str - p));
+  const char *base = str;
+  while (!mask) {
+    block = _mm512_load_si512((const void *)(p += 64));
+    mask  = (_mm512_cmpeq_epi8_mask(block, needle) | _mm512_cmpeq_epi8_mask(block, zero));
+    base  = p;
+  }
+  const char *at = (base + __builtin_ctzl(mask));
+  return ((*at == (char)c) ? at : nullptr);
+}
+
+/* The tail is read with a masked load, masked out bytes are never touched and can not fault. */
+__attribute((AVX512_TARGET)) static int memcmp_avx512(const void *a, const void *b, Ulong len) noexcept {
+  const Uchar *x = (const Uchar *)a;
+  const Uchar *y = (const Uchar *)b;
+  Ulong i = 0;
+  Ulong mask;
+  for (; (i + 64) <= len; i += 64) {
+    if ((mask = _mm512_cmpneq_epi8_mask(_mm512_loadu_si512((const void *)(x + i)), _mm512_loadu_si512((const void *)(y + i))))) {
+      i += __builtin_ctzl(mask);
+      return (x[i] - y[i]);
+    }
+  }
+  if (i < len) {
+    __mmask64 tail = _bzhi_u64(~0ul, (len - i));
+    if ((mask = _mm512_mask_cmpneq_epi8_mask(tail, _mm512_maskz_loadu_epi8(tail, (x + i)), _mm512_maskz_loadu_epi8(tail, (y + i))))) {
+      i += __builtin_ctzl(mask);
+      return (x[i] - y[i]);
+    }
+  }
+  return 0;
+}
+
+#undef AVX512_TARGET
+
+#define STR_PRIM_TABLE(name) {#name, strlen_##name, strnlen_##name, memchr_##name, memrchr_##name, strchr_##name, memcmp_##name}
+
+static const str_prim_t str_prim_sse2   = STR_PRIM_TABLE(sse2);
+static const str_prim_t str_prim_avx2   = STR_PRIM_TABLE(avx2);
+static const str_prim_t str_prim_avx512 = STR_PRIM_TABLE(avx512);
+
+#undef STR_PRIM_TABLE
+
+str_prim_t str_prim = str_prim_sse2;
+
+bool str_prim_select(const char *isa) noexcept {
+  __builtin_cpu_init();
+  bool avx2   = __builtin_cpu_supports("avx2");
+  bool avx512 = (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("bmi2"));
+  if (!isa) {
+    str_prim = (avx512 ? str_prim_avx512 : avx2 ? str_prim_avx2 : str_prim_sse2);
+  }
+  else if (!strcmp(isa, "sse2")) {
+    str_prim = str_prim_sse2;
+  }
+  else if (!strcmp(isa, "avx2") && avx2) {
+    str_prim = str_prim_avx2;
+  }
+  else if (!strcmp(isa, "avx512") && avx512) {
+    str_prim = str_prim_avx512;
+  }
+  else {
+    return false;
+  }
+  return true;
+}
+
+#else
+
+/* Without a vector path the c library versions are the best there is. */
+static Ulong strlen_libc(const char *str) noexcept {
+  return strlen(str);
+}
+
+static Ulong strnlen_libc(const char *str, Ulong maxlen) noexcept {
+  return strnlen(str, maxlen);
+}
+
+static const void *memchr_libc(const void *ptr, int c, Ulong len) noexcept {
+  return memchr(ptr, c, len);
+}
+
+static const void *memrchr_libc(const void *ptr, int c, Ulong len) noexcept {
+  return memrchr(ptr, c, len);
+}
+
+static const char *strchr_libc(const char *str, int c) noexcept {
+  return strchr(str, c);
+}
+
+static int memcmp_libc(const void *a, const void *b, Ulong len) noexcept {
+  return memcmp(a, b, len);
+}
+
+str_prim_t str_prim = {"libc", strlen_libc, strnlen_libc, memchr_libc, memrchr_libc, strchr_libc, memcmp_libc};
+
+bool str_prim_select(const char *isa) noexcept {
+  return (!isa || !strcmp(isa, "libc"));
+}
+
+#endif
+
+#undef ALIGN_DOWN
+#undef NO_ASAN
+
+/* Runs before any constructor without a priority, the sse2 table covers anything that is earlier. */
+__attribute((__constructor__(101))) static void str_prim_init(void) {
+  str_prim_select(nullptr);
+}
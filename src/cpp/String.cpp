@@ -6,48 +6,244 @@
 #include <cstdlib>
 #include <cstring>
 #include <string>
+#if defined(__x86_64__)
+#  include <immintrin.h>
+#endif
 
 using std::pair;
 using std::string;
 using std::vector;
 
+/* Search for needles of atleast two bytes, once 'hay_len >= needle_len'. */
+typedef const char *(*mstrmem_impl_t)(const char *hay, Ulong hay_len, const char *needle, Ulong needle_len);
+
+/* Positions '[i, hay_len - needle_len]' one at a time, for the tail the vector loops leave. */
+static const char *mstrmem_tail(const char *hay, Ulong i, Ulong hay_len, const char *needle, Ulong needle_len) {
+  for (Ulong last = (hay_len - needle_len); i <= last; ++i) {
+    const char *at = (const char *)memchr((hay + i), needle[0], (last - i + 1));
+    if (!at) {
+      return nullptr;
+    }
+    i = (at - hay);
+    if (!memcmp((at + 1), (needle + 1), (needle_len - 1))) {
+      return at;
+    }
+  }
+  return nullptr;
+}
+
+#if defined(__x86_64__)
+/* Bit 'n' is set when 'hay + at + n' matches the first two and the last byte of the needle. */
+__attribute((__target__("avx2"), __always_inline__)) static inline Uint mstrmem_avx2_block(const char *hay, Ulong at, Ulong needle_len, __m256i first, __m256i second, __m256i last) {
+  __m256i a = _mm256_cmpeq_epi8(first, _mm256_loadu_si256((const __m256i *)(hay + at)));
+  __m256i b = _mm256_cmpeq_epi8(second, _mm256_loadu_si256((const __m256i *)(hay + at + 1)));
+  __m256i c = _mm256_cmpeq_epi8(last, _mm256_loadu_si256((const __m256i *)(hay + at + needle_len - 1)));
+  return _mm256_movemask_epi8(_mm256_and_si256(_mm256_and_si256(a, b), c));
+}
+
+/* Two byte needles, where the last byte is the second one.  Only the pair is compared and blocks
+ * without a candidate are skipped with one test, which is most of them. */
+__attribute((__target__("avx2"))) static const char *mstrmem_avx2_pair(const char *hay, Ulong hay_len, const char *needle) {
+  const __m256i first  = _mm256_set1_epi8(needle[0]);
+  const __m256i second = _mm256_set1_epi8(needle[1]);
+  Ulong i = 0;
+  for (; (i + 65) <= hay_len; i += 64) {
+    __m256i a   = _mm256_and_si256(_mm256_cmpeq_epi8(first, _mm256_loadu_si256((const __m256i *)(hay + i))), _mm256_cmpeq_epi8(second, _mm256_loadu_si256((const __m256i *)(hay + i + 1))));
+    __m256i b   = _mm256_and_si256(_mm256_cmpeq_epi8(first, _mm256_loadu_si256((const __m256i *)(hay + i + 32))), _mm256_cmpeq_epi8(second, _mm256_loadu_si256((const __m256i *)(hay + i + 33))));
+    __m256i any = _mm256_or_si256(a, b);
+    if (!_mm256_testz_si256(any, any)) {
+      return (hay + i + __builtin_ctzl((Uint)_mm256_movemask_epi8(a) | ((Ulong)(Uint)_mm256_movemask_epi8(b) << 32)));
+    }
+  }
+  return mstrmem_tail(hay, i, hay_len, needle, 2);
+}
+
+/* Compare the first two and the last needle byte against a block of starting positions at once,
+ * only positions where all three match are verified with 'memcmp'.  The loads of the last byte
+ * reach 'needle_len - 1' past the block, the loops stop while they stay inside 'hay'. */
+__attribute((__target__("avx2"))) static const char *mstrmem_avx2(const char *hay, Ulong hay_len, const char *needle, Ulong needle_len) {
+  const __m256i first  = _mm256_set1_epi8(needle[0]);
+  const __m256i second = _mm256_set1_epi8(needle[1]);
+  const __m256i last   = _mm256_set1_epi8(needle[needle_len - 1]);
+  Ulong i = 0;
+  if (needle_len == 2) {
+    return mstrmem_avx2_pair(hay, hay_len, needle);
+  }
+  /* Two blocks per step, most of them hold no candidate at all. */
+  for (; (i + needle_len + 63) <= hay_len; i += 64) {
+    Ulong mask = (mstrmem_avx2_block(hay, i, needle_len, first, second, last) | ((Ulong)mstrmem_avx2_block(hay, (i + 32), needle_len, first, second, last) << 32));
+    for (; mask; mask &= (mask - 1)) {
+      Ulong at = (i + __builtin_ctzl(mask));
+      if (!memcmp((hay + at + 2), (needle + 2), (needle_len - 2))) {
+        return (hay + at);
+      }
+    }
+  }
+  for (; (i + needle_len + 31) <= hay_len; i += 32) {
+    for (Uint mask = mstrmem_avx2_block(hay, i, needle_len, first, second, last); mask; mask &= (mask - 1)) {
+      Ulong at = (i + __builtin_ctz(mask));
+      if (!memcmp((hay + at + 2), (needle + 2), (needle_len - 2))) {
+        return (hay + at);
+      }
+    }
+  }
+  return mstrmem_tail(hay, i, hay_len, needle, needle_len);
+}
+
+#define AVX512_TARGET __target__("avx512f,avx512bw,bmi2")
+
+/* The same search 64 positions at a time, the byte compares chain through their masks so a
+ * block is one compare per needle byte and no movemask. */
+__attribute((AVX512_TARGET)) static const char *mstrmem_avx512(const char *hay, Ulong hay_len, const char *needle, Ulong needle_len) {
+  const __m512i first  = _mm512_set1_epi8(needle[0]);
+  const __m512i second = _mm512_set1_epi8(needle[1]);
+  const __m512i last   = _mm512_set1_epi8(needle[needle_len - 1]);
+  Ulong i = 0;
+  if (needle_len == 2) {
+    for (; (i + 65) <= hay_len; i += 64) {
+      Ulong mask = _mm512_mask_cmpeq_epi8_mask(_mm512_cmpeq_epi8_mask(first, _mm512_loadu_si512((const void *)(hay + i))), second, _mm512_loadu_si512((const void *)(hay + i + 1)));
+      if (mask) {
+        return (hay + i + __builtin_ctzl(mask));
+      }
+    }
+    return mstrmem_tail(hay, i, hay_len, needle, needle_len);
+  }
+  for (; (i + needle_len + 63) <= hay_len; i += 64) {
+    Ulong mask = _mm512_cmpeq_epi8_mask(first, _mm512_loadu_si512((const void *)(hay + i)));
+    mask = _mm512_mask_cmpeq_epi8_mask(mask, second, _mm512_loadu_si512((const void *)(hay + i + 1)));
+    mask = _mm512_mask_cmpeq_epi8_mask(mask, last, _mm512_loadu_si512((const void *)(hay + i + needle_len - 1)));
+    for (; mask; mask &= (mask - 1)) {
+      Ulong at = (i + __builtin_ctzl(mask));
+      if (!memcmp((hay + at + 2), (needle + 2), (needle_len - 2))) {
+        return (hay + at);
+      }
+    }
+  }
+  return mstrmem_tail(hay, i, hay_len, needle, needle_len);
+}
+
+#undef AVX512_TARGET
+
+static const char *mstrmem_sse2(const char *hay, Ulong hay_len, const char *needle, Ulong needle_len) {
+  const __m128i first  = _mm_set1_epi8(needle[0]);
+  const __m128i second = _mm_set1_epi8(needle[1]);
+  const __m128i last   = _mm_set1_epi8(needle[needle_len - 1]);
+  Ulong i = 0;
+  for (; (i + needle_len + 15) <= hay_len; i += 16) {
+    __m128i a = _mm_cmpeq_epi8(first, _mm_loadu_si128((const __m128i *)(hay + i)));
+    __m128i b = _mm_cmpeq_epi8(second, _mm_loadu_si128((const __m128i *)(hay + i + 1)));
+    __m128i c = _mm_cmpeq_epi8(last, _mm_loadu_si128((const __m128i *)(hay + i + needle_len - 1)));
+    Uint    mask = _mm_movemask_epi8(_mm_and_si128(_mm_and_si128(a, b), c));
+    for (; mask; mask &= (mask - 1)) {
+      Ulong at = (i + __builtin_ctz(mask));
+      if (!memcmp((hay + at + 2), (needle + 2), (needle_len - 2))) {
+        return (hay + at);
+      }
+    }
+  }
+  return mstrmem_tail(hay, i, hay_len, needle, needle_len);
+}
+#endif
+
+#if !defined(__x86_64__)
+static const char *mstrmem_scalar(const char *hay, Ulong hay_len, const char *needle, Ulong needle_len) {
+  return mstrmem_tail(hay, 0, hay_len, needle, needle_len);
+}
+#endif
+
+static mstrmem_impl_t mstrmem_resolve(void) {
+#if defined(__x86_64__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("bmi2")) {
+    return mstrmem_avx512;
+  }
+  return (__builtin_cpu_supports("avx2") ? mstrmem_avx2 : mstrmem_sse2);
+#else
+  return mstrmem_scalar;
+#endif
+}
+
+const char *mstrmem(const char *hay, Ulong hay_len, const char *needle, Ulong needle_len) noexcept {
+  if (!needle_len) {
+    return hay;
+  }
+  else if (needle_len > hay_len) {
+    return nullptr;
+  }
+  else if (needle_len == 1) {
+    return (const char *)memchr(hay, needle[0], hay_len);
+  }
+  /* Resolved once by the first caller, other threads wait on the guard, and callers from static
+   * constructors in other files still get the resolved function. */
+  static const mstrmem_impl_t impl = mstrmem_resolve();
+  return impl(hay, hay_len, needle, needle_len);
+}
+
 namespace Mlib::String {
   Ulong findN(const string &str, const string &search, Ulong n) {
-    Ulong pos = 0;
+    mstr_search_t it(str.data(), str.size(), search.data(), search.size());
+    Ulong         pos = (Ulong)-1;
     for (Ulong i = 0; i < n; ++i) {
-      pos = str.find(search, pos);
-      if (pos == (Ulong)-1) {
+      if ((pos = it.next()) == (Ulong)-1) {
         return (Ulong)-1;
       }
-      pos += search.length();
     }
-    return pos - search.length();
+    return pos;
   }
 
-  string replaceAll(const string &str, const string &search, const string &replace) {
-    string result = str;
-    size_t pos    = 0;
-    while ((pos = result.find(search, pos)) != string::npos) {
-      result.replace(pos, search.length(), replace);
-      pos += replace.length();
+  /* Record 'str' into 'out' with atmost 'n' matches of 'search' swapped for 'replace'. */
+  static Ulong replace_slices(std::string_view str, std::string_view search, std::string_view replace, Ulong n, MStringBuilder &out) {
+    Ulong count = 0;
+    Ulong last  = 0;
+    if (!search.empty()) {
+      mstr_search_t it(str.data(), str.size(), search.data(), search.size());
+      for (Ulong pos; count < n && (pos = it.next()) != (Ulong)-1; ++count) {
+        out.append((str.data() + last), (pos - last));
+        out.append(replace);
+        last = (pos + search.size());
+      }
     }
+    out.append((str.data() + last), (str.size() - last));
+    return count;
+  }
+
+  /* One scratch builder per thread, so repeated calls reuse its slice buffer. */
+  static Ulong replace_into(std::string_view str, std::string_view search, std::string_view replace, Ulong n, string &out) {
+    static thread_local MStringBuilder sb;
+    sb.clear();
+    Ulong count = replace_slices(str, search, replace, n, sb);
+    sb.append_to(out);
+    return count;
+  }
+
+  string replaceAll(const string &str, const string &search, const string &replace) {
+    string result;
+    replace_into(str, search, replace, (Ulong)-1, result);
     return result;
   }
 
   string replaceN(const string &str, const string &search, const string &replace, size_t n) {
-    string result = str;
-    size_t pos    = 0;
-    for (size_t i = 0; i < n; ++i) {
-      pos = result.find(search, pos);
-      if (pos == string::npos) {
-        return result;
-      }
-      result.replace(pos, search.length(), replace);
-      pos += replace.length();
-    }
+    string result;
+    replace_into(str, search, replace, n, result);
     return result;
   }
 
+  Ulong replaceAll(std::string_view str, std::string_view search, std::string_view replace, string &out) {
+    return replace_into(str, search, replace, (Ulong)-1, out);
+  }
+
+  Ulong replaceAll(std::string_view str, std::string_view search, std::string_view replace, MStringBuilder &out) {
+    return replace_slices(str, search, replace, (Ulong)-1, out);
+  }
+
+  Ulong replaceN(std::string_view str, std::string_view search, std::string_view replace, size_t n, string &out) {
+    return replace_into(str, search, replace, n, out);
+  }
+
+  Ulong replaceN(std::string_view str, std::string_view search, std::string_view replace, size_t n, MStringBuilder &out) {
+    return replace_slices(str, search, replace, n, out);
+  }
+
   vector<pair<string, string>> parse_variables(const string &input) {
     vector<pair<string, string>> result;
     size_t                       pos = 0;
@@ -140,18 +336,6 @@ MString MString_getenv(const char *str) {
   return var;
 }
 
-Ulong mstrlen(const char *str) noexcept {
-  const char *cp = str;
-  for (; *cp; ++cp);
-  return (cp - str);
-}
-
-Ulong mstrnlen(const char *str, Ulong maxlen) noexcept {
-  const char *cp = str;
-  for (; maxlen != 0 && *cp; ++cp, --maxlen);
-  return (Ulong)(cp - str);
-}
-
 char *mstrndup(const char *str, Ulong maxlen) noexcept {
   Ulong _len  = mstrnlen(str, maxlen);
   char *copy = (char *)malloc(_len + 1);
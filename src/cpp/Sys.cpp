@@ -1,5 +1,6 @@
 /** @file Sys.cpp */
 #include "../include/Sys.h"
+#include "../include/Conv.h"
 #include "../include/Io.h"
 
 #include <sys/statfs.h>
@@ -164,23 +165,8 @@ namespace Mlib::Sys {
   }
 
   const char *itoa(int num) _NO_THROW {
-    static thread_local char buffer[20];
-    char                    *p = buffer;
-    if (num < 0) {
-      *p++ = '-';
-      num  = -num;
-    }
-    do {
-      *p++ = '0' + (num % 10);
-      num /= 10;
-    }
-    while (num);
-    *p = '\0';
-    for (char *q = (*buffer == '-') ? buffer + 1 : buffer; q < --p; ++q) {
-      char temp = *q;
-      *q        = *p;
-      *p        = temp;
-    }
+    static thread_local char buffer[CONV_I64_MAX + 1];
+    buffer[conv_i64(num, buffer)] = '\0';
     return buffer;
   }
 
@@ -251,5 +237,11 @@ void format_time(Ulong ms, char *buffer, Ulong buffer_size) {
   }
   strftime(buffer, buffer_size, "%Y-%m-%d %H:%M:%S", tm_info);
   const Ulong buffer_len = strlen(buffer);
-  snprintf((buffer + buffer_len), (buffer_size - buffer_len), ".%03lu", (Ulong)(ms % 1000));
+  /* Atleast ".000" and the terminator. */
+  if ((buffer_size - buffer_len) >= 5) {
+    /* The leading one keeps the zeros, then becomes the point. */
+    conv_u64((1000 + (ms % 1000)), (buffer + buffer_len));
+    buffer[buffer_len]     = '.';
+    buffer[buffer_len + 4] = '\0';
+  }
 }
\ No newline at end of file
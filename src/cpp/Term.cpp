@@ -9,6 +9,7 @@
 #include "../include/Term.h"
 #include "../include/Error.h"
 #include "../include/Io.h"
+#include "../include/Utf8.h"
 #include "../include/def.h"
 
 #include <cerrno>
@@ -153,7 +154,7 @@ namespace Mlib::Term {
     char    msg[1024];
     va_list ap;
     va_start(ap, fmt);
-    vsnprintf(msg, sizeof(fmt), fmt, ap);
+    vsnprintf(msg, sizeof(msg), fmt, ap);
     va_end(ap);
     printf("%s", msg);
     fflush(stdout);
@@ -168,12 +169,24 @@ namespace Mlib::Term {
     char    buf[1024];
     va_list ap;
     va_start(ap, fmt);
-    vsnprintf(buf, sizeof(buf), fmt, ap);
+    int len = vsnprintf(buf, sizeof(buf), fmt, ap);
     va_end(ap);
+    if (len < 0) {
+      return;
+    }
+    else if ((Ulong)len >= sizeof(buf)) {
+      len = (sizeof(buf) - 1);
+    }
+    /* Center on the columns the text takes, not its bytes, and cut it to the terminal width. */
+    Ulong width = utf8_width(buf, len);
+    if (width > colums) {
+      len   = utf8_prefix_for_width(buf, len, colums);
+      width = utf8_width(buf, len);
+    }
     Ulong row   = (rows / 2);
-    Ulong colum = ((colums - strlen(buf)) / 2);
+    Ulong colum = ((colums - width) / 2);
     move_cursor(row, colum);
-    writef("%s", buf);
+    writef("%.*s", len, buf);
   }
 
   int open_tty_as_fd(const char *tty) {
@@ -0,0 +1,98 @@
+#include "../include/Thread_arena.h"
+
+#include <atomic>
+
+/* Head of the shared slab list.  Slabs are 'THREAD_ARENA_SLAB_SIZE' aligned, so the low
+ * bits of the head hold a counter that is bumped on every update to defeat ABA. */
+#define SLAB_TAG_MASK (THREAD_ARENA_SLAB_SIZE - 1)
+#define SLAB_USABLE   (THREAD_ARENA_SLAB_SIZE - sizeof(mem_pool_chunk_t))
+
+static std::atomic<Ulong> slab_list_head {0};
+
+mem_pool_chunk_t *thread_arena_slab_pop(void) noexcept {
+  Ulong head = slab_list_head.load(std::memory_order_acquire);
+  while (true) {
+    mem_pool_chunk_t *slab = (mem_pool_chunk_t *)(head & ~SLAB_TAG_MASK);
+    if (!slab) {
+      /* Slabs are never unmapped, so reading 'next' of a slab another thread just
+       * popped is safe, the tag makes the exchange below fail in that case. */
+      return mem_pool_map_chunk(SLAB_USABLE, MEM_POOL_HUGEPAGE);
+    }
+    Ulong next = ((Ulong)__atomic_load_n(&slab->next, __ATOMIC_RELAXED) | ((head + 1) & SLAB_TAG_MASK));
+    if (slab_list_head.compare_exchange_weak(head, next, std::memory_order_acq_rel, std::memory_order_acquire)) {
+      __atomic_store_n(&slab->next, nullptr, __ATOMIC_RELAXED);
+      return slab;
+    }
+  }
+}
+
+void thread_arena_slab_push(mem_pool_chunk_t *first, mem_pool_chunk_t *last) noexcept {
+  Ulong head = slab_list_head.load(std::memory_order_relaxed);
+  while (true) {
+    __atomic_store_n(&last->next, (mem_pool_chunk_t *)(head & ~SLAB_TAG_MASK), __ATOMIC_RELAXED);
+    Ulong next = ((Ulong)first | ((head + 1) & SLAB_TAG_MASK));
+    if (slab_list_head.compare_exchange_weak(head, next, std::memory_order_release, std::memory_order_relaxed)) {
+      return;
+    }
+  }
+}
+
+void *thread_arena_t::_refill(Ulong size, Ulong alignment) noexcept {
+  /* Allocations that can never fit a slab get a dedicated mapping, released on 'reset()'. */
+  if ((size + alignment) > SLAB_USABLE) {
+    mem_pool_chunk_t *chunk = mem_pool_map_chunk((size + alignment), 0);
+    if (!chunk) {
+      logE("thread_arena_t failed to map %lu bytes.", size);
+      return nullptr;
+    }
+    chunk->next = _large;
+    _large      = chunk;
+    _retired_used += size;
+    Ulong data = (Ulong)chunk + sizeof(mem_pool_chunk_t);
+    return (void *)((data + alignment - 1) & ~(alignment - 1));
+  }
+  if (_current) {
+    _retired_used += _offset;
+    /* A thread that lost the race in 'thread_arena_slab_pop()' may still be reading 'next'. */
+    __atomic_store_n(&_current->next, _retired, __ATOMIC_RELAXED);
+    _retired = _current;
+  }
+  _current = thread_arena_slab_pop();
+  if (!_current) {
+    logE("thread_arena_t failed to refill from the shared slab list.");
+    _pool      = nullptr;
+    _pool_size = 0;
+    _offset    = 0;
+    return nullptr;
+  }
+  _pool      = ((char *)_current + sizeof(mem_pool_chunk_t));
+  _pool_size = SLAB_USABLE;
+  _offset    = 0;
+  return alloc(size, alignment);
+}
+
+void thread_arena_t::reset(void) noexcept {
+  if (_retired) {
+    mem_pool_chunk_t *last = _retired;
+    while (last->next) {
+      last = last->next;
+    }
+    thread_arena_slab_push(_retired, last);
+    _retired = nullptr;
+  }
+  while (_large) {
+    mem_pool_chunk_t *next = _large->next;
+    mem_pool_unmap_chunk(_large);
+    _large = next;
+  }
+  _offset       = 0;
+  _retired_used = 0;
+}
+
+thread_arena_t::~thread_arena_t(void) noexcept {
+  reset();
+  if (_current) {
+    thread_arena_slab_push(_current, _current);
+    _current = nullptr;
+  }
+}
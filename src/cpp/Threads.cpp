@@ -1,7 +1,11 @@
 #include "../include/Threads.h"
+#include "../include/Obj_pool.h"
+#include "../include/Thread_arena.h"
 
 namespace Mlib::Threads {
-  ThreadPool ::ThreadPool(Ulong threads) : stop(false) {
+  ThreadPool ::ThreadPool(Ulong threads, std::pmr::memory_resource *mr)
+      : tasks(std::pmr::polymorphic_allocator<std::function<void()>>(mr))
+      , stop(false) {
     for (Ulong i = 0; i < threads; ++i) {
       workers.emplace_back([this] {
         while (true) {
@@ -18,6 +22,8 @@ namespace Mlib::Threads {
             tasks.pop();
           }
           task();
+          /* Scratch memory a task took from its thread arena is released when it returns. */
+          THREAD_ARENA.reset();
         }
       });
     }
@@ -52,13 +58,13 @@ typedef struct {
 
 void (*MFuture_error_callback)(const char *format, ...) = NULL;
 
-/* Internal function that return`s a malloc`ed MFuture. */
+/* Internal function that return`s a MFuture from the shared slab pools. */
 static MFuture *MFuture_create(void) {
-  MFuture *future = (MFuture *)malloc(sizeof(*future));
+  MFuture *future = (MFuture *)slab_alloc(sizeof(*future));
   if (!future) {
     /* If there is a error callback then call it. */
     if (MFuture_error_callback) {
-      MFuture_error_callback("%s: Failed to malloc MFuture.\n", __func__);
+      MFuture_error_callback("%s: Failed to allocate MFuture.\n", __func__);
     }
     return NULL;
   }
@@ -72,7 +78,7 @@ static MFuture *MFuture_create(void) {
 void MFuture_destroy(MFuture *future) {
   pthread_mutex_destroy(&future->mutex);
   pthread_cond_destroy(&future->cond);
-  free(future);
+  slab_free(future, sizeof(*future));
 }
 
 void *MFuture_get(MFuture *future) {
@@ -93,26 +99,28 @@ static void *MFuture_thread_func(void *arg) {
   data->future->is_ready = TRUE;
   pthread_cond_signal(&data->future->cond);
   pthread_mutex_unlock(&data->future->mutex);
-  free(data);
+  slab_free(data, sizeof(*data));
   return NULL;
 }
 
 MFuture *MFuture_submit(void *(*task)(void *), void *arg) {
-  MFutureTask *data = (MFutureTask *)malloc(sizeof(*data));
+  MFutureTask *data = (MFutureTask *)slab_alloc(sizeof(*data));
   if (!data) {
     /* If there is a error callback set then call it. */
     if (MFuture_error_callback) {
-      MFuture_error_callback("%s: Failed to malloc MFutureTask.\n", __func__);
+      MFuture_error_callback("%s: Failed to allocate MFutureTask.\n", __func__);
     }
     return NULL;
   }
-  data->future = MFuture_create();
-  data->task   = task;
-  data->arg    = arg;
+  /* Keep our own copy, 'data' belongs to the thread once it is started and is freed by it. */
+  MFuture *future = MFuture_create();
+  data->future    = future;
+  data->task      = task;
+  data->arg       = arg;
   pthread_t thread;
   pthread_create(&thread, NULL, MFuture_thread_func, data);
   pthread_detach(thread);
-  return data->future;
+  return future;
 }
 
 void MFuture_set_error_callback(void (*callback)(const char *format, ...)) {
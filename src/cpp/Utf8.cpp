@@ -0,0 +1,558 @@
+#include "../include/Utf8.h"
+
+#include <cstring>
+#if defined(__x86_64__)
+#  include <immintrin.h>
+#endif
+
+/* ---------------------------------------------------------- Wcwidth ---------------------------------------------------------- */
+
+struct wcwidth_range_t {
+  char32_t lo;
+  char32_t hi;
+};
+
+/* Combining marks, width zero.  The same set as 'Mlib::Constexpr::Chars::is_combining_character()'
+ * with adjacent ranges merged.  Sorted, as the table builder walks them in order. */
+static constexpr wcwidth_range_t wcwidth_zero[] = {
+  {0x00300, 0x0036F}, {0x00591, 0x005BD}, {0x005BF, 0x005BF}, {0x005C1, 0x005C2},
+  {0x005C4, 0x005C5}, {0x005C7, 0x005C7}, {0x00610, 0x0061A}, {0x0064B, 0x0065F},
+  {0x00670, 0x00670}, {0x006D6, 0x006DC}, {0x006DF, 0x006E4}, {0x006E7, 0x006E8},
+  {0x006EA, 0x006ED}, {0x00711, 0x0073F}, {0x007A6, 0x007B0}, {0x007EB, 0x007F3},
+  {0x00816, 0x00819}, {0x0081B, 0x00823}, {0x00825, 0x00827}, {0x00829, 0x0082D},
+  {0x00859, 0x0085B}, {0x008D3, 0x008E1}, {0x008E3, 0x00903}, {0x0093A, 0x0093C},
+  {0x0093E, 0x0094F}, {0x00951, 0x00957}, {0x00962, 0x00963}, {0x00981, 0x00983},
+  {0x009BC, 0x009BC}, {0x009BE, 0x009BE}, {0x009C0, 0x009C4}, {0x009C7, 0x009C8},
+  {0x009CB, 0x009CD}, {0x009D7, 0x009D7}, {0x009E2, 0x009E3}, {0x009FE, 0x009FE},
+  {0x00A01, 0x00A03}, {0x00A3C, 0x00A3C}, {0x00A3E, 0x00A3E}, {0x00A40, 0x00A42},
+  {0x00A47, 0x00A48}, {0x00A4B, 0x00A4D}, {0x00A51, 0x00A52}, {0x00A70, 0x00A71},
+  {0x00A75, 0x00A82}, {0x00ABC, 0x00ACD}, {0x00AE2, 0x00AE3}, {0x00AFA, 0x00AFA},
+  {0x00B01, 0x00B03}, {0x00B3C, 0x00B4D}, {0x00B56, 0x00B57}, {0x00B62, 0x00B63},
+  {0x00B82, 0x00BC0}, {0x00BCD, 0x00C4A}, {0x00C55, 0x00C56}, {0x00C62, 0x00C63},
+  {0x00CBC, 0x00CC8}, {0x00CCA, 0x00CCD}, {0x00CE2, 0x00CE3}, {0x00D00, 0x00D0C},
+  {0x00D3B, 0x00D4D}, {0x00D62, 0x00D63}, {0x00DCA, 0x00DD6}, {0x00E31, 0x00E3A},
+  {0x00E47, 0x00E4E}, {0x00EB1, 0x00EBC}, {0x00EC8, 0x00ECD}, {0x00F18, 0x00F39},
+  {0x00F71, 0x00F84}, {0x00F86, 0x00F87}, {0x00F8D, 0x00F97}, {0x00F99, 0x00FBC},
+  {0x0102B, 0x0103E}, {0x01056, 0x01059}, {0x0105E, 0x01060}, {0x01062, 0x01064},
+  {0x01067, 0x0106D}, {0x01071, 0x01074}, {0x01082, 0x0108D}, {0x0108F, 0x0109A},
+  {0x0135D, 0x0135F}, {0x01712, 0x01714}, {0x01732, 0x01734}, {0x01752, 0x01753},
+  {0x01772, 0x01773}, {0x017B4, 0x017D3}, {0x0180B, 0x0180D}, {0x01885, 0x01886},
+  {0x018A9, 0x01923}, {0x01927, 0x01928}, {0x01932, 0x01935}, {0x01939, 0x0193B},
+  {0x01A17, 0x01A1B}, {0x01A56, 0x01A60}, {0x01A62, 0x01A7C}, {0x01AB0, 0x01B04},
+  {0x01B34, 0x01B44}, {0x01B6B, 0x01B73}, {0x01B80, 0x01B82}, {0x01BA2, 0x01BA5},
+  {0x01BA8, 0x01BAD}, {0x01BE6, 0x01BF3}, {0x01C24, 0x01C37}, {0x01CD0, 0x01CD2},
+  {0x01CD4, 0x01CE8}, {0x01CED, 0x01CFA}, {0x01DC0, 0x01DFF}, {0x020D0, 0x020FF},
+  {0x02CEF, 0x02CF1}, {0x02D7F, 0x02DFF}, {0x0302A, 0x0302F}, {0x03099, 0x0309A},
+  {0x0A66F, 0x0A672}, {0x0A674, 0x0A67D}, {0x0A69E, 0x0A6A0}, {0x0A6F0, 0x0A6F1},
+  {0x0A8E0, 0x0A8F1}, {0x0A8FF, 0x0A92F}, {0x0A947, 0x0A96B}, {0x0A980, 0x0A982},
+  {0x0A9B3, 0x0A9B3}, {0x0A9B6, 0x0A9B9}, {0x0A9BC, 0x0A9BD}, {0x0A9E5, 0x0A9E5},
+  {0x0AA29, 0x0AA2E}, {0x0AA31, 0x0AA32}, {0x0AA35, 0x0AA36}, {0x0AA43, 0x0AA4C},
+  {0x0AA7C, 0x0AA7C}, {0x0AAB0, 0x0AAB0}, {0x0AAB2, 0x0AAB4}, {0x0AAB7, 0x0AAB8},
+  {0x0AABE, 0x0AABF}, {0x0AAC1, 0x0AAC1}, {0x0AAEC, 0x0AAED}, {0x0AAF6, 0x0AB60},
+  {0x0AB65, 0x0AB65}, {0x0ABE3, 0x0ABEA}, {0x0ABEC, 0x0ABED}, {0x0FB1E, 0x0FE0F},
+  {0x0FE20, 0x0FE2F}, {0x101FD, 0x101FD}, {0x102E0, 0x102E0}, {0x10376, 0x1037A},
+  {0x10A01, 0x10A03}, {0x10A05, 0x10A06}, {0x10A0C, 0x10A0F}, {0x10A38, 0x10A3A},
+  {0x10A3F, 0x10AE5}, {0x10D24, 0x10D27}, {0x10EAB, 0x10EAC}, {0x10F46, 0x10F50},
+  {0x11000, 0x11002}, {0x11038, 0x11046}, {0x1107F, 0x11082}, {0x110B0, 0x110BA},
+  {0x11100, 0x11102}, {0x11127, 0x11134}, {0x11173, 0x11173}, {0x11180, 0x11182},
+  {0x111B3, 0x111C0}, {0x111C9, 0x111CC}, {0x1122C, 0x11237}, {0x112DF, 0x112EA},
+  {0x11300, 0x11303}, {0x1133B, 0x11340}, {0x11357, 0x11357}, {0x11362, 0x11363},
+  {0x11366, 0x1136C}, {0x11370, 0x11374}, {0x114B0, 0x114C3}, {0x115AF, 0x115B5},
+  {0x115B8, 0x115C0}, {0x115DC, 0x115DD}, {0x11630, 0x11640}, {0x116AB, 0x116B7},
+  {0x1171D, 0x1172B}, {0x1182C, 0x1183A}, {0x119D1, 0x119E1}, {0x11A01, 0x11A0A},
+  {0x11A33, 0x11A39}, {0x11A3B, 0x11A3E}, {0x11A47, 0x11A47}, {0x11A51, 0x11A56},
+  {0x11A59, 0x11A5B}, {0x11A8A, 0x11A96}, {0x11A98, 0x11A99}, {0x11C2F, 0x11C36},
+  {0x11C38, 0x11C40}, {0x11C92, 0x11CA7}, {0x11CAA, 0x11CB0}, {0x11CB2, 0x11CB3},
+  {0x11CB5, 0x11CB6}, {0x11D31, 0x11D36}, {0x11D3A, 0x11D3A}, {0x11D3C, 0x11D3D},
+  {0x11D3F, 0x11D45}, {0x11D47, 0x11D48}, {0x11D90, 0x11D91}, {0x11D95, 0x11D95},
+  {0x11F00, 0x11F10}, {0x16AF0, 0x16AF5}, {0x16B30, 0x16B36}, {0x16F51, 0x16F87},
+  {0x16F8F, 0x16F92}, {0x16FF0, 0x16FF1}, {0x1BC9D, 0x1BC9E}, {0x1D167, 0x1D169},
+  {0x1D17B, 0x1D182}, {0x1D185, 0x1D18B}, {0x1D1AA, 0x1D1AD}, {0x1D242, 0x1D244},
+  {0x1DA00, 0x1DA36}, {0x1DA3B, 0x1DA6C}, {0x1DA75, 0x1DA75}, {0x1DA84, 0x1DA84},
+  {0x1DA9B, 0x1DA9F}, {0x1DAA1, 0x1DAAF}, {0x1E000, 0x1E006}, {0x1E008, 0x1E018},
+  {0x1E01B, 0x1E021}, {0x1E023, 0x1E024}, {0x1E026, 0x1E02A}, {0x1E8D0, 0x1E8D6},
+  {0x1E944, 0x1E94A}, {0xE0100, 0xE01EF},
+};
+
+/* Wide east asian forms, width two unless also combining. */
+static constexpr wcwidth_range_t wcwidth_wide[] = {
+  {0x01100, 0x0115F}, {0x02329, 0x0232A}, {0x02E80, 0x0303E}, {0x03040, 0x0A4CF},
+  {0x0AC00, 0x0D7A3}, {0x0F900, 0x0FAFF}, {0x0FE10, 0x0FE19}, {0x0FE30, 0x0FE6F},
+  {0x0FF00, 0x0FF60}, {0x0FFE0, 0x0FFE6}, {0x20000, 0x2FFFD}, {0x30000, 0x3FFFD},
+};
+
+/* The table covers the first four planes, past them only the variation selectors in plane 14 are
+ * not width one.  It is split in blocks of 128 codepoints with two bits each, and blocks with a
+ * single width share one of the three uniform blocks at the front. */
+#define WCWIDTH_END         0x40000u
+#define WCWIDTH_BLOCK       128u
+#define WCWIDTH_BLOCKS      (WCWIDTH_END / WCWIDTH_BLOCK)
+#define WCWIDTH_BLOCK_WORDS ((WCWIDTH_BLOCK * 2) / 64)
+
+template <Uint N>
+struct wcwidth_table_t {
+  Ushort stage1[WCWIDTH_BLOCKS];
+  Ulong  blocks[N][WCWIDTH_BLOCK_WORDS];
+};
+
+#define WCWIDTH_ZERO_COUNT (sizeof(wcwidth_zero) / sizeof(*wcwidth_zero))
+#define WCWIDTH_WIDE_COUNT (sizeof(wcwidth_wide) / sizeof(*wcwidth_wide))
+
+/* Whether a range of 'ranges' starts or ends inside the block at 'start'.  'at' is the first range
+ * not wholly before it, and moves forward with the blocks. */
+static constexpr bool wcwidth_split(const wcwidth_range_t *ranges, Uint count, Uint &at, char32_t start) {
+  for (; at < count && ranges[at].hi < start; ++at);
+  if (at == count) {
+    return false;
+  }
+  return ((ranges[at].lo > start && ranges[at].lo < (start + WCWIDTH_BLOCK)) || (ranges[at].lo <= start && ranges[at].hi < (start + WCWIDTH_BLOCK - 1)));
+}
+
+/* Width of 'cp', where 'zi' and 'wi' are the first ranges not wholly before it. */
+static constexpr Uchar wcwidth_at(char32_t cp, Uint &zi, Uint &wi) {
+  for (; zi < WCWIDTH_ZERO_COUNT && wcwidth_zero[zi].hi < cp; ++zi);
+  for (; wi < WCWIDTH_WIDE_COUNT && wcwidth_wide[wi].hi < cp; ++wi);
+  if (zi < WCWIDTH_ZERO_COUNT && wcwidth_zero[zi].lo <= cp) {
+    return 0;
+  }
+  return ((wi < WCWIDTH_WIDE_COUNT && wcwidth_wide[wi].lo <= cp) ? 2 : 1);
+}
+
+/* Calls 'f(block, uniform, widths)' for every block in order.  Only blocks some range boundary
+ * falls inside are filled in per codepoint, with 'uniform' as -1, the rest are one width.  Doing
+ * every codepoint one by one takes the compiler seconds. */
+template <typename F>
+static consteval void wcwidth_for_each_block(F f) {
+  Uint zi = 0;
+  Uint wi = 0;
+  for (Uint block = 0; block < WCWIDTH_BLOCKS; ++block) {
+    char32_t start = (block * WCWIDTH_BLOCK);
+    Uchar    widths[WCWIDTH_BLOCK] {};
+    bool     zero_split = wcwidth_split(wcwidth_zero, WCWIDTH_ZERO_COUNT, zi, start);
+    bool     wide_split = wcwidth_split(wcwidth_wide, WCWIDTH_WIDE_COUNT, wi, start);
+    if (!zero_split && !wide_split) {
+      f(block, wcwidth_at(start, zi, wi), widths);
+      continue;
+    }
+    Uint bzi = zi;
+    Uint bwi = wi;
+    for (Uint i = 0; i < WCWIDTH_BLOCK; ++i) {
+      widths[i] = wcwidth_at((start + i), bzi, bwi);
+    }
+    f(block, -1, widths);
+  }
+}
+
+static consteval Uint wcwidth_block_count(void) {
+  Uint count = 3;
+  wcwidth_for_each_block([&](Uint, int uniform, const Uchar *) {
+    count += (uniform < 0);
+  });
+  return count;
+}
+
+static consteval auto wcwidth_build(void) {
+  wcwidth_table_t<wcwidth_block_count()> table {};
+  for (Uint w = 0; w < 3; ++w) {
+    for (Uint i = 0; i < WCWIDTH_BLOCK_WORDS; ++i) {
+      table.blocks[w][i] = (0x5555555555555555ul * w);
+    }
+  }
+  Uint next = 3;
+  wcwidth_for_each_block([&](Uint block, int uniform, const Uchar *widths) {
+    if (uniform >= 0) {
+      table.stage1[block] = uniform;
+      return;
+    }
+    for (Uint i = 0; i < WCWIDTH_BLOCK; ++i) {
+      table.blocks[next][i / 32] |= ((Ulong)widths[i] << ((i % 32) * 2));
+    }
+    table.stage1[block] = next++;
+  });
+  return table;
+}
+
+static constexpr auto wcwidth_table = wcwidth_build();
+
+int mwcwidth(char32_t cp) noexcept {
+  if (cp < 0x7F) {
+    return ((cp >= 0x20) ? 1 : cp ? -1 : 0);
+  }
+  else if (cp < 0xA0) {
+    return -1;
+  }
+  else if (cp >= WCWIDTH_END) {
+    return ((cp >= 0xE0100 && cp <= 0xE01EF) ? 0 : 1);
+  }
+  Uint off = (cp % WCWIDTH_BLOCK);
+  return ((wcwidth_table.blocks[wcwidth_table.stage1[cp / WCWIDTH_BLOCK]][off / 32] >> ((off % 32) * 2)) & 3);
+}
+
+/* ---------------------------------------------------------- Scalar ---------------------------------------------------------- */
+
+#define UTF8_REPLACEMENT 0xFFFD
+
+Uint utf8_decode(const char *str, Ulong len, char32_t *cp) noexcept {
+  const Uchar *s = (const Uchar *)str;
+  Uint     n;
+  char32_t min;
+  char32_t c = s[0];
+  if (c < 0x80) {
+    *cp = c;
+    return 1;
+  }
+  else if ((c & 0xE0) == 0xC0) {
+    n   = 2;
+    min = 0x80;
+    c  &= 0x1F;
+  }
+  else if ((c & 0xF0) == 0xE0) {
+    n   = 3;
+    min = 0x800;
+    c  &= 0x0F;
+  }
+  else if ((c & 0xF8) == 0xF0) {
+    n   = 4;
+    min = 0x10000;
+    c  &= 0x07;
+  }
+  else {
+    *cp = UTF8_REPLACEMENT;
+    return 1;
+  }
+  if (n > len) {
+    *cp = UTF8_REPLACEMENT;
+    return 1;
+  }
+  for (Uint i = 1; i < n; ++i) {
+    if ((s[i] & 0xC0) != 0x80) {
+      *cp = UTF8_REPLACEMENT;
+      return 1;
+    }
+    c = ((c << 6) | (s[i] & 0x3F));
+  }
+  if (c < min || c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF)) {
+    *cp = UTF8_REPLACEMENT;
+    return 1;
+  }
+  *cp = c;
+  return n;
+}
+
+/* Whether a full sequence starts at 's', a literal U+FFFD in the input is valid as well. */
+__inline__ static bool __attribute((__always_inline__)) utf8_valid_at(const char *s, Ulong len, Uint &n) {
+  char32_t cp;
+  n = utf8_decode(s, len, &cp);
+  return (cp != UTF8_REPLACEMENT || (n == 3 && (Uchar)s[0] == 0xEF));
+}
+
+/* Skip whole words of ascii. */
+__inline__ static Ulong __attribute((__always_inline__)) utf8_ascii_run(const char *str, Ulong i, Ulong len) {
+  for (Ulong word; (i + 8) <= len; i += 8) {
+    memcpy(&word, (str + i), 8);
+    if (word & 0x8080808080808080ul) {
+      break;
+    }
+  }
+  return i;
+}
+
+static bool utf8_validate_scalar(const char *str, Ulong len) noexcept {
+  for (Ulong i = 0; (i = utf8_ascii_run(str, i, len)) < len;) {
+    Uint n;
+    if (!utf8_valid_at((str + i), (len - i), n)) {
+      return false;
+    }
+    i += n;
+  }
+  return true;
+}
+
+static Ulong utf8_count_scalar(const char *str, Ulong i, Ulong len, Ulong count) noexcept {
+  for (; i < len; ++i) {
+    count += (((Uchar)str[i] & 0xC0) != 0x80);
+  }
+  return count;
+}
+
+/* --------------------------------------------------------- Avx2 --------------------------------------------------------- */
+
+#if defined(__x86_64__)
+
+static bool utf8_resolve_avx2(void) noexcept {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+}
+
+/* Resolved once by the first caller, other threads wait on the guard, and callers from static
+ * constructors in other files still get the avx2 path. */
+__inline__ static bool __attribute((__always_inline__)) utf8_avx2(void) noexcept {
+  static const bool avx2 = utf8_resolve_avx2();
+  return avx2;
+}
+
+/* Error classes of the lookup validator by Keiser and Lemire, "Validating UTF-8 In Less Than One
+ * Instruction Per Byte".  Every byte pair is classified by three 16 entry tables, the high and low
+ * nibble of the first byte and the high nibble of the second, and any bit left after anding the
+ * three is an error.  'TWO_CONTS' is instead required exactly where a third or fourth byte is. */
+#define UTF8_TOO_SHORT      (1 << 0)
+#define UTF8_TOO_LONG       (1 << 1)
+#define UTF8_OVERLONG_3     (1 << 2)
+#define UTF8_TOO_LARGE      (1 << 3)
+#define UTF8_SURROGATE      (1 << 4)
+#define UTF8_OVERLONG_2     (1 << 5)
+#define UTF8_TOO_LARGE_1000 (1 << 6)
+#define UTF8_OVERLONG_4     (1 << 6)
+#define UTF8_TWO_CONTS      (1 << 7)
+#define UTF8_CARRY          (UTF8_TOO_SHORT | UTF8_TOO_LONG | UTF8_TWO_CONTS)
+
+__attribute((__target__("avx2"), __always_inline__)) static inline __m256i utf8_table(
+  char a0, char a1, char a2, char a3, char a4, char a5, char a6, char a7,
+  char a8, char a9, char a10, char a11, char a12, char a13, char a14, char a15)
+{
+  return _mm256_setr_epi8(a0, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15,
+                          a0, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13, a14, a15);
+}
+
+/* The 32 bytes ending 'n' bytes before 'input', with the tail of 'prev' shifted in. */
+template <int N>
+__attribute((__target__("avx2"), __always_inline__)) static inline __m256i utf8_prev(__m256i input, __m256i prev) {
+  return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(prev, input, 0x21), (16 - N));
+}
+
+__attribute((__target__("avx2"), __always_inline__)) static inline __m256i utf8_high_nibble(__m256i v) {
+  return _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0F));
+}
+
+__attribute((__target__("avx2"), __always_inline__)) static inline __m256i utf8_block_errors(__m256i input, __m256i prev) {
+  const __m256i byte_1_high = utf8_table(
+    UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+    UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+    UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS,
+    (UTF8_TOO_SHORT | UTF8_OVERLONG_2),
+    UTF8_TOO_SHORT,
+    (UTF8_TOO_SHORT | UTF8_OVERLONG_3 | UTF8_SURROGATE),
+    (char)(UTF8_TOO_SHORT | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4)
+  );
+  const __m256i byte_1_low = utf8_table(
+    (char)(UTF8_CARRY | UTF8_OVERLONG_3 | UTF8_OVERLONG_2 | UTF8_OVERLONG_4),
+    (char)(UTF8_CARRY | UTF8_OVERLONG_2),
+    (char)UTF8_CARRY,
+    (char)UTF8_CARRY,
+    (char)(UTF8_CARRY | UTF8_TOO_LARGE),
+    (char)(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+    (char)(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+    (char)(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+    (char)(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+    (char)(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+    (char)(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+    (char)(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+    (char)(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+    (char)(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_SURROGATE),
+    (char)(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000),
+    (char)(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000)
+  );
+  const __m256i byte_2_high = utf8_table(
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+    (char)(UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4),
+    (char)(UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE),
+    (char)(UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE),
+    (char)(UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE),
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT
+  );
+  __m256i prev1 = utf8_prev<1>(input, prev);
+  __m256i special = _mm256_and_si256(
+    _mm256_and_si256(
+      _mm256_shuffle_epi8(byte_1_high, utf8_high_nibble(prev1)),
+      _mm256_shuffle_epi8(byte_1_low, _mm256_and_si256(prev1, _mm256_set1_epi8(0x0F)))
+    ),
+    _mm256_shuffle_epi8(byte_2_high, utf8_high_nibble(input))
+  );
+  /* Only bytes two or three after a lead of 0xE0 or more may be a second continuation. */
+  __m256i is_third  = _mm256_subs_epu8(utf8_prev<2>(input, prev), _mm256_set1_epi8((char)(0xE0 - 0x80)));
+  __m256i is_fourth = _mm256_subs_epu8(utf8_prev<3>(input, prev), _mm256_set1_epi8((char)(0xF0 - 0x80)));
+  __m256i must_23   = _mm256_and_si256(_mm256_or_si256(is_third, is_fourth), _mm256_set1_epi8((char)0x80));
+  return _mm256_xor_si256(must_23, special);
+}
+
+/* Non zero when the block ends inside a sequence, which the next block then has to complete. */
+__attribute((__target__("avx2"), __always_inline__)) static inline __m256i utf8_block_incomplete(__m256i input) {
+  const __m256i max = _mm256_setr_epi8(
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1)
+  );
+  return _mm256_subs_epu8(input, max);
+}
+
+/* The 32 bytes at 'str + i', zero padded past 'len', so the tail runs through the same code. */
+__attribute((__target__("avx2"), __always_inline__)) static inline __m256i utf8_load(const char *str, Ulong i, Ulong len) {
+  if ((i + 32) <= len) {
+    return _mm256_loadu_si256((const __m256i *)(str + i));
+  }
+  char tail[32] {};
+  memcpy(tail, (str + i), (len - i));
+  return _mm256_loadu_si256((const __m256i *)tail);
+}
+
+__attribute((__target__("avx2"))) static bool utf8_validate_avx2(const char *str, Ulong len) noexcept {
+  __m256i error      = _mm256_setzero_si256();
+  __m256i prev       = _mm256_setzero_si256();
+  __m256i incomplete = _mm256_setzero_si256();
+  for (Ulong i = 0; i < len; i += 32) {
+    __m256i input = utf8_load(str, i, len);
+    if (!_mm256_movemask_epi8(input)) {
+      /* All ascii, only a sequence left open by the last block can be wrong. */
+      error = _mm256_or_si256(error, incomplete);
+    }
+    else {
+      error      = _mm256_or_si256(error, utf8_block_errors(input, prev));
+      incomplete = utf8_block_incomplete(input);
+    }
+    prev = input;
+  }
+  error = _mm256_or_si256(error, incomplete);
+  return _mm256_testz_si256(error, error);
+}
+
+/* Bytes above 0xBF as signed are everything but continuation bytes. */
+__attribute((__target__("avx2"))) static Ulong utf8_count_avx2(const char *str, Ulong len) noexcept {
+  const __m256i last_cont = _mm256_set1_epi8((char)0xBF);
+  Ulong count = 0;
+  Ulong i     = 0;
+  for (; (i + 32) <= len; i += 32) {
+    __m256i input = _mm256_loadu_si256((const __m256i *)(str + i));
+    count += __builtin_popcount(_mm256_movemask_epi8(_mm256_cmpgt_epi8(input, last_cont)));
+  }
+  return utf8_count_scalar(str, i, len, count);
+}
+
+/* Widen a block of ascii straight to utf-32. */
+__attribute((__target__("avx2"))) static Ulong utf8_to_utf32_avx2(const char *str, Ulong len, char32_t *out) noexcept {
+  char32_t *start = out;
+  Ulong     i     = 0;
+  while ((i + 32) <= len) {
+    __m256i input = _mm256_loadu_si256((const __m256i *)(str + i));
+    if (!_mm256_movemask_epi8(input)) {
+      __m128i lo = _mm256_castsi256_si128(input);
+      __m128i hi = _mm256_extracti128_si256(input, 1);
+      _mm256_storeu_si256((__m256i *)(out + 0), _mm256_cvtepu8_epi32(lo));
+      _mm256_storeu_si256((__m256i *)(out + 8), _mm256_cvtepu8_epi32(_mm_srli_si128(lo, 8)));
+      _mm256_storeu_si256((__m256i *)(out + 16), _mm256_cvtepu8_epi32(hi));
+      _mm256_storeu_si256((__m256i *)(out + 24), _mm256_cvtepu8_epi32(_mm_srli_si128(hi, 8)));
+      out += 32;
+      i   += 32;
+      continue;
+    }
+    /* Decode past this block before looking for ascii again. */
+    for (Ulong end = (i + 32); i < end;) {
+      i += utf8_decode((str + i), (len - i), out++);
+    }
+  }
+  while (i < len) {
+    i += utf8_decode((str + i), (len - i), out++);
+  }
+  return (out - start);
+}
+
+/* Skip the blocks of printable ascii at 'str + i' that fit before 'end', width one per byte. */
+__attribute((__target__("avx2"))) static Ulong utf8_printable_run_avx2(const char *str, Ulong i, Ulong end) noexcept {
+  const __m256i space = _mm256_set1_epi8(0x1F);
+  const __m256i del   = _mm256_set1_epi8(0x7F);
+  for (; (i + 32) <= end; i += 32) {
+    __m256i input = _mm256_loadu_si256((const __m256i *)(str + i));
+    if ((Uint)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpgt_epi8(input, space), _mm256_cmpgt_epi8(del, input))) != 0xFFFFFFFFu) {
+      break;
+    }
+  }
+  return i;
+}
+
+#endif
+
+/* ---------------------------------------------------------- Public ---------------------------------------------------------- */
+
+/* Width of the codepoint at 'str + i', advancing 'i' past it. */
+__inline__ static Ulong __attribute((__always_inline__)) utf8_next_width(const char *str, Ulong &i, Ulong len) {
+  char32_t cp;
+  i += utf8_decode((str + i), (len - i), &cp);
+  int w = mwcwidth(cp);
+  return ((w > 0) ? w : 0);
+}
+
+bool utf8_validate(const char *str, Ulong len) noexcept {
+#if defined(__x86_64__)
+  if (utf8_avx2()) {
+    return utf8_validate_avx2(str, len);
+  }
+#endif
+  return utf8_validate_scalar(str, len);
+}
+
+Ulong utf8_count(const char *str, Ulong len) noexcept {
+#if defined(__x86_64__)
+  if (utf8_avx2()) {
+    return utf8_count_avx2(str, len);
+  }
+#endif
+  return utf8_count_scalar(str, 0, len, 0);
+}
+
+Ulong utf8_to_utf32(const char *str, Ulong len, char32_t *out) noexcept {
+#if defined(__x86_64__)
+  if (utf8_avx2()) {
+    return utf8_to_utf32_avx2(str, len, out);
+  }
+#endif
+  char32_t *start = out;
+  for (Ulong i = 0; i < len;) {
+    i += utf8_decode((str + i), (len - i), out++);
+  }
+  return (out - start);
+}
+
+/* Return`s the index past the printable ascii blocks at 'str + i', with no more then 'cols' bytes
+ * taken, or 'i' itself without avx2. */
+__inline__ static Ulong __attribute((__always_inline__)) utf8_printable_run(const char *str, Ulong i, Ulong len, Ulong cols) {
+#if defined(__x86_64__)
+  if (utf8_avx2()) {
+    return utf8_printable_run_avx2(str, i, (i + (((len - i) < cols) ? (len - i) : cols)));
+  }
+#endif
+  return i;
+}
+
+Ulong utf8_width(const char *str, Ulong len) noexcept {
+  Ulong width = 0;
+  Ulong i     = 0;
+  while (i < len) {
+    Ulong run = utf8_printable_run(str, i, len, len);
+    width += (run - i);
+    i      = run;
+    /* Decode past the next block, or to the end. */
+    for (Ulong end = (((i + 32) < len) ? (i + 32) : len); i < end;) {
+      width += utf8_next_width(str, i, len);
+    }
+  }
+  return width;
+}
+
+Ulong utf8_prefix_for_width(const char *str, Ulong len, Ulong cols) noexcept {
+  Ulong width = 0;
+  Ulong i     = 0;
+  while (i < len) {
+    Ulong run = utf8_printable_run(str, i, len, (cols - width));
+    width += (run - i);
+    i      = run;
+    for (Ulong end = (((i + 32) < len) ? (i + 32) : len); i < end;) {
+      Ulong next = i;
+      Ulong w    = utf8_next_width(str, next, len);
+      if ((width + w) > cols) {
+        return i;
+      }
+      width += w;
+      i      = next;
+    }
+  }
+  return i;
+}
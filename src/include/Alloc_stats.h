@@ -0,0 +1,74 @@
+#pragma once
+
+/* Optional allocator instrumentation.  Build with 'MLIB_ALLOC_STATS' defined to enable it,
+ * otherwise every 'ALLOC_STATS_*' macro expands to nothing and its arguments are never
+ * evaluated.  The collected numbers are appended to the 'GlobalProfiler' report. */
+
+#ifdef MLIB_ALLOC_STATS
+
+#include "Mint.h"
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+/* Counters for one allocation site.  Sites are keyed by tag and live for the whole program. */
+struct alloc_site_t {
+  const char        *tag;
+  alloc_site_t      *next;
+  std::atomic<Ulong> allocs;
+  std::atomic<Ulong> frees;
+  std::atomic<Ulong> total_bytes;   /* Every byte ever requested. */
+  std::atomic<Ulong> live_bytes;    /* Requested and not yet released. */
+  std::atomic<Ulong> peak_bytes;    /* High-water mark of 'live_bytes'. */
+  std::atomic<Ulong> padding_bytes; /* Lost to alignment, pools count it in the other totals as well. */
+  std::atomic<Ulong> wasted_bytes;  /* Abandoned, such as the tail of a full pool chunk. */
+
+  void record_alloc(Ulong bytes, Ulong padding = 0) noexcept;
+  void record_free(Ulong bytes) noexcept;
+  void record_realloc(Ulong old_bytes, Ulong new_bytes) noexcept;
+  void record_waste(Ulong bytes) noexcept;
+  /* Growth through realloc where the old size is not known, only counted, not tracked as live. */
+  void record_resize(Ulong new_bytes) noexcept;
+};
+
+/* Find or create the site for 'tag'.  Takes a lock, so cache the result. */
+alloc_site_t *alloc_stats_site(const char *tag) noexcept;
+/* One formatted line per site, used by the profiler report. */
+std::vector<std::string> alloc_stats_lines(void);
+
+/* The site for 'tag', looked up once per expansion. */
+#define ALLOC_STATS_SITE(tag)                             \
+  ([](const char *__tag) noexcept -> alloc_site_t * {     \
+    static alloc_site_t *__site = alloc_stats_site(__tag); \
+    return __site;                                        \
+  }(tag))
+/* Call 'method' on the site for 'tag'.  The arguments are evaluated at the expansion, so
+ * '__PRETTY_FUNCTION__' names the function that allocates.  Usable in constexpr functions,
+ * nothing is recorded during constant evaluation. */
+#define __ALLOC_STATS_CALL(tag, method, ...)                                     \
+  ([](const char *__tag, auto... __args) constexpr noexcept {                   \
+    if !consteval {                                                             \
+      ALLOC_STATS_SITE(__tag)->method((Ulong)__args...);                        \
+    }                                                                           \
+  }((tag), __VA_ARGS__))
+#define ALLOC_STATS_ALLOC(tag, bytes, padding)         __ALLOC_STATS_CALL(tag, record_alloc, (bytes), (padding))
+#define ALLOC_STATS_FREE(tag, bytes)                   __ALLOC_STATS_CALL(tag, record_free, (bytes))
+#define ALLOC_STATS_REALLOC(tag, old_bytes, new_bytes) __ALLOC_STATS_CALL(tag, record_realloc, (old_bytes), (new_bytes))
+#define ALLOC_STATS_WASTE(tag, bytes)                  __ALLOC_STATS_CALL(tag, record_waste, (bytes))
+#define ALLOC_STATS_RESIZE(tag, new_bytes)             __ALLOC_STATS_CALL(tag, record_resize, (new_bytes))
+/* Only use this for code that exists solely to feed the stats. */
+#define ALLOC_STATS_ONLY(...) __VA_ARGS__
+
+#else
+
+/* The arguments are named in an unevaluated 'sizeof', so parameters that only feed the stats do
+ * not warn as unused, without evaluating anything. */
+#define ALLOC_STATS_ALLOC(tag, bytes, padding)         ((void)sizeof(bytes), (void)sizeof(padding))
+#define ALLOC_STATS_FREE(tag, bytes)                   ((void)sizeof(bytes))
+#define ALLOC_STATS_REALLOC(tag, old_bytes, new_bytes) ((void)sizeof(old_bytes), (void)sizeof(new_bytes))
+#define ALLOC_STATS_WASTE(tag, bytes)                  ((void)sizeof(bytes))
+#define ALLOC_STATS_RESIZE(tag, new_bytes)             ((void)sizeof(new_bytes))
+#define ALLOC_STATS_ONLY(...)
+
+#endif
@@ -3,6 +3,7 @@
 #include <cstring>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "def.h"
@@ -27,7 +28,7 @@ namespace Mlib ::Args
     /// @param argV
     /// - The arguments.
     /// @returns string
-    std::string flagValue(const std::string &flag, int argC, char **argV);
+    std::string flagValue(std::string_view flag, int argC, char **argV);
 
     /// @name flagExists
     /// @brief
@@ -39,7 +40,7 @@ namespace Mlib ::Args
     /// @param argV
     /// - The arguments.
     /// @returns bool
-    bool flagExists(const std::string &flag, int argC, char **argV);
+    bool flagExists(std::string_view flag, int argC, char **argV);
 
     /// @name flagValuesToStrVec
     /// @brief
@@ -66,6 +67,11 @@ namespace Mlib ::Args
     /// @returns vector<string>
     std::vector<std::string> strVecFromStr(const std::string &str, char delim);
 
+    /// @name strViewVecFromStr
+    /// @brief
+    /// - Like 'strVecFromStr()', but the parts are views into 'str' instead of copies.
+    std::vector<std::string_view> strViewVecFromStr(std::string_view str, char delim);
+
     /// @name strFromStrVec
     /// @brief
     /// - Converts a vector of strings to a single string.
@@ -81,11 +87,92 @@ namespace Mlib ::Args
         vec.erase(std::remove(vec.begin(), vec.end(), objToErase), vec.end());
     }
 
+    /// @name Token
+    /// @brief
+    /// - One token of a 'Tokenizer'.  'text' always points into the tokenized string.  When 'raw'
+    ///   is set it still holds quotes or escapes, and 'Tokenizer::unquote()' gives the value.
+    struct Token
+    {
+        std::string_view text;
+        bool             raw;
+    };
+
+    /// @name Tokenizer
+    /// @brief
+    /// - Splits a string on any of a set of delimiter bytes without copying it, empty tokens are
+    ///   skipped.  With 'quotes' set, '"' and '\'' group delimiters into one token and '\\' escapes
+    ///   the byte after it, like a shell.  Inside double quotes '\\' only escapes '"', '\\', '$', '`'
+    ///   and newline, before anything else it is kept.  Unlike a shell an escaped newline is kept
+    ///   as well.  A token that is just one quoted string without escapes is given without the
+    ///   quotes and is not 'raw', so only tokens with escapes or mixed quoting need 'unquote()'.
+    /// - The delimiters and quotes are found 32 bytes at a time with avx2, using a lookup of the
+    ///   low and high nibble of every byte.
+    /// @code
+    ///   Tokenizer tok(R"(ls -l "My Documents")");
+    ///   for (Token t; tok.next(t);) {}
+    /// @endcode
+    class Tokenizer
+    {
+      private:
+        const char *_str;
+        Ulong       _len;
+        Ulong       _pos;
+        bool        _delim[256];
+        bool        _special[256]; /* Delimiters, and the quotes and escape when enabled. */
+        Uchar       _lut_lo[16];
+        Uchar       _lut_hi[16];
+
+        Ulong _find_special(Ulong i) const noexcept;
+        Ulong _find_quote(Ulong i, char quote, bool &escaped) const noexcept;
+
+      public:
+        explicit Tokenizer(std::string_view str, std::string_view delims = " \t\r\n", bool quotes = true) noexcept;
+
+        /// @returns false when there are no tokens left.
+        bool next(Token &token) noexcept;
+
+        /// @brief
+        /// - Write the value of 'raw' to 'out', which needs room for 'raw.size()' bytes.
+        /// @returns The length written.
+        static Ulong unquote(std::string_view raw, char *out) noexcept;
+    };
+
     //
     //  Helper function to split a command str into a tokens and create a vector<string_views>
     //
     std::vector<std::string_view> tokenizeCommand(std::string_view command);
 
+    /// @name ArgIndex
+    /// @brief
+    /// - Index of the flags in 'argv', built in one pass so every lookup after is a hash probe
+    ///   instead of a scan.  Every argument after 'argv[0]' that starts with '-' is a flag, upto
+    ///   a lone "--".  "--name=value" is indexed as "--name" with the value after '=', otherwise
+    ///   the value of a flag is the argument after it.  The first of repeated flags wins.
+    /// - Nothing is copied, 'argv' must outlive the index.
+    class ArgIndex
+    {
+      private:
+        struct slot_t
+        {
+            std::string_view flag;  /* 'data()' is nullptr while empty. */
+            int              index; /* Where in 'argv' it is. */
+        };
+
+        std::vector<slot_t> _slots;
+        int                 _argc;
+        char              **_argv;
+
+        const slot_t *_find(std::string_view flag) const noexcept;
+
+      public:
+        ArgIndex(int argc, char **argv);
+
+        bool exists(std::string_view flag) const noexcept;
+
+        /// @returns false when 'flag' is not given or has no value.
+        bool value(std::string_view flag, std::string_view &out) const noexcept;
+    };
+
     //
     //  Function to construct the argument list for the execv function.
     //  This function also adds a filename to the argument list.
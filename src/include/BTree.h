@@ -0,0 +1,446 @@
+#pragma once
+/* clang-format off */
+
+#include "Attributes.h"
+#include "Debug.h"
+#include "def.h"
+
+#include <algorithm>
+#include <functional>
+#include <new>
+
+/* Default fan-out of 'MBTree', enough entries to fill about 512 bytes per leaf, bounded to
+ * keep tiny keys from producing huge nodes and large ones from degrading into a binary tree. */
+template <class K, class V>
+inline constexpr Uint mbtree_default_order = std::clamp<Uint>((512 / (sizeof(K) + sizeof(V))), 8, 64);
+
+/* B+tree with wide nodes.  Every entry lives in a leaf, leaves are linked in key order, so an
+ * ordered walk scans each leaf as two contiguous arrays and only hops once per 'Order' entries.
+ * Lookup touches one node per level, 'Order' keys at a time.  Erase never merges nodes, a node is
+ * released once it runs empty, which keeps every lookup correct at the cost of some slack after
+ * heavy removal.  Values are shifted within their leaf, so any insert into or erase from the
+ * leaf holding a value invalidates pointers and iterators to it, as does a split of that leaf.
+ *
+ *   MBTree<Ulong, Uint> index;
+ *   index.insert_or_assign(offset, line);
+ *   for (auto it = index.lower_bound(from); it != index.end() && it.key() < to; ++it) {}
+ */
+template <class K, class V, class Less = std::less<>, Uint Order = mbtree_default_order<K, V>>
+class MBTree {
+  static_assert(Order >= 4, "MBTree order must be atleast 4.");
+
+  struct leaf_t {
+    Uint    count;
+    leaf_t *prev;
+    leaf_t *next;
+    K       keys[Order];
+    V       values[Order];
+  };
+
+  /* 'count' keys separate 'count + 1' children, 'keys[i]' is the smallest key below 'children[i + 1]'. */
+  struct inner_t {
+    Uint  count;
+    K     keys[Order];
+    void *children[Order + 1];
+  };
+
+  /* A node split during insertion hands its new right sibling and the key that separates them up. */
+  struct split_t {
+    K     key;
+    void *node;
+  };
+
+ public:
+  template <bool Const>
+  class iterator_t {
+    friend class MBTree;
+    template <bool> friend class iterator_t;
+
+    using val_t = std::conditional_t<Const, const V, V>;
+
+    leaf_t *_leaf;
+    Uint    _idx;
+
+    iterator_t(leaf_t *leaf, Uint idx) noexcept : _leaf(leaf), _idx(idx) {
+      if (_leaf && _idx == _leaf->count) {
+        _leaf = _leaf->next;
+        _idx  = 0;
+      }
+    }
+
+   public:
+    iterator_t(void) noexcept : _leaf(nullptr), _idx(0) {}
+
+    /* Allow 'iterator' to 'const_iterator'. */
+    template <bool C = Const> requires (C)
+    iterator_t(const iterator_t<false> &other) noexcept : _leaf(other._leaf), _idx(other._idx) {}
+
+    std::pair<const K &, val_t &> operator*(void) const noexcept {
+      return {_leaf->keys[_idx], _leaf->values[_idx]};
+    }
+
+    const K &key(void) const noexcept {
+      return _leaf->keys[_idx];
+    }
+
+    val_t &value(void) const noexcept {
+      return _leaf->values[_idx];
+    }
+
+    iterator_t &operator++(void) noexcept {
+      if (++_idx == _leaf->count) {
+        _leaf = _leaf->next;
+        _idx  = 0;
+      }
+      return *this;
+    }
+
+    bool operator==(const iterator_t &other) const noexcept {
+      return (_leaf == other._leaf && _idx == other._idx);
+    }
+
+    bool operator!=(const iterator_t &other) const noexcept {
+      return !(*this == other);
+    }
+  };
+
+  using iterator       = iterator_t<false>;
+  using const_iterator = iterator_t<true>;
+
+ private:
+  void   *_root;
+  leaf_t *_first;
+  Uint    _height; /* Levels above the leaves. */
+  Ulong   _len;
+  [[no_unique_address]] Less _less;
+
+  template <class N>
+  static N *_alloc_node(void) {
+    N *node = new (std::nothrow) N();
+    if (!node) {
+      logE("MBTree failed to allocate a node.");
+      exit(1);
+    }
+    return node;
+  }
+
+  template <class Q>
+  __inline__ Uint __attribute((__always_inline__, __nodebug__)) _child_of(const inner_t *node, const Q &key) const {
+    return (std::upper_bound(node->keys, (node->keys + node->count), key, _less) - node->keys);
+  }
+
+  template <class Q>
+  __inline__ Uint __attribute((__always_inline__, __nodebug__)) _slot_of(const leaf_t *leaf, const Q &key) const {
+    return (std::lower_bound(leaf->keys, (leaf->keys + leaf->count), key, _less) - leaf->keys);
+  }
+
+  template <class Q>
+  leaf_t *_leaf_for(const Q &key) const {
+    void *node = _root;
+    for (Uint level = _height; level; --level) {
+      inner_t *inner = (inner_t *)node;
+      node = inner->children[_child_of(inner, key)];
+    }
+    return (leaf_t *)node;
+  }
+
+  template <class Q>
+  iterator _find(const Q &key) const {
+    if (!_root) {
+      return iterator();
+    }
+    leaf_t *leaf = _leaf_for(key);
+    Uint    idx  = _slot_of(leaf, key);
+    if (idx < leaf->count && !_less(key, leaf->keys[idx])) {
+      return iterator(leaf, idx);
+    }
+    return iterator();
+  }
+
+  /* Insert into 'leaf' at 'idx', splitting it when full.  Return`s the new entry`s value. */
+  template <class Q>
+  V *_leaf_insert(leaf_t *leaf, Uint idx, Q &&key, split_t *split) {
+    if (leaf->count == Order) {
+      leaf_t *right = _alloc_node<leaf_t>();
+      Uint    half  = (Order / 2);
+      std::move((leaf->keys + half), (leaf->keys + Order), right->keys);
+      std::move((leaf->values + half), (leaf->values + Order), right->values);
+      right->count = (Order - half);
+      leaf->count  = half;
+      right->prev  = leaf;
+      right->next  = leaf->next;
+      if (leaf->next) {
+        leaf->next->prev = right;
+      }
+      leaf->next  = right;
+      split->node = right;
+      if (idx > half) {
+        leaf = right;
+        idx -= half;
+      }
+      V *value = _leaf_insert(leaf, idx, std::forward<Q>(key), nullptr);
+      split->key = right->keys[0];
+      return value;
+    }
+    std::move_backward((leaf->keys + idx), (leaf->keys + leaf->count), (leaf->keys + leaf->count + 1));
+    std::move_backward((leaf->values + idx), (leaf->values + leaf->count), (leaf->values + leaf->count + 1));
+    leaf->keys[idx]   = K(std::forward<Q>(key));
+    leaf->values[idx] = V();
+    ++leaf->count;
+    return &leaf->values[idx];
+  }
+
+  /* Insert the separator and right child of a split below 'children[idx]', splitting 'node' in
+   * turn when it is full. */
+  void _inner_insert(inner_t *node, Uint idx, split_t &below, split_t *split) {
+    if (node->count == Order) {
+      inner_t *right = _alloc_node<inner_t>();
+      Uint     half  = (Order / 2);
+      /* 'keys[half]' moves up, the halves keep the keys on either side of it. */
+      std::move((node->keys + half + 1), (node->keys + Order), right->keys);
+      std::copy((node->children + half + 1), (node->children + Order + 1), right->children);
+      right->count = (Order - half - 1);
+      node->count  = half;
+      split->key   = std::move(node->keys[half]);
+      split->node  = right;
+      if (idx > half) {
+        node = right;
+        idx -= (half + 1);
+      }
+    }
+    std::move_backward((node->keys + idx), (node->keys + node->count), (node->keys + node->count + 1));
+    std::copy_backward((node->children + idx + 1), (node->children + node->count + 1), (node->children + node->count + 2));
+    node->keys[idx]         = std::move(below.key);
+    node->children[idx + 1] = below.node;
+    ++node->count;
+  }
+
+  template <class Q>
+  std::pair<V *, bool> _insert(void *node, Uint level, Q &&key, split_t &split, bool &did_split) {
+    if (!level) {
+      leaf_t *leaf = (leaf_t *)node;
+      Uint    idx  = _slot_of(leaf, key);
+      if (idx < leaf->count && !_less(key, leaf->keys[idx])) {
+        return {&leaf->values[idx], false};
+      }
+      did_split = (leaf->count == Order);
+      return {_leaf_insert(leaf, idx, std::forward<Q>(key), &split), true};
+    }
+    inner_t *inner = (inner_t *)node;
+    Uint     idx   = _child_of(inner, key);
+    split_t  below;
+    bool     child_split = false;
+    auto     ret = _insert(inner->children[idx], (level - 1), std::forward<Q>(key), below, child_split);
+    if (child_split) {
+      did_split = (inner->count == Order);
+      _inner_insert(inner, idx, below, &split);
+    }
+    return ret;
+  }
+
+  /* Return`s true when 'node' ran empty and was released, the caller then drops it. */
+  template <class Q>
+  bool _erase(void *node, Uint level, const Q &key, bool &found) {
+    if (!level) {
+      leaf_t *leaf = (leaf_t *)node;
+      Uint    idx  = _slot_of(leaf, key);
+      if (idx == leaf->count || _less(key, leaf->keys[idx])) {
+        return false;
+      }
+      found = true;
+      std::move((leaf->keys + idx + 1), (leaf->keys + leaf->count), (leaf->keys + idx));
+      std::move((leaf->values + idx + 1), (leaf->values + leaf->count), (leaf->values + idx));
+      --leaf->count;
+      leaf->keys[leaf->count]   = K();
+      leaf->values[leaf->count] = V();
+      if (leaf->count || node == _root) {
+        return false;
+      }
+      (leaf->prev ? leaf->prev->next : _first) = leaf->next;
+      if (leaf->next) {
+        leaf->next->prev = leaf->prev;
+      }
+      delete leaf;
+      return true;
+    }
+    inner_t *inner = (inner_t *)node;
+    Uint     idx   = _child_of(inner, key);
+    if (!_erase(inner->children[idx], (level - 1), key, found)) {
+      return false;
+    }
+    if (!inner->count) {
+      delete inner;
+      return true;
+    }
+    /* Drop the child together with the separator on its left, or on its right for the first. */
+    Uint sep = (idx ? (idx - 1) : 0);
+    std::move((inner->keys + sep + 1), (inner->keys + inner->count), (inner->keys + sep));
+    std::copy((inner->children + idx + 1), (inner->children + inner->count + 1), (inner->children + idx));
+    --inner->count;
+    inner->keys[inner->count] = K();
+    return false;
+  }
+
+  void _free(void *node, Uint level) noexcept {
+    if (level) {
+      inner_t *inner = (inner_t *)node;
+      for (Uint i = 0; i <= inner->count; ++i) {
+        _free(inner->children[i], (level - 1));
+      }
+      delete inner;
+    }
+    else {
+      delete (leaf_t *)node;
+    }
+  }
+
+ public:
+  MBTree(void) noexcept : _root(nullptr), _first(nullptr), _height(0), _len(0) {}
+
+  MBTree(MBTree &&other) noexcept : _root(other._root), _first(other._first), _height(other._height), _len(other._len) {
+    other._root   = nullptr;
+    other._first  = nullptr;
+    other._height = 0;
+    other._len    = 0;
+  }
+
+  MBTree(const MBTree &) = delete;
+  MBTree &operator=(const MBTree &) = delete;
+
+  ~MBTree(void) noexcept {
+    clear();
+  }
+
+  MBTree &operator=(MBTree &&other) noexcept {
+    if (this != &other) {
+      clear();
+      std::swap(_root, other._root);
+      std::swap(_first, other._first);
+      std::swap(_height, other._height);
+      std::swap(_len, other._len);
+    }
+    return *this;
+  }
+
+  /* Return`s the value for 'key', default constructed when it was not present, and whether it
+   * was inserted. */
+  template <class Q = K>
+  std::pair<V *, bool> try_emplace(Q &&key) {
+    if (!_root) {
+      _root = _first = _alloc_node<leaf_t>();
+    }
+    split_t split;
+    bool    did_split = false;
+    auto    ret = _insert(_root, _height, std::forward<Q>(key), split, did_split);
+    if (did_split) {
+      inner_t *root     = _alloc_node<inner_t>();
+      root->count       = 1;
+      root->keys[0]     = std::move(split.key);
+      root->children[0] = _root;
+      root->children[1] = split.node;
+      _root             = root;
+      ++_height;
+    }
+    _len += ret.second;
+    return ret;
+  }
+
+  template <class Q = K, class T>
+  std::pair<V *, bool> insert_or_assign(Q &&key, T &&value) {
+    auto ret = try_emplace(std::forward<Q>(key));
+    *ret.first = std::forward<T>(value);
+    return ret;
+  }
+
+  template <class Q = K>
+  V &operator[](Q &&key) {
+    return *try_emplace(std::forward<Q>(key)).first;
+  }
+
+  template <class Q = K>
+  iterator find(const Q &key) {
+    return _find(key);
+  }
+
+  template <class Q = K>
+  const_iterator find(const Q &key) const {
+    return _find(key);
+  }
+
+  /* First entry whose key is not less then 'key'. */
+  template <class Q = K>
+  iterator lower_bound(const Q &key) {
+    if (!_root) {
+      return iterator();
+    }
+    leaf_t *leaf = _leaf_for(key);
+    return iterator(leaf, _slot_of(leaf, key));
+  }
+
+  template <class Q = K>
+  const_iterator lower_bound(const Q &key) const {
+    return const_cast<MBTree *>(this)->lower_bound(key);
+  }
+
+  template <class Q = K>
+  bool contains(const Q &key) const {
+    return (_find(key) != iterator());
+  }
+
+  /* Return`s the number of entries removed, zero or one. */
+  template <class Q = K>
+  Ulong erase(const Q &key) {
+    if (!_root) {
+      return 0;
+    }
+    bool found = false;
+    if (_erase(_root, _height, key, found)) {
+      _root   = nullptr;
+      _first  = nullptr;
+      _height = 0;
+    }
+    _len -= found;
+    /* Collapse a root left with a single child. */
+    while (_height && !((inner_t *)_root)->count) {
+      void *child = ((inner_t *)_root)->children[0];
+      delete (inner_t *)_root;
+      _root = child;
+      --_height;
+    }
+    return found;
+  }
+
+  void clear(void) noexcept {
+    if (_root) {
+      _free(_root, _height);
+    }
+    _root   = nullptr;
+    _first  = nullptr;
+    _height = 0;
+    _len    = 0;
+  }
+
+  Ulong size(void) const noexcept {
+    return _len;
+  }
+
+  bool empty(void) const noexcept {
+    return !_len;
+  }
+
+  iterator begin(void) {
+    return iterator(_first, 0);
+  }
+
+  iterator end(void) {
+    return iterator();
+  }
+
+  const_iterator begin(void) const {
+    return const_iterator(_first, 0);
+  }
+
+  const_iterator end(void) const {
+    return const_iterator();
+  }
+};
@@ -0,0 +1,356 @@
+#pragma once
+/* clang-format off */
+
+#include "Attributes.h"
+#include "Debug.h"
+#include "def.h"
+
+#include <bit>
+#include <cstring>
+#ifdef __AVX2__
+#  include <immintrin.h>
+#endif
+
+/* Return`ed by searches that find no set bit. */
+#define MBITSET_NPOS ((Ulong)-1)
+/* Words per block, one 256 bit avx2 register.  Storage is always a whole number of blocks. */
+#define MBITSET_BLOCK_WORDS 4
+
+namespace /* Defines. */ {
+  #define __ref   __inline__ MBitset & __attribute((__always_inline__, __nothrow__, __nodebug__))
+  #define __bool  __inline__ bool __warn_unused __attribute((__always_inline__, __nothrow__, __nodebug__))
+  #define __Ulong __inline__ Ulong __warn_unused __attribute((__always_inline__, __nothrow__, __nodebug__))
+  #define __void  __inline__ void __attribute((__always_inline__, __nothrow__, __nodebug__))
+}
+
+/* Dynamic bitset over 64 bit words.  Storage is 32 byte aligned and padded to whole 256 bit
+ * blocks, with every bit past 'size()' kept zero, so the bulk operators run a block at a time with
+ * avx2 and no scalar tail, and counting and searching never have to mask the last word.
+ * Searches use tzcnt per word, so walking the set bits costs one step per set bit plus one per
+ * empty word.
+ *
+ *   MBitset visited(nodes);
+ *   visited.set(start);
+ *   for (Ulong i = visited.first_set(); i != MBITSET_NPOS; i = visited.next_set(i + 1)) {}
+ */
+class MBitset {
+  Ulong *_words;
+  Ulong  _bits;
+  Ulong  _cap;   /* Words allocated, a multiple of 'MBITSET_BLOCK_WORDS'. */
+
+  static constexpr Ulong _words_for(Ulong bits) noexcept {
+    return (((bits + 63) / 64 + (MBITSET_BLOCK_WORDS - 1)) & ~(Ulong)(MBITSET_BLOCK_WORDS - 1));
+  }
+
+  /* Words actually holding bits, the rest of the storage is zero. */
+  __Ulong _used(void) const noexcept {
+    return ((_bits + 63) / 64);
+  }
+
+  void __attribute((__noinline__)) _grow(Ulong words) noexcept {
+    Ulong *ptr = (Ulong *)aligned_alloc(32, (words * sizeof(Ulong)));
+    if (!ptr) {
+      logE("MBitset failed to grow to %lu words.", words);
+      exit(1);
+    }
+    if (_cap) {
+      memcpy(ptr, _words, (_cap * sizeof(Ulong)));
+    }
+    memset((ptr + _cap), 0, ((words - _cap) * sizeof(Ulong)));
+    free(_words);
+    _words = ptr;
+    _cap   = words;
+  }
+
+  /* Zero every bit of the storage that lies past 'size()'. */
+  __void _trim(void) noexcept {
+    if (_bits % 64) {
+      _words[_bits / 64] &= ((1ul << (_bits % 64)) - 1);
+    }
+    if (_cap > _used()) {
+      memset((_words + _used()), 0, ((_cap - _used()) * sizeof(Ulong)));
+    }
+  }
+
+  /* Apply 'op' to the bits '[from, to)', a word at a time. */
+  template <typename Op>
+  __void _range(Ulong from, Ulong to, Op op) noexcept {
+    if (to > _bits) {
+      to = _bits;
+    }
+    if (from >= to) {
+      return;
+    }
+    Ulong first = (from / 64);
+    Ulong last  = ((to - 1) / 64);
+    Ulong head  = (~0ul << (from % 64));
+    Ulong tail  = (~0ul >> (63 - ((to - 1) % 64)));
+    if (first == last) {
+      op(_words[first], (head & tail));
+      return;
+    }
+    op(_words[first], head);
+    for (Ulong i = (first + 1); i < last; ++i) {
+      op(_words[i], ~0ul);
+    }
+    op(_words[last], tail);
+  }
+
+#ifdef __AVX2__
+  template <typename Op>
+  __void _bulk(const MBitset &other, Op op) noexcept {
+    Ulong n = ((_cap < other._cap) ? _cap : other._cap);
+    for (Ulong i = 0; i < n; i += MBITSET_BLOCK_WORDS) {
+      __m256i a = _mm256_load_si256((const __m256i *)(_words + i));
+      __m256i b = _mm256_load_si256((const __m256i *)(other._words + i));
+      _mm256_store_si256((__m256i *)(_words + i), op(a, b));
+    }
+  }
+#endif
+
+ public:
+  /* Constructors. */
+  MBitset(void) noexcept : _words(nullptr), _bits(0), _cap(0) {}
+
+  explicit MBitset(Ulong bits) noexcept : MBitset() {
+    resize(bits);
+  }
+
+  MBitset(const MBitset &other) noexcept : MBitset() {
+    *this = other;
+  }
+
+  MBitset(MBitset &&other) noexcept : _words(other._words), _bits(other._bits), _cap(other._cap) {
+    other._words = nullptr;
+    other._bits  = 0;
+    other._cap   = 0;
+  }
+
+  /* Destructor. */
+  ~MBitset(void) noexcept {
+    free(_words);
+  }
+
+  __ref operator=(const MBitset &other) noexcept {
+    if (this != &other) {
+      if (_cap < other._cap) {
+        _grow(other._cap);
+      }
+      if (other._cap) {
+        memcpy(_words, other._words, (other._cap * sizeof(Ulong)));
+      }
+      if (_cap > other._cap) {
+        memset((_words + other._cap), 0, ((_cap - other._cap) * sizeof(Ulong)));
+      }
+      _bits = other._bits;
+    }
+    return *this;
+  }
+
+  __ref operator=(MBitset &&other) noexcept {
+    if (this != &other) {
+      free(_words);
+      _words = other._words;
+      _bits  = other._bits;
+      _cap   = other._cap;
+      other._words = nullptr;
+      other._bits  = 0;
+      other._cap   = 0;
+    }
+    return *this;
+  }
+
+  /* New bits start cleared. */
+  __ref resize(Ulong bits) noexcept {
+    if (bits < _bits) {
+      _bits = bits;
+      _trim();
+    }
+    else {
+      if (_words_for(bits) > _cap) {
+        _grow(_words_for(bits));
+      }
+      _bits = bits;
+    }
+    return *this;
+  }
+
+  __Ulong size(void) const noexcept {
+    return _bits;
+  }
+
+  __void set(Ulong bit) noexcept {
+    _words[bit / 64] |= (1ul << (bit % 64));
+  }
+
+  __void unset(Ulong bit) noexcept {
+    _words[bit / 64] &= ~(1ul << (bit % 64));
+  }
+
+  __void toggle(Ulong bit) noexcept {
+    _words[bit / 64] ^= (1ul << (bit % 64));
+  }
+
+  __bool is_set(Ulong bit) const noexcept {
+    return ((_words[bit / 64] >> (bit % 64)) & 1);
+  }
+
+  /* Set the bits '[from, to)'. */
+  __void set_range(Ulong from, Ulong to) noexcept {
+    _range(from, to, [](Ulong &word, Ulong mask) { word |= mask; });
+  }
+
+  /* Clear the bits '[from, to)'. */
+  __void unset_range(Ulong from, Ulong to) noexcept {
+    _range(from, to, [](Ulong &word, Ulong mask) { word &= ~mask; });
+  }
+
+  __void set_all(void) noexcept {
+    if (_bits) {
+      memset(_words, 0xFF, ((_bits / 64) * sizeof(Ulong)));
+      if (_bits % 64) {
+        _words[_bits / 64] = ~0ul;
+        _trim();
+      }
+    }
+  }
+
+  __void clear(void) noexcept {
+    if (_cap) {
+      memset(_words, 0, (_used() * sizeof(Ulong)));
+    }
+  }
+
+  /* Number of set bits. */
+  Ulong count(void) const noexcept {
+    Ulong n = 0;
+#ifdef __AVX2__
+    /* Nibble lookup popcount, the byte counts are summed into 64 bit lanes with 'sad'. */
+    const __m256i lut  = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low  = _mm256_set1_epi8(0x0F);
+    __m256i       acc  = _mm256_setzero_si256();
+    for (Ulong i = 0; i < _cap; i += MBITSET_BLOCK_WORDS) {
+      __m256i v   = _mm256_load_si256((const __m256i *)(_words + i));
+      __m256i cnt = _mm256_add_epi8(_mm256_shuffle_epi8(lut, _mm256_and_si256(v, low)), _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), low)));
+      acc = _mm256_add_epi64(acc, _mm256_sad_epu8(cnt, _mm256_setzero_si256()));
+    }
+    n = (_mm256_extract_epi64(acc, 0) + _mm256_extract_epi64(acc, 1) + _mm256_extract_epi64(acc, 2) + _mm256_extract_epi64(acc, 3));
+#else
+    for (Ulong i = 0, used = _used(); i < used; ++i) {
+      n += std::popcount(_words[i]);
+    }
+#endif
+    return n;
+  }
+
+  __bool any(void) const noexcept {
+    return (first_set() != MBITSET_NPOS);
+  }
+
+  __bool is_clear(void) const noexcept {
+    return !any();
+  }
+
+  /* Return`s the first set bit at or after 'from', or 'MBITSET_NPOS'. */
+  Ulong next_set(Ulong from) const noexcept {
+    if (from >= _bits) {
+      return MBITSET_NPOS;
+    }
+    Ulong i    = (from / 64);
+    Ulong used = _used();
+    Ulong word = (_words[i] & (~0ul << (from % 64)));
+    while (!word) {
+      if (++i == used) {
+        return MBITSET_NPOS;
+      }
+      word = _words[i];
+    }
+    return ((i * 64) + std::countr_zero(word));
+  }
+
+  __Ulong first_set(void) const noexcept {
+    return next_set(0);
+  }
+
+  /* Call 'f(Ulong bit)' for every set bit, in order. */
+  template <typename F>
+  __void for_each_set(F &&f) const {
+    for (Ulong i = 0, used = _used(); i < used; ++i) {
+      for (Ulong word = _words[i]; word; word &= (word - 1)) {
+        f((i * 64) + std::countr_zero(word));
+      }
+    }
+  }
+
+  /* The bulk operators combine the common prefix of both sets, bits past the end of 'other' count
+   * as clear.  Sizes stay as they are. */
+  __ref operator|=(const MBitset &other) noexcept {
+#ifdef __AVX2__
+    _bulk(other, [](__m256i a, __m256i b) { return _mm256_or_si256(a, b); });
+#else
+    for (Ulong i = 0, n = ((_cap < other._cap) ? _cap : other._cap); i < n; ++i) {
+      _words[i] |= other._words[i];
+    }
+#endif
+    _trim();
+    return *this;
+  }
+
+  __ref operator&=(const MBitset &other) noexcept {
+#ifdef __AVX2__
+    _bulk(other, [](__m256i a, __m256i b) { return _mm256_and_si256(a, b); });
+#else
+    for (Ulong i = 0, n = ((_cap < other._cap) ? _cap : other._cap); i < n; ++i) {
+      _words[i] &= other._words[i];
+    }
+#endif
+    if (_cap > other._cap) {
+      memset((_words + other._cap), 0, ((_cap - other._cap) * sizeof(Ulong)));
+    }
+    return *this;
+  }
+
+  __ref operator^=(const MBitset &other) noexcept {
+#ifdef __AVX2__
+    _bulk(other, [](__m256i a, __m256i b) { return _mm256_xor_si256(a, b); });
+#else
+    for (Ulong i = 0, n = ((_cap < other._cap) ? _cap : other._cap); i < n; ++i) {
+      _words[i] ^= other._words[i];
+    }
+#endif
+    _trim();
+    return *this;
+  }
+
+  /* Clear every bit that is set in 'other', 'this &= ~other'. */
+  __ref andnot(const MBitset &other) noexcept {
+#ifdef __AVX2__
+    _bulk(other, [](__m256i a, __m256i b) { return _mm256_andnot_si256(b, a); });
+#else
+    for (Ulong i = 0, n = ((_cap < other._cap) ? _cap : other._cap); i < n; ++i) {
+      _words[i] &= ~other._words[i];
+    }
+#endif
+    return *this;
+  }
+
+  __bool operator==(const MBitset &other) const noexcept {
+    return (_bits == other._bits && (!_bits || !memcmp(_words, other._words, (_used() * sizeof(Ulong)))));
+  }
+
+  /* Raw words, 'size() / 64' rounded up of them hold bits.  Writers must keep bits past 'size()' clear. */
+  __inline__ Ulong *__warn_unused __attribute((__always_inline__, __nothrow__, __nodebug__)) data(void) noexcept {
+    return _words;
+  }
+
+  __inline__ const Ulong *__warn_unused __attribute((__always_inline__, __nothrow__, __nodebug__)) data(void) const noexcept {
+    return _words;
+  }
+};
+
+namespace /* Undef defines. */ {
+  #undef __ref
+  #undef __bool
+  #undef __Ulong
+  #undef __void
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Attributes.h"
+#include "def.h"
+
+/* Number to text and back, without locale, allocation or terminators.  Everything writes into or
+ * reads from a buffer the caller owns and return`s the number of bytes used, so lines can be built
+ * with one pointer bump per field.
+ *
+ *   char  buf[CONV_U64_MAX + 1];
+ *   Uint  len = conv_u64(count, buf);
+ *   buf[len]  = '\0';
+ *
+ *   Ulong value;
+ *   if (conv_parse_u64(str, len, &value, nullptr)) {}
+ */
+
+/* Bytes 'conv_u64()' and 'conv_i64()' may write, at most. */
+#define CONV_U64_MAX 20
+#define CONV_I64_MAX 21
+/* Bytes 'conv_f64()' may write, at most.  "-2.2250738585072014e-308" is the longest. */
+#define CONV_F64_MAX 24
+/* Pass as 'len' to the parse functions when 'str' is terminated and its length is not known, the
+ * digits are then read upto the first byte that is not one, like 'strtol()' does. */
+#define CONV_TERMINATED ((Ulong)-1)
+
+/* Return`s the number of decimal digits in 'value'. */
+Uint conv_digits(Ulong value) noexcept;
+/* Write 'value' in decimal to 'buf', two digits at a time from a table.  Return`s the length. */
+Uint conv_u64(Ulong value, char *buf) noexcept;
+Uint conv_i64(long value, char *buf) noexcept;
+/* The shortest text that parses back to exactly 'value', in plain or exponent form, whichever is
+ * shorter.  Return`s the length, atmost 'CONV_F64_MAX'. */
+Uint conv_f64(double value, char *buf) noexcept;
+/* 'value' with 'precision' digits after the point, like "%.*f".  Return`s the length, or zero
+ * when it does not fit in 'size' bytes. */
+Uint conv_f64_fixed(double value, int precision, char *buf, Ulong size) noexcept;
+
+/* Parse the decimal digits at the start of 'str', eight at a time.  Return`s false when there are
+ * none or the value does not fit, then 'out' is left as is.  When 'used' is not nullptr it gets the
+ * number of digits scanned, also on overflow, so the caller can tell the two apart. */
+bool conv_parse_u64(const char *str, Ulong len, Ulong *out, Ulong *used) noexcept;
+/* Like 'conv_parse_u64()' with an optional leading '-' or '+', which 'used' includes. */
+bool conv_parse_i64(const char *str, Ulong len, long *out, Ulong *used) noexcept;
+/* Parse a decimal floating point number, exactly rounded.  'str' must hold 'len' bytes, there is
+ * no 'CONV_TERMINATED' form. */
+bool conv_parse_f64(const char *str, Ulong len, double *out, Ulong *used) noexcept;
@@ -15,6 +15,7 @@
 #include <thread>
 #include <unistd.h>
 
+#include "Str_intern.h"
 #include "constexpr.hpp"
 #include "def.h"
 
@@ -104,7 +105,7 @@ namespace Mlib::Debug {
 
   typedef struct {
     LogLevel    level;
-    std::string function;
+    str_id_t    function; /* Interned, so queuing a message copies no name. */
     int         line;
     std::string message;
     /* Include a timestamp if you prefer logging it to be handled by the logger rather than each log call */
@@ -166,7 +167,7 @@ namespace Mlib::Debug {
    private:
     std::string_view   _output_file;
     LogLevel           _level;
-    std::string        _function;
+    std::string_view   _function; /* Points at '__func__', which has static storage. */
     std::string        _file;
     int                _line;
     std::ostringstream _buffer;
@@ -197,6 +198,7 @@ namespace Mlib::Debug {
       return *this;
     }
 
+    /* 'FuncName' is only made by 'FUNC' from '__func__', so keep the view as is. */
     Lout &operator<<(const FuncName &funcName) {
       _function = funcName.value;
       return *this;
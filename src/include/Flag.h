@@ -5,21 +5,29 @@
 #include "Mint.h"
 #include "Mbool.h"
 
+#include <bit>
+#include <type_traits>
+
 namespace /* Defines. */ {
   #define __constructor(...)    __inline__ constexpr __attribute__((__always_inline__, __nodebug__, __nothrow__)) bit_flag_t(__VA_ARGS__)
   #define __ref                 __inline__ constexpr bit_flag_t & __attribute__((__always_inline__, __nodebug__, __nothrow__))
   #define __void                __inline__ constexpr void __attribute__((__always_inline__, __nodebug__, __nothrow__))
-  #define __Uint                __inline__ constexpr Uint __attribute__((__warn_unused_result__, __always_inline__, __nodebug__, __nothrow__, __const__))
-  #define __bool                __inline__ constexpr bool __attribute__((__warn_unused_result__, __always_inline__, __nodebug__, __nothrow__, __const__))
-  #define __Uchar               __inline__ constexpr Uchar __attribute__((__warn_unused_result__, __always_inline__, __nodebug__, __nothrow__, __const__))
-  #define __Uchar_ref           __inline__ constexpr Uchar & __attribute__((__warn_unused_result__, __always_inline__, __nodebug__, __nothrow__))
+  #define __Uint                __inline__ constexpr Uint __attribute__((__warn_unused_result__, __always_inline__, __nodebug__, __nothrow__, __pure__))
+  #define __bool                __inline__ constexpr bool __attribute__((__warn_unused_result__, __always_inline__, __nodebug__, __nothrow__, __pure__))
+  #define __word                __inline__ constexpr word_t __attribute__((__warn_unused_result__, __always_inline__, __nodebug__, __nothrow__, __const__))
+  #define __word_ref            __inline__ constexpr word_t & __attribute__((__warn_unused_result__, __always_inline__, __nodebug__, __nothrow__))
   #define __assert_Flag_lt_Size static_assert(Flag < Size, "Flag must be lower then Size.")
 }
 
+/* Fixed set of 'Size' flags.  The flags are packed into the smallest unsigned word that holds them
+ * all, or an array of 64 bit words past 64 flags, so counting, testing for any flag and searching
+ * for the next one set are a popcount, an or and a tzcnt per word instead of a loop per bit. */
 template <Uint Size>
 struct bit_flag_t {
   static_assert(((Size % 8) == 0) && (Size != 0), "Size must be a power of 8");
 
+  using word_t = std::conditional_t<(Size <= 8), Uchar, std::conditional_t<(Size <= 16), Ushort, std::conditional_t<(Size <= 32), Uint, Ulong>>>;
+
   __void set(Uint flag) {
     _flags(flag) |= _flag_mask(flag);
   }
@@ -75,20 +83,21 @@ struct bit_flag_t {
   template <Uint Flag>
   __void clear_from(void) {
     static_assert(Flag + 1 < Size, "Cannot clear from last bit.");
-    Uint idx = Flag;
-    while (++idx < Size) {
-      unset(idx);
+    constexpr Uint FIRST = (Flag + 1);
+    /* Keep the bits below 'FIRST' in its word, and zero every word after it. */
+    _words[FIRST / WORD_BITS] &= (((word_t)1 << (FIRST % WORD_BITS)) - 1);
+    for (Uint i = ((FIRST / WORD_BITS) + 1); i < WORDS; ++i) {
+      _words[i] = 0;
     }
   }
   
   /* Return`s TRUE if all elements in the underling data array are equal to zero, else return`s FALSE. */
   __bool is_clear(void) const {
-    for (Uint i = 0; i < (Size / 8); ++i) {
-      if (_flag_array[i] != (Uchar)0) {
-        return FALSE;
-      }
+    word_t any = 0;
+    for (Uint i = 0; i < WORDS; ++i) {
+      any |= _words[i];
     }
-    return TRUE;
+    return (any == 0);
   }
 
   __Uint size(void) const {
@@ -96,29 +105,47 @@ struct bit_flag_t {
   }
 
   __void clear(void) {
-    for (Uint i = 0; i < (Size / 8); ++i) {
-      _flag_array[i] = (Uchar)0;
+    for (Uint i = 0; i < WORDS; ++i) {
+      _words[i] = 0;
     }
   }
 
   __Uint num_of_set_flags(void) const {
     Uint n = 0;
-    for (Uint i = 0; i < Size; ++i) {
-      if (is_set(i)) {
-        ++n;
-      }
+    for (Uint i = 0; i < WORDS; ++i) {
+      n += std::popcount(_words[i]);
     }
     return n;
   }
 
+  /* Return`s the first set flag at or after 'from', or 'Size' when there is none. */
+  __Uint next_set(Uint from) const {
+    if (from >= Size) {
+      return Size;
+    }
+    Uint   i    = (from / WORD_BITS);
+    word_t word = (_words[i] & (word_t)((word_t)~(word_t)0 << (from % WORD_BITS)));
+    while (!word) {
+      if (++i == WORDS) {
+        return Size;
+      }
+      word = _words[i];
+    }
+    return ((i * WORD_BITS) + std::countr_zero(word));
+  }
+
+  __Uint first_set(void) const {
+    return next_set(0);
+  }
+
   /* Constructors. */
   __constructor(void) {
     clear();
   }
 
   explicit __constructor(const bit_flag_t<Size> &other) {
-    for (Uint i = 0; i < (Size / 8); ++i) {
-      _flag_array[i] = other._flag_array[i];
+    for (Uint i = 0; i < WORDS; ++i) {
+      _words[i] = other._words[i];
     }
   }
 
@@ -158,36 +185,39 @@ struct bit_flag_t {
   }
 
  private:
-  Uchar _flag_array[Size / 8];
+  static constexpr Uint WORD_BITS = (sizeof(word_t) * 8);
+  static constexpr Uint WORDS     = ((Size + WORD_BITS - 1) / WORD_BITS);
+
+  word_t _words[WORDS];
 
-  __Uchar_ref _flags(Uint flag) {
-    return _flag_array[flag / 8];
+  __word_ref _flags(Uint flag) {
+    return _words[flag / WORD_BITS];
   }
 
-  const __Uchar_ref _flags(Uint flag) const {
-    return _flag_array[flag / 8];
+  const __word_ref _flags(Uint flag) const {
+    return _words[flag / WORD_BITS];
   }
 
   template <Uint Flag>
-  __Uchar_ref _flags(void) {
+  __word_ref _flags(void) {
     __assert_Flag_lt_Size;
-    return _flag_array[Flag / 8];
+    return _words[Flag / WORD_BITS];
   }
 
   template <Uint Flag>
-  const __Uchar_ref _flags(void) const {
+  const __word_ref _flags(void) const {
     __assert_Flag_lt_Size;
-    return _flag_array[Flag / 8];
+    return _words[Flag / WORD_BITS];
   }
 
-  __Uchar _flag_mask(Uint flag) const {
-    return ((Uchar)1 << (flag % 8));
+  __word _flag_mask(Uint flag) const {
+    return ((word_t)1 << (flag % WORD_BITS));
   }
 
   template <Uint Flag>
-  __Uchar _flag_mask(void) const {
+  __word _flag_mask(void) const {
     __assert_Flag_lt_Size;
-    return ((Uchar)1 << (Flag % 8));
+    return ((word_t)1 << (Flag % WORD_BITS));
   }
 };
 
@@ -197,7 +227,7 @@ namespace /* Undef. */ {
   #undef __void
   #undef __Uint
   #undef __bool
-  #undef __Uchar
-  #undef __Uchar_ref
+  #undef __word
+  #undef __word_ref
   #undef __assert_Flag_lt_Size
 }
@@ -0,0 +1,268 @@
+#pragma once
+/* clang-format off */
+
+#include "Attributes.h"
+#include "Vector.h"
+#include "def.h"
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+/* Sorted map over two contiguous columns, one of keys and one of values.  Lookup is a binary search
+ * that only touches the key column, and iterating in order is a plain walk over both arrays.
+ * Inserting a new key shifts the tail, so build large maps with 'push_unsorted()' and a single
+ * 'sort()' instead.  The default 'std::less<>' is transparent, a map keyed by 'std::string' can be
+ * searched with a 'std::string_view' or 'const char *'.
+ *
+ *   MFlatMap<std::string, int> map;
+ *   map["b"] = 2;
+ *   map["a"] = 1;
+ *   for (auto [key, value] : map) {}  // "a", "b".
+ */
+template <class K, class V, class Less = std::less<>>
+class MFlatMap {
+ public:
+  template <bool Const>
+  class iterator_t {
+    friend class MFlatMap;
+    template <bool> friend class iterator_t;
+
+    using map_t = std::conditional_t<Const, const MFlatMap, MFlatMap>;
+    using val_t = std::conditional_t<Const, const V, V>;
+
+    map_t *_map;
+    Uint   _idx;
+
+    iterator_t(map_t *map, Uint idx) noexcept : _map(map), _idx(idx) {}
+
+   public:
+    iterator_t(void) noexcept : _map(nullptr), _idx(0) {}
+
+    /* Allow 'iterator' to 'const_iterator'. */
+    template <bool C = Const> requires (C)
+    iterator_t(const iterator_t<false> &other) noexcept : _map(other._map), _idx(other._idx) {}
+
+    std::pair<const K &, val_t &> operator*(void) const noexcept {
+      return {_map->_keys[_idx], _map->_values[_idx]};
+    }
+
+    const K &key(void) const noexcept {
+      return _map->_keys[_idx];
+    }
+
+    val_t &value(void) const noexcept {
+      return _map->_values[_idx];
+    }
+
+    Uint index(void) const noexcept {
+      return _idx;
+    }
+
+    iterator_t &operator++(void) noexcept {
+      ++_idx;
+      return *this;
+    }
+
+    iterator_t &operator--(void) noexcept {
+      --_idx;
+      return *this;
+    }
+
+    bool operator==(const iterator_t &other) const noexcept {
+      return (_idx == other._idx);
+    }
+
+    bool operator!=(const iterator_t &other) const noexcept {
+      return (_idx != other._idx);
+    }
+  };
+
+  using iterator       = iterator_t<false>;
+  using const_iterator = iterator_t<true>;
+
+ private:
+  MVector<K> _keys;
+  MVector<V> _values;
+  [[no_unique_address]] Less _less;
+
+  template <class Q>
+  Uint _lower(const Q &key) const {
+    return (std::lower_bound(_keys.begin(), _keys.end(), key, _less) - _keys.begin());
+  }
+
+  template <class Q>
+  Uint _find(const Q &key) const {
+    Uint idx = _lower(key);
+    return ((idx < _keys.size() && !_less(key, _keys[idx])) ? idx : _keys.size());
+  }
+
+ public:
+  MFlatMap(void) = default;
+
+  explicit MFlatMap(Uint cap) {
+    reserve(cap);
+  }
+
+  template <class Q = K, class ...Args>
+  std::pair<iterator, bool> try_emplace(Q &&key, Args &&...args) {
+    Uint idx = _lower(key);
+    if (idx < _keys.size() && !_less(key, _keys[idx])) {
+      return {iterator(this, idx), false};
+    }
+    _keys.insert(idx, K(std::forward<Q>(key)));
+    _values.insert(idx, V(std::forward<Args>(args)...));
+    return {iterator(this, idx), true};
+  }
+
+  template <class Q = K, class T>
+  std::pair<iterator, bool> insert_or_assign(Q &&key, T &&value) {
+    auto ret = try_emplace(std::forward<Q>(key), std::forward<T>(value));
+    if (!ret.second) {
+      _values[ret.first._idx] = std::forward<T>(value);
+    }
+    return ret;
+  }
+
+  template <class Q = K>
+  V &operator[](Q &&key) {
+    return _values[try_emplace(std::forward<Q>(key)).first._idx];
+  }
+
+  /* Append without keeping the order, the map must be 'sort()'ed before any lookup. */
+  template <class Q = K, class T>
+  void push_unsorted(Q &&key, T &&value) {
+    _keys.push_back(K(std::forward<Q>(key)));
+    _values.push_back(V(std::forward<T>(value)));
+  }
+
+  /* Restore the order after 'push_unsorted()'.  When a key was pushed more then once the last
+   * value pushed for it wins. */
+  void sort(void) {
+    Uint len = _keys.size();
+    MVector<Uint> order;
+    order.resize(len);
+    for (Uint i = 0; i < len; ++i) {
+      order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [this](Uint a, Uint b) {
+      return _less(_keys[a], _keys[b]);
+    });
+    MVector<K> keys;
+    MVector<V> values;
+    keys.reserve(len);
+    values.reserve(len);
+    for (Uint i = 0; i < len; ++i) {
+      /* Equal keys keep their push order, so only the last of every run is kept. */
+      if ((i + 1) < len && !_less(_keys[order[i]], _keys[order[i + 1]])) {
+        continue;
+      }
+      keys.push_back(std::move(_keys[order[i]]));
+      values.push_back(std::move(_values[order[i]]));
+    }
+    _keys   = std::move(keys);
+    _values = std::move(values);
+  }
+
+  template <class Q = K>
+  iterator find(const Q &key) {
+    return iterator(this, _find(key));
+  }
+
+  template <class Q = K>
+  const_iterator find(const Q &key) const {
+    return const_iterator(this, _find(key));
+  }
+
+  /* First entry whose key is not less then 'key'. */
+  template <class Q = K>
+  iterator lower_bound(const Q &key) {
+    return iterator(this, _lower(key));
+  }
+
+  template <class Q = K>
+  const_iterator lower_bound(const Q &key) const {
+    return const_iterator(this, _lower(key));
+  }
+
+  template <class Q = K>
+  bool contains(const Q &key) const {
+    return (_find(key) != _keys.size());
+  }
+
+  template <class Q = K>
+  V &at(const Q &key) {
+    Uint idx = _find(key);
+    if (idx == _keys.size()) {
+      throw std::out_of_range("MFlatMap::at");
+    }
+    return _values[idx];
+  }
+
+  template <class Q = K>
+  const V &at(const Q &key) const {
+    return const_cast<MFlatMap *>(this)->at(key);
+  }
+
+  /* Return`s the number of entries removed, zero or one. */
+  template <class Q = K>
+  Uint erase(const Q &key) requires (!std::is_convertible_v<const Q &, const_iterator>) {
+    Uint idx = _find(key);
+    if (idx == _keys.size()) {
+      return 0;
+    }
+    _keys.erase_at(idx);
+    _values.erase_at(idx);
+    return 1;
+  }
+
+  /* Return`s the entry after 'it'. */
+  iterator erase(const_iterator it) {
+    _keys.erase_at(it._idx);
+    _values.erase_at(it._idx);
+    return iterator(this, it._idx);
+  }
+
+  void clear(void) {
+    _keys.clear();
+    _values.clear();
+  }
+
+  void reserve(Uint n) {
+    _keys.reserve(n);
+    _values.reserve(n);
+  }
+
+  Uint size(void) const noexcept {
+    return _keys.size();
+  }
+
+  bool empty(void) const noexcept {
+    return _keys.empty();
+  }
+
+  /* The sorted key and value columns. */
+  const MVector<K> &keys(void) const noexcept {
+    return _keys;
+  }
+
+  const MVector<V> &values(void) const noexcept {
+    return _values;
+  }
+
+  iterator begin(void) {
+    return iterator(this, 0);
+  }
+
+  iterator end(void) {
+    return iterator(this, _keys.size());
+  }
+
+  const_iterator begin(void) const {
+    return const_iterator(this, 0);
+  }
+
+  const_iterator end(void) const {
+    return const_iterator(this, _keys.size());
+  }
+};
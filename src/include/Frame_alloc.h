@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Attributes.h"
+#include "Mem_pool.h"
+#include "def.h"
+
+#define __frame_alloc_t_attr __attr(__always_inline__, __nodebug__, __nothrow__)
+/* Double buffered scratch allocator for per frame temporaries.  Memory taken during a frame
+ * stays valid through the next one, so data handed from one frame to the next is safe.
+ * Call 'next_frame()' once at the start of every frame. */
+class frame_alloc_t {
+  mem_pool_t<16> _pools[2];
+  Uint           _current;
+
+ public:
+  explicit frame_alloc_t(Ulong chunk_size = (256 * 1024)) noexcept
+      : _pools {mem_pool_t<16>(chunk_size, MEM_POOL_CHAINED), mem_pool_t<16>(chunk_size, MEM_POOL_CHAINED)}
+      , _current(0) {
+  }
+
+  DEL_CM_CONSTRUCTORS(frame_alloc_t);
+
+  /* Switch buffers and release everything allocated two frames ago. */
+  __inline__ void __frame_alloc_t_attr next_frame(void) noexcept {
+    _current ^= 1;
+    _pools[_current].reset();
+  }
+
+  __inline__ void *__warn_unused __frame_alloc_t_attr alloc(Ulong size, Ulong alignment = 16) noexcept {
+    return _pools[_current].alloc(size, alignment);
+  }
+
+  /* Allocate an uninitialized array of 'count' 'T`s. */
+  template <typename T>
+  __inline__ T *__warn_unused __frame_alloc_t_attr alloc_array(Ulong count) noexcept {
+    return (T *)_pools[_current].alloc((sizeof(T) * count), alignof(T));
+  }
+
+  /* Construct a 'T', its destructor runs when the buffer it lives in is recycled. */
+  template <typename T, typename... Args>
+  __inline__ T *__warn_unused __frame_alloc_t_attr make(Args &&...args) noexcept {
+    return _pools[_current].template make<T>(std::forward<Args>(args)...);
+  }
+
+  /* The pool of the current frame, for scoped use with 'mem_pool_scope_t'. */
+  __inline__ mem_pool_t<16> &__frame_alloc_t_attr pool(void) noexcept {
+    return _pools[_current];
+  }
+};
+#undef __frame_alloc_t_attr
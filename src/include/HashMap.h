@@ -0,0 +1,492 @@
+#pragma once
+/* clang-format off */
+
+#include "Attributes.h"
+#include "Debug.h"
+#include "Vector.h"
+#include "def.h"
+
+#include <cstring>
+#include <functional>
+#include <string>
+#include <string_view>
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
+/* Control byte states, a full slot holds the low 7 bits of its hash instead. */
+#define MHASH_EMPTY   ((signed char)-128)
+#define MHASH_DELETED ((signed char)-2)
+/* Slots probed at once, one sse2 register of control bytes. */
+#define MHASH_GROUP   16
+
+/* Default hasher for 'MHashMap'.  String types hash through 'std::string_view' and are transparent,
+ * so maps keyed by 'std::string' can be searched with a 'const char *' or 'std::string_view'
+ * without building a temporary string. */
+template <class K>
+struct mhash_t : std::hash<K> {};
+
+template <>
+struct mhash_t<std::string> {
+  using is_transparent = void;
+
+  Ulong operator()(std::string_view str) const noexcept {
+    return std::hash<std::string_view>()(str);
+  }
+};
+
+template <>
+struct mhash_t<std::string_view> : mhash_t<std::string> {};
+
+/* Control bytes of one group, with a bitmask of the slots matching a given state. */
+struct mhash_group_t {
+#ifdef __SSE2__
+  __m128i ctrl;
+
+  explicit mhash_group_t(const signed char *group) noexcept : ctrl(_mm_load_si128((const __m128i *)group)) {}
+
+  Uint match(signed char h2) const noexcept {
+    return (Uint)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl));
+  }
+
+  /* Empty and deleted are the only states with the sign bit set. */
+  Uint match_free(void) const noexcept {
+    return (Uint)_mm_movemask_epi8(ctrl);
+  }
+#else
+  const signed char *ctrl;
+
+  explicit mhash_group_t(const signed char *group) noexcept : ctrl(group) {}
+
+  Uint match(signed char h2) const noexcept {
+    Uint mask = 0;
+    for (Uint i = 0; i < MHASH_GROUP; ++i) {
+      mask |= ((Uint)(ctrl[i] == h2) << i);
+    }
+    return mask;
+  }
+
+  Uint match_free(void) const noexcept {
+    Uint mask = 0;
+    for (Uint i = 0; i < MHASH_GROUP; ++i) {
+      mask |= ((Uint)(ctrl[i] < 0) << i);
+    }
+    return mask;
+  }
+#endif
+
+  Uint match_empty(void) const noexcept {
+    return match(MHASH_EMPTY);
+  }
+};
+
+/* Open addressing hash map in the style of a swiss table.  Every slot has one control byte and
+ * a lookup compares a whole group of 16 control bytes against 7 bits of the hash with a single
+ * sse2 compare, only touching the slots that match.  Entries live in one flat allocation drawn
+ * from 'Alloc', which uses the same interface as the 'MVector' allocators.
+ *
+ * Unlike 'std::unordered_map' an insert can move every entry, so references and iterators are
+ * invalidated by any insert that grows the table.  Erase never moves other entries.
+ * Do not modify the key through an iterator. */
+template <class K, class V, class Hash = mhash_t<K>, class Eq = std::equal_to<>, class Alloc = mvector_malloc_t>
+class MHashMap {
+ public:
+  using value_type = std::pair<K, V>;
+
+  template <bool Const>
+  class iterator_t {
+    friend class MHashMap;
+    template <bool> friend class iterator_t;
+
+    using map_t = std::conditional_t<Const, const MHashMap, MHashMap>;
+    using ref_t = std::conditional_t<Const, const value_type &, value_type &>;
+    using ptr_t = std::conditional_t<Const, const value_type *, value_type *>;
+
+    map_t *_map;
+    Ulong  _idx;
+
+    iterator_t(map_t *map, Ulong idx) noexcept : _map(map), _idx(idx) {
+      _skip();
+    }
+
+    void _skip(void) noexcept {
+      while (_idx < _map->_cap && _map->_ctrl[_idx] < 0) {
+        ++_idx;
+      }
+    }
+
+   public:
+    iterator_t(void) noexcept : _map(nullptr), _idx(0) {}
+
+    /* Allow 'iterator' to 'const_iterator'. */
+    template <bool C = Const> requires (C)
+    iterator_t(const iterator_t<false> &other) noexcept : _map(other._map), _idx(other._idx) {}
+
+    ref_t operator*(void) const noexcept {
+      return _map->_slots[_idx];
+    }
+
+    ptr_t operator->(void) const noexcept {
+      return &_map->_slots[_idx];
+    }
+
+    iterator_t &operator++(void) noexcept {
+      ++_idx;
+      _skip();
+      return *this;
+    }
+
+    bool operator==(const iterator_t &other) const noexcept {
+      return (_idx == other._idx);
+    }
+
+    bool operator!=(const iterator_t &other) const noexcept {
+      return (_idx != other._idx);
+    }
+  };
+
+  using iterator       = iterator_t<false>;
+  using const_iterator = iterator_t<true>;
+
+ private:
+  signed char      *_ctrl;
+  value_type *_slots;
+  Ulong       _cap;         /* Zero or a power of two, atleast 'MHASH_GROUP'. */
+  Ulong       _len;
+  Ulong       _growth_left; /* Empty slots that may still be filled before a rehash. */
+  [[no_unique_address]] Hash  _hash;
+  [[no_unique_address]] Eq    _eq;
+  [[no_unique_address]] Alloc _alloc;
+
+  /* Mix the users hash, so weak hashes like the identity hash of integers still spread over
+   * both the group index and the 7 bits in the control byte. */
+  template <class Q>
+  __inline__ Ulong __attribute((__always_inline__, __nothrow__, __nodebug__)) _hash_of(const Q &key) const {
+    Ulong h = ((Ulong)_hash(key) * 0x9E3779B97F4A7C15ull);
+    return (h ^ (h >> 32));
+  }
+
+  static constexpr Ulong _max_load(Ulong cap) noexcept {
+    return (cap - (cap / 8));
+  }
+
+  static constexpr Ulong _bytes_for(Ulong cap) noexcept {
+    return (_slots_offset(cap) + (sizeof(value_type) * cap));
+  }
+
+  static constexpr Ulong _slots_offset(Ulong cap) noexcept {
+    return ((cap + (alignof(value_type) - 1)) & ~(Ulong)(alignof(value_type) - 1));
+  }
+
+  static constexpr Ulong _block_align(void) noexcept {
+    return ((alignof(value_type) > MHASH_GROUP) ? alignof(value_type) : MHASH_GROUP);
+  }
+
+  /* Return`s the slot of 'key', or '_cap' when it is not in the map. */
+  template <class Q>
+  Ulong _find(const Q &key) const {
+    if (!_len) {
+      return _cap;
+    }
+    Ulong h    = _hash_of(key);
+    signed char h2   = (signed char)(h & 0x7F);
+    Ulong mask = ((_cap / MHASH_GROUP) - 1);
+    Ulong g    = ((h >> 7) & mask);
+    /* Triangular probing visits every group once when the group count is a power of two. */
+    for (Ulong step = 1;; ++step) {
+      mhash_group_t group(_ctrl + (g * MHASH_GROUP));
+      for (Uint m = group.match(h2); m; m &= (m - 1)) {
+        Ulong idx = ((g * MHASH_GROUP) + __builtin_ctz(m));
+        if (_eq(_slots[idx].first, key)) [[likely]] {
+          return idx;
+        }
+      }
+      if (group.match_empty() || step > mask) {
+        return _cap;
+      }
+      g = ((g + step) & mask);
+    }
+  }
+
+  /* First empty or deleted slot on the probe sequence of 'h', the table must have room. */
+  Ulong _find_free(Ulong h) const noexcept {
+    Ulong mask = ((_cap / MHASH_GROUP) - 1);
+    Ulong g    = ((h >> 7) & mask);
+    for (Ulong step = 1;; ++step) {
+      Uint m = mhash_group_t(_ctrl + (g * MHASH_GROUP)).match_free();
+      if (m) {
+        return ((g * MHASH_GROUP) + __builtin_ctz(m));
+      }
+      g = ((g + step) & mask);
+    }
+  }
+
+  /* Move every entry into a fresh table of 'cap' slots, dropping all tombstones. */
+  void __attribute((__noinline__)) _rehash(Ulong cap) {
+    signed char      *old_ctrl  = _ctrl;
+    value_type *old_slots = _slots;
+    Ulong       old_cap   = _cap;
+    Uchar *block = (Uchar *)_alloc.allocate(_bytes_for(cap), _block_align());
+    if (!block) {
+      logE("MHashMap failed to grow to %lu slots.", cap);
+      exit(1);
+    }
+    _ctrl        = (signed char *)block;
+    _slots       = (value_type *)(block + _slots_offset(cap));
+    _cap         = cap;
+    _growth_left = (_max_load(cap) - _len);
+    memset(_ctrl, MHASH_EMPTY, cap);
+    for (Ulong i = 0; i < old_cap; ++i) {
+      if (old_ctrl[i] >= 0) {
+        Ulong h   = _hash_of(old_slots[i].first);
+        Ulong idx = _find_free(h);
+        _ctrl[idx] = (signed char)(h & 0x7F);
+        new (_slots + idx) value_type((value_type &&)old_slots[i]);
+        old_slots[i].~value_type();
+      }
+    }
+    if (old_ctrl) {
+      _alloc.deallocate(old_ctrl, _bytes_for(old_cap), _block_align());
+    }
+  }
+
+  /* Make room for one more entry, either by growing or by clearing out tombstones. */
+  void _reserve_one(void) {
+    if (!_growth_left) {
+      _rehash((_cap && (_len < (_max_load(_cap) / 2))) ? _cap : (_cap ? (_cap * 2) : MHASH_GROUP));
+    }
+  }
+
+  /* Return`s the slot for 'key' and whether it was inserted, the value is left for the caller
+   * to construct when it was. */
+  template <class Q>
+  std::pair<Ulong, bool> _prepare_insert(const Q &key) {
+    Ulong idx = _find(key);
+    if (idx != _cap) {
+      return {idx, false};
+    }
+    _reserve_one();
+    Ulong h = _hash_of(key);
+    idx     = _find_free(h);
+    if (_ctrl[idx] == MHASH_EMPTY) {
+      --_growth_left;
+    }
+    _ctrl[idx] = (signed char)(h & 0x7F);
+    ++_len;
+    return {idx, true};
+  }
+
+  void _erase_slot(Ulong idx) {
+    _slots[idx].~value_type();
+    --_len;
+    /* A probe only stops at a group with an empty slot, so when this group already has one
+     * no probe can be relying on it being full and the slot can become empty again. */
+    Ulong group = (idx & ~(Ulong)(MHASH_GROUP - 1));
+    if (mhash_group_t(_ctrl + group).match_empty()) {
+      _ctrl[idx] = MHASH_EMPTY;
+      ++_growth_left;
+    }
+    else {
+      _ctrl[idx] = MHASH_DELETED;
+    }
+  }
+
+  void _destroy(void) {
+    if constexpr (!is_trivially_destructible_v<value_type>) {
+      for (Ulong i = 0; i < _cap; ++i) {
+        if (_ctrl[i] >= 0) {
+          _slots[i].~value_type();
+        }
+      }
+    }
+  }
+
+ public:
+  /* Constructors. */
+  MHashMap(void) : _ctrl(nullptr), _slots(nullptr), _cap(0), _len(0), _growth_left(0) {}
+
+  explicit MHashMap(const Alloc &alloc) : MHashMap() {
+    _alloc = alloc;
+  }
+
+  MHashMap(const MHashMap &other) : MHashMap(other._alloc) {
+    reserve(other._len);
+    for (const auto &it : other) {
+      Ulong idx = _prepare_insert(it.first).first;
+      new (_slots + idx) value_type(it);
+    }
+  }
+
+  MHashMap(MHashMap &&other) noexcept
+    : _ctrl(other._ctrl), _slots(other._slots), _cap(other._cap), _len(other._len), _growth_left(other._growth_left),
+      _hash(other._hash), _eq(other._eq), _alloc((Alloc &&)other._alloc) {
+    other._ctrl        = nullptr;
+    other._slots       = nullptr;
+    other._cap         = 0;
+    other._len         = 0;
+    other._growth_left = 0;
+  }
+
+  /* Destructor. */
+  ~MHashMap(void) {
+    _destroy();
+    if (_ctrl) {
+      _alloc.deallocate(_ctrl, _bytes_for(_cap), _block_align());
+    }
+  }
+
+  MHashMap &operator=(const MHashMap &other) {
+    if (this != &other) {
+      clear();
+      reserve(other._len);
+      for (const auto &it : other) {
+        Ulong idx = _prepare_insert(it.first).first;
+        new (_slots + idx) value_type(it);
+      }
+    }
+    return *this;
+  }
+
+  MHashMap &operator=(MHashMap &&other) noexcept {
+    if (this != &other) {
+      this->~MHashMap();
+      new (this) MHashMap((MHashMap &&)other);
+    }
+    return *this;
+  }
+
+  /* Insert 'key' with a value built from 'args' unless it already exists.  Return`s the entry
+   * and whether it was inserted, 'args' are untouched when it was not. */
+  template <class Q = K, class ...Args>
+  std::pair<iterator, bool> try_emplace(Q &&key, Args &&...args) {
+    auto [idx, inserted] = _prepare_insert(key);
+    if (inserted) {
+      new (_slots + idx) value_type(std::piecewise_construct, std::forward_as_tuple(std::forward<Q>(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+    return {iterator(this, idx), inserted};
+  }
+
+  std::pair<iterator, bool> insert(const value_type &value) {
+    return try_emplace(value.first, value.second);
+  }
+
+  std::pair<iterator, bool> insert(value_type &&value) {
+    return try_emplace((K &&)value.first, (V &&)value.second);
+  }
+
+  /* Same as 'insert', but overwrites the value when the key exists. */
+  template <class Q = K, class T>
+  std::pair<iterator, bool> insert_or_assign(Q &&key, T &&value) {
+    auto ret = try_emplace(std::forward<Q>(key), std::forward<T>(value));
+    if (!ret.second) {
+      ret.first->second = std::forward<T>(value);
+    }
+    return ret;
+  }
+
+  template <class Q = K>
+  V &operator[](Q &&key) {
+    return try_emplace(std::forward<Q>(key)).first->second;
+  }
+
+  template <class Q = K>
+  iterator find(const Q &key) {
+    return iterator(this, _find(key));
+  }
+
+  template <class Q = K>
+  const_iterator find(const Q &key) const {
+    return const_iterator(this, _find(key));
+  }
+
+  template <class Q = K>
+  bool contains(const Q &key) const {
+    return (_find(key) != _cap);
+  }
+
+  template <class Q = K>
+  Ulong count(const Q &key) const {
+    return contains(key);
+  }
+
+  template <class Q = K>
+  V &at(const Q &key) {
+    Ulong idx = _find(key);
+    if (idx == _cap) {
+      throw std::out_of_range("MHashMap::at");
+    }
+    return _slots[idx].second;
+  }
+
+  template <class Q = K>
+  const V &at(const Q &key) const {
+    return const_cast<MHashMap *>(this)->at(key);
+  }
+
+  /* Return`s the number of entries removed, zero or one. */
+  template <class Q = K>
+  Ulong erase(const Q &key) requires (!std::is_convertible_v<const Q &, const_iterator>) {
+    Ulong idx = _find(key);
+    if (idx == _cap) {
+      return 0;
+    }
+    _erase_slot(idx);
+    return 1;
+  }
+
+  /* Return`s the entry after 'it'. */
+  iterator erase(const_iterator it) {
+    _erase_slot(it._idx);
+    return iterator(this, (it._idx + 1));
+  }
+
+  /* Remove every entry, the table keeps its size. */
+  void clear(void) {
+    if (!_cap) {
+      return;
+    }
+    _destroy();
+    memset(_ctrl, MHASH_EMPTY, _cap);
+    _len         = 0;
+    _growth_left = _max_load(_cap);
+  }
+
+  /* Make room for 'n' entries without rehashing. */
+  void reserve(Ulong n) {
+    Ulong cap = MHASH_GROUP;
+    while (_max_load(cap) < n) {
+      cap *= 2;
+    }
+    if (cap > _cap) {
+      _rehash(cap);
+    }
+  }
+
+  Ulong size(void) const noexcept {
+    return _len;
+  }
+
+  bool empty(void) const noexcept {
+    return (_len == 0);
+  }
+
+  Ulong capacity(void) const noexcept {
+    return _cap;
+  }
+
+  iterator begin(void) {
+    return iterator(this, 0);
+  }
+
+  iterator end(void) {
+    return iterator(this, _cap);
+  }
+
+  const_iterator begin(void) const {
+    return const_iterator(this, 0);
+  }
+
+  const_iterator end(void) const {
+    return const_iterator(this, _cap);
+  }
+};
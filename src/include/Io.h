@@ -9,4 +9,9 @@ namespace Mlib::Io
 
 } // namespace Mlib::Io
 
+/* Return`s the lines of the file at 'path' without their newlines, terminated by NULL.
+ * Every line and the array are separate allocations, 'free()' each line and then the array. */
 char **get_file_lines(const char *path);
+/* Like 'get_file_lines()', but the array and all lines are one allocation, release it with a
+ * single 'free()'.  Use this one for large files, it copies the text once and allocates once. */
+char **get_file_lines_block(const char *path);
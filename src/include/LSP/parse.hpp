@@ -1,18 +1,7 @@
 #pragma once
 
 #include "../Flag.h"
-#include "../Vector.h"
-
-#include <string>
-
-using std::string;
-
-struct line_t
-{
-    string data;
-    line_t *prev;
-    line_t *next;
-};
+#include "../PieceTable.h"
 
 class MParse {
     enum flags_t
@@ -21,7 +10,14 @@ class MParse {
         in_body    = 2
     };
     bit_flag_t<8> _flags;
+    MPieceTable   _text;
 
 public:
     void parse_source_file(const char *path);
+
+    const MPieceTable &
+    text(void) const
+    {
+        return _text;
+    }
 };
@@ -2,9 +2,14 @@
 
 #include "../def.h"
 #include "../Vector.h"
+#include "../SlotMap.h"
+#include "../SmallVector.h"
 #include "../openGL/shader.h"
 #include "../Pair.h"
 #include "../Flag.h"
+#include "../Frame_alloc.h"
+#include "../HashMap.h"
+#include "../Mem_resource.h"
 #include "../Debug.h"
 #include "../File.h"
 
@@ -12,6 +17,7 @@
 #include <stdlib.h>
 #include <unordered_map>
 #include <functional>
+#include <memory_resource>
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
@@ -171,10 +177,13 @@ class __glewApp {
   int  _init(const char *title);
   bool _put_element_over(Element *e_under, Element *e_over);
   void _remove_element(const std::string &name);
+  void _remove_element(Element *e);
   Element *_root(void);
 
  public:
   std::unordered_map<std::string, Element *> elements;
+  /* Every live element by handle, see 'Element::handle'. */
+  MSlotMap<Element *> element_slots;
   MVector<Element *> element_vec;
   MVector<Pair<Element *, ElementAnimationData>> animation_data;
   GridMap *grid_map;
@@ -183,6 +192,8 @@ class __glewApp {
   bit_flag_t<8> flag;
   GLFWwindow *win;
   Uint shader;
+  /* Scratch memory for the current frame, recycled by 'run()'. */
+  frame_alloc_t frame_alloc;
 
   static __glewApp *instance(void);
 
@@ -190,6 +201,7 @@ class __glewApp {
   void set_font(const char *path, Uint size);
   Element *new_element(const std::string &parent, const std::string &name, const vec2 &pos, const vec2 &size, const vec4 &color, const vec4 &hi_color);
   Element *get_element(const std::string &name);
+  Element *get_element(slot_handle_t handle);
   Element *get_element_from_mouse(void);
   Button *new_button(const std::string &parent, const std::string &name, const vec2 &pos, const vec2 &size, const vec4 &color, const vec4 &hi_color);
   DropDownMenu *new_dropdown_menu(const std::string &parent, const std::string &name, const vec2 &pos, const vec2 &size, const vec4 &color, const vec4 &hi_color, int dropdown_side);
@@ -226,6 +238,8 @@ struct ElementData {
 
 struct Element {
   std::string name;
+  /* O(1) lookup through '__glewApp::get_element()', goes stale when the element is removed. */
+  slot_handle_t handle = SLOT_HANDLE_NONE;
   ElementData data;
   vec2 pos_alignment;
   bit_flag_t<ELEMENT_FLAG_SIZE> flag;
@@ -331,14 +345,16 @@ struct CoordHash {
 class GridMap {
  private:
   int cell_size;
-  std::unordered_map<ivec2, MVector<Element *>, CoordHash> grid;
+  /* Cells rarely hold more then a few elements, so they live inline in the table. */
+  MHashMap<ivec2, MSmallVector<Element *, 4>, CoordHash, std::equal_to<>, pmr_alloc_t> grid;
 
   ivec2 to_grid_pos(const ivec2 &pos) const {
     return ivec2(pos / cell_size);
   }
 
  public:
-  GridMap(int cell_size) : cell_size(cell_size) {};
+  GridMap(int cell_size, std::pmr::memory_resource *mr = std::pmr::get_default_resource())
+    : cell_size(cell_size), grid(pmr_alloc_t(mr)) {};
 
   void set(const ivec2 &pos, Element *element) {
     grid[to_grid_pos(pos)].emplace_back(element);
@@ -361,11 +377,7 @@ class GridMap {
   void remove(const ivec2 &pos, Element *e) {
     ivec2 at_pos = to_grid_pos(pos);
     auto &vector = grid.at(at_pos);
-    for (Uint i = 0; i < vector.size(); ++i) {
-      if (grid.at(at_pos)[i] == e) {
-        vector.erase(&vector[i--]);
-      }
-    }
+    vector.erase_if([e](Element *const &it) { return it == e; });
     if (vector.empty()) {
       grid.erase(at_pos);
     }
@@ -379,11 +391,7 @@ class GridMap {
       for (int y = start.y; y <= end.y; ++y) {
         ivec2 at_pos(x, y);
         auto &vector = grid.at(at_pos);
-        for (Uint i = 0; i < vector.size(); ++i) {
-          if (vector[i] == e) {
-            vector.erase(&vector[i--]);
-          }
-        }
+        vector.erase_if([e](Element *const &it) { return it == e; });
         if (vector.empty()) {
           grid.erase(at_pos);
         }
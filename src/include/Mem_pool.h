@@ -1,5 +1,6 @@
 #pragma once
 
+#include "Alloc_stats.h"
 #include "Attributes.h"
 #include "Debug.h"
 #include "def.h"
@@ -8,19 +9,137 @@
 #include <malloc.h>
 #include <mm_malloc.h>
 
+/* Flags for 'mem_pool_t'. */
+#define MEM_POOL_CHAINED       (1 << 0) /* Map a new chunk when the current one is full, instead of failing. */
+#define MEM_POOL_HUGEPAGE      (1 << 1) /* Back every chunk with transparent huge pages ('MADV_HUGEPAGE'). */
+#define MEM_POOL_POPULATE      (1 << 2) /* Pre-fault every chunk when it is mapped. */
+
+#define MEM_POOL_HUGEPAGE_SIZE (2UL * 1024 * 1024)
+
+/* Header at the start of every mapped chunk.  The usable memory follows directly after it. */
+struct mem_pool_chunk_t {
+  mem_pool_chunk_t *next;
+  Ulong             size; /* Total mapped size, including this header. */
+};
+
+/* Map a chunk that can hold atleast 'size' bytes after its header, honoring the
+ * 'MEM_POOL_HUGEPAGE' and 'MEM_POOL_POPULATE' flags.  Return`s nullptr on failure. */
+mem_pool_chunk_t *__warn_unused mem_pool_map_chunk(Ulong size, Uint flags) noexcept;
+void                            mem_pool_unmap_chunk(mem_pool_chunk_t *chunk) noexcept;
+
+/* Destructor record placed in the pool by 'mem_pool_t::make()'.  Records form a LIFO list. */
+struct mem_pool_dtor_t {
+  mem_pool_dtor_t *prev;
+  void (*destroy)(void *);
+  void *obj;
+};
+
+/* Saved allocation state returned by 'mem_pool_t::mark()'. */
+struct mem_pool_mark_t {
+  mem_pool_chunk_t *chunk;
+  Ulong             offset;
+  Ulong             chained_used;
+  mem_pool_dtor_t  *dtors;
+};
+
 #define __mem_pool_t_attr __attr(__always_inline__, __nodebug__, __nothrow__)
 template <Ulong Alignment>
 class mem_pool_t {
   static_assert((Alignment % 2) == 0 && Alignment != 0, "Alignment must be a power of 2.");
 
+  /* The chunk we are currently bumping from.  When not chained this is the single '_mm_malloc' block. */
   char *_pool;
   Ulong _pool_size;
   Ulong _offset;
+  /* Chained mode state, '_head' is nullptr when the pool is a single block. */
+  mem_pool_chunk_t *_head;
+  mem_pool_chunk_t *_chunk;
+  Ulong             _chunk_size;
+  Ulong             _chained_used;
+  Uint              _flags;
+  /* Most recent destructor registered by 'make()'. */
+  mem_pool_dtor_t *_dtors;
+  ALLOC_STATS_ONLY(alloc_site_t *_stats;)
+
+  /* Run registered destructors, newest first, until 'stop' is reached. */
+  __inline__ void __mem_pool_t_attr _run_dtors(mem_pool_dtor_t *stop) noexcept {
+    while (_dtors != stop) {
+      _dtors->destroy(_dtors->obj);
+      _dtors = _dtors->prev;
+    }
+  }
+
+  static __inline__ char *__mem_pool_t_attr _chunk_data(mem_pool_chunk_t *chunk) noexcept {
+    return ((char *)chunk + sizeof(mem_pool_chunk_t));
+  }
+
+  __inline__ void __mem_pool_t_attr _use_chunk(mem_pool_chunk_t *chunk) noexcept {
+    _chunk     = chunk;
+    _pool      = _chunk_data(chunk);
+    _pool_size = (chunk->size - sizeof(mem_pool_chunk_t));
+    _offset    = 0;
+  }
+
+  /* Slow path, only reached when the current chunk cannot fit the allocation.  Moves to the
+   * next already mapped chunk that fits, or maps a new one at the tail of the chain. */
+  void *__warn_unused __attr(__noinline__, __cold__) _grow(Ulong size, Ulong alignment) noexcept {
+    if (!(_flags & MEM_POOL_CHAINED)) {
+      logE("mem_pool_t ran out off memory.");
+      return nullptr;
+    }
+    Ulong needed = (size + alignment);
+    ALLOC_STATS_ONLY(_stats->record_waste(_pool_size - _offset);)
+    _chained_used += _offset;
+    while (_chunk->next) {
+      _use_chunk(_chunk->next);
+      if (needed <= _pool_size) {
+        return _bump(size, alignment);
+      }
+    }
+    mem_pool_chunk_t *chunk = mem_pool_map_chunk(((needed > _chunk_size) ? needed : _chunk_size), _flags);
+    if (!chunk) {
+      logE("mem_pool_t failed to map a new chunk.");
+      return nullptr;
+    }
+    _chunk->next = chunk;
+    _use_chunk(chunk);
+    return _bump(size, alignment);
+  }
+
+  /* The fast path shared by all allocation functions. */
+  __inline__ void *__warn_unused __mem_pool_t_attr _bump(Ulong size, Ulong alignment) noexcept {
+    Ulong current_offset = (Ulong)(_pool + _offset);
+    Ulong aligned_offset = (current_offset + alignment - 1) & ~(alignment - 1);
+    Ulong aligned_size   = aligned_offset - current_offset;
+    if (_offset + aligned_size + size > _pool_size) [[unlikely]] {
+      return _grow(size, alignment);
+    }
+    _offset += aligned_size + size;
+    ALLOC_STATS_ONLY(_stats->record_alloc((aligned_size + size), aligned_size);)
+    return (void *)aligned_offset;
+  }
 
  public:
-  explicit mem_pool_t(Ulong size) noexcept
+  /* When 'flags' contains 'MEM_POOL_CHAINED', 'size' is the size of each mapped chunk rather then a hard limit. */
+  explicit mem_pool_t(Ulong size, Uint flags = 0) noexcept
       : _pool_size(size)
-      , _offset(0) {
+      , _offset(0)
+      , _head(nullptr)
+      , _chunk(nullptr)
+      , _chunk_size(size)
+      , _chained_used(0)
+      , _flags(flags)
+      , _dtors(nullptr) {
+    ALLOC_STATS_ONLY(_stats = alloc_stats_site("mem_pool_t");)
+    if (_flags & MEM_POOL_CHAINED) {
+      _head = mem_pool_map_chunk(size, _flags);
+      if (_head == nullptr) {
+        logE("mem_pool_t failed to be initilized.");
+        exit(1);
+      }
+      _use_chunk(_head);
+      return;
+    }
     _pool = (char *)_mm_malloc(size, Alignment);
     if (_pool == nullptr) {
       logE("mem_pool_t failed to be initilized.");
@@ -29,19 +148,22 @@ class mem_pool_t {
   }
 
   ~mem_pool_t(void) noexcept {
+    _run_dtors(nullptr);
+    if (_head) {
+      while (_head) {
+        mem_pool_chunk_t *next = _head->next;
+        mem_pool_unmap_chunk(_head);
+        _head = next;
+      }
+      return;
+    }
     _mm_free(_pool);
   }
 
+  DEL_CM_CONSTRUCTORS(mem_pool_t);
+
   __inline__ __ptr<void> __warn_unused __mem_pool_t_attr alloc(Ulong size, Ulong alignment) noexcept {
-    Ulong current_offset = (Ulong)(_pool + _offset);
-    Ulong aligned_offset = (current_offset + alignment - 1) & ~(alignment - 1);
-    Ulong aligned_size   = aligned_offset - current_offset;
-    if (_offset + aligned_size + size > _pool_size) {
-      logE("mem_pool_t ran out off memory.");
-      return nullptr;
-    }
-    _offset += aligned_size + size;
-    return (void *)(_pool + aligned_offset - (Ulong)_pool);
+    return _bump(size, alignment);
   }
 
   template <typename T, typename... Args>
@@ -52,15 +174,10 @@ class mem_pool_t {
       logE("Invalid alignment.  Must be a power of 2.");
       return nullptr;
     }
-    Ulong current_offset = (Ulong)(_pool + _offset);
-    Ulong aligned_offset = (current_offset + alignment - 1) & ~(alignment - 1);
-    Ulong aligned_size   = aligned_offset - current_offset;
-    if (_offset + aligned_size + size > _pool_size) {
-      logE("mem_pool_t ran out off memory.");
+    void *mem_location = _bump(size, alignment);
+    if (!mem_location) {
       return nullptr;
     }
-    _offset += aligned_size + size;
-    void *mem_location = (void *)(_pool + aligned_offset - (Ulong)_pool);
     return new (mem_location) T(std::forward<Args>(args)...);
   }
 
@@ -71,31 +188,113 @@ class mem_pool_t {
       logE("Invalid alignment.  Must be a power of 2.");
       return nullptr;
     }
-    Ulong current_offset = (Ulong)(_pool + _offset);
-    Ulong aligned_offset = (current_offset + alignment - 1) & ~(alignment - 1);
-    Ulong aligned_size   = aligned_offset - current_offset;
-    if (_offset + aligned_size + size > _pool_size) {
-      logE("mem_pool_t ran out off memory.");
+    void *mem_location = _bump(size, alignment);
+    if (!mem_location) {
       return nullptr;
     }
-    _offset += aligned_size + size;
-    void *mem_location = (void *)(_pool + aligned_offset - (Ulong)_pool);
     return new (mem_location) T();
-    // return (T *)(_pool + aligned_offset - (Ulong)_pool);
   }
 
+  /* Construct a 'T' in the pool.  When 'T' is not trivially destructible its destructor is
+   * registered, and run by 'rewind()', 'reset()' or when the pool is destroyed. */
+  template <typename T, typename... Args>
+  __inline__ T *__warn_unused __mem_pool_t_attr make(Args &&...args) noexcept {
+    mem_pool_dtor_t *dtor = nullptr;
+    if constexpr (!std::is_trivially_destructible<T>::value) {
+      dtor = (mem_pool_dtor_t *)_bump(sizeof(mem_pool_dtor_t), alignof(mem_pool_dtor_t));
+      if (!dtor) {
+        return nullptr;
+      }
+    }
+    void *mem = _bump(sizeof(T), alignof(T));
+    if (!mem) {
+      return nullptr;
+    }
+    T *obj = new (mem) T(std::forward<Args>(args)...);
+    if constexpr (!std::is_trivially_destructible<T>::value) {
+      dtor->prev    = _dtors;
+      dtor->destroy = [](void *ptr) {
+        ((T *)ptr)->~T();
+      };
+      dtor->obj = obj;
+      _dtors    = dtor;
+    }
+    return obj;
+  }
+
+  /* Save the current allocation state, see 'rewind()'. */
+  __inline__ mem_pool_mark_t __warn_unused __mem_pool_t_attr mark(void) const noexcept {
+    return {_chunk, _offset, _chained_used, _dtors};
+  }
+
+  /* Release everything allocated after 'm' was taken.  Destructors registered since then run
+   * in reverse order.  Marks taken after 'm' are invalid afterwards. */
+  __inline__ void __mem_pool_t_attr rewind(const mem_pool_mark_t &m) noexcept {
+    _run_dtors(m.dtors);
+    ALLOC_STATS_ONLY(_stats->record_free(used_memory() - (m.chained_used + m.offset));)
+    if (_head) {
+      _chunk        = m.chunk;
+      _pool         = _chunk_data(m.chunk);
+      _pool_size    = (m.chunk->size - sizeof(mem_pool_chunk_t));
+      _chained_used = m.chained_used;
+    }
+    _offset = m.offset;
+  }
+
+  /* O(1) in both modes, apart from running registered destructors.  Chained pools keep their chunks and reuse them in order. */
   __inline__ void __mem_pool_t_attr reset(void) noexcept {
+    _run_dtors(nullptr);
+    ALLOC_STATS_ONLY(_stats->record_free(used_memory());)
+    if (_head) {
+      _use_chunk(_head);
+      _chained_used = 0;
+      return;
+    }
     _offset = 0;
   }
 
   __inline__ Ulong __mem_pool_t_attr used_memory(void) noexcept {
-    return _offset;
+    return (_chained_used + _offset);
+  }
+
+#ifdef MLIB_ALLOC_STATS
+  /* Report this pool under 'tag' instead of the shared "mem_pool_t" site.  Use 'MEM_POOL_STATS_TAG()'. */
+  __inline__ void __mem_pool_t_attr stats_tag(const char *tag) noexcept {
+    _stats = alloc_stats_site(tag);
   }
+#endif
 
+  /* Return`s what is left in the current chunk, chained pools can grow beyond this. */
   __inline__ Ulong __mem_pool_t_attr available_memory(void) noexcept {
     return _pool_size - _offset;
   }
 };
+
+/* Rewinds 'pool' to where it was when the scope was entered. */
+template <Ulong Alignment>
+class mem_pool_scope_t {
+  mem_pool_t<Alignment> &_pool;
+  mem_pool_mark_t        _mark;
+
+ public:
+  explicit mem_pool_scope_t(mem_pool_t<Alignment> &pool) noexcept
+      : _pool(pool)
+      , _mark(pool.mark()) {
+  }
+
+  ~mem_pool_scope_t(void) noexcept {
+    _pool.rewind(_mark);
+  }
+
+  DEL_CM_CONSTRUCTORS(mem_pool_scope_t);
+};
 #undef __mem_pool_t_attr
+
+#ifdef MLIB_ALLOC_STATS
+#  define MEM_POOL_STATS_TAG(pool, tag) (pool).stats_tag(tag)
+#else
+#  define MEM_POOL_STATS_TAG(pool, tag) ((void)0)
+#endif
+
 #define MB (1024 * 1024)
 #define GB (1024 * MB)
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "Attributes.h"
+#include "Mem_pool.h"
+#include "Obj_pool.h"
+#include "def.h"
+
+#include <cstring>
+#include <memory_resource>
+#include <new>
+
+/* Exposes a 'mem_pool_t' to 'std::pmr' containers.  Deallocation is a no-op, the memory
+ * comes back when the pool is reset or rewound, so only use this for containers that do
+ * not outlive the pool`s current scope. */
+template <Ulong Alignment>
+class mem_pool_resource_t : public std::pmr::memory_resource {
+  mem_pool_t<Alignment> &_pool;
+
+  void *do_allocate(Ulong bytes, Ulong alignment) override {
+    void *ptr = _pool.alloc(bytes, alignment);
+    if (!ptr) {
+      throw std::bad_alloc();
+    }
+    return ptr;
+  }
+
+  void do_deallocate(void *, Ulong, Ulong) override {
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+    return (this == &other);
+  }
+
+ public:
+  explicit mem_pool_resource_t(mem_pool_t<Alignment> &pool) noexcept
+      : _pool(pool) {
+  }
+
+  DEL_CM_CONSTRUCTORS(mem_pool_resource_t);
+};
+
+/* Exposes the shared size class pools from 'slab_alloc()' to 'std::pmr' containers.  Node
+ * based containers (lists, maps, deques) get O(1), mostly lock free allocation and free. */
+class slab_resource_t : public std::pmr::memory_resource {
+  void *do_allocate(Ulong bytes, Ulong alignment) override;
+  void  do_deallocate(void *ptr, Ulong bytes, Ulong alignment) override;
+  bool  do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+};
+
+/* The process wide 'slab_resource_t'.  It is never destroyed, so it is safe to use from
+ * static destructors. */
+std::pmr::memory_resource *__warn_unused slab_resource(void) noexcept;
+
+/* 'MVector' allocator drawing from a 'mem_pool_t'.  Growth copies into a fresh block and the
+ * old one is left to the pool, so reserve up front when the final size is known. */
+template <Ulong Alignment>
+class mem_pool_alloc_t {
+  mem_pool_t<Alignment> *_pool;
+
+ public:
+  explicit mem_pool_alloc_t(mem_pool_t<Alignment> &pool) noexcept
+      : _pool(&pool) {
+  }
+
+  void *allocate(Ulong bytes, Ulong alignment) noexcept {
+    return _pool->alloc(bytes, alignment);
+  }
+
+  void *reallocate(void *ptr, Ulong old_bytes, Ulong new_bytes, Ulong alignment) noexcept {
+    void *data = _pool->alloc(new_bytes, alignment);
+    if (data && ptr) {
+      memcpy(data, ptr, ((old_bytes < new_bytes) ? old_bytes : new_bytes));
+    }
+    return data;
+  }
+
+  void deallocate(void *, Ulong, Ulong) noexcept {
+  }
+};
+
+/* 'MVector' allocator drawing from any 'std::pmr::memory_resource', such as 'slab_resource()'. */
+class pmr_alloc_t {
+  std::pmr::memory_resource *_resource;
+
+ public:
+  pmr_alloc_t(std::pmr::memory_resource *resource = std::pmr::get_default_resource()) noexcept
+      : _resource(resource) {
+  }
+
+  void *allocate(Ulong bytes, Ulong alignment) noexcept {
+    try {
+      return _resource->allocate(bytes, alignment);
+    }
+    catch (...) {
+      return nullptr;
+    }
+  }
+
+  void *reallocate(void *ptr, Ulong old_bytes, Ulong new_bytes, Ulong alignment) noexcept {
+    void *data = allocate(new_bytes, alignment);
+    if (data && ptr) {
+      memcpy(data, ptr, ((old_bytes < new_bytes) ? old_bytes : new_bytes));
+      deallocate(ptr, old_bytes, alignment);
+    }
+    return data;
+  }
+
+  void deallocate(void *ptr, Ulong bytes, Ulong alignment) noexcept {
+    if (ptr) {
+      _resource->deallocate(ptr, bytes, alignment);
+    }
+  }
+};
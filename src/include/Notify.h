@@ -3,6 +3,7 @@
 #include <cstdio>
 #include <errno.h>
 #include <fcntl.h>
+#include <memory_resource>
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/inotify.h>
@@ -11,6 +12,9 @@
 
 #include "Debug.h"
 #include "Flag.h"
+#include "HashMap.h"
+#include "SlotMap.h"
+#include "Str_intern.h"
 #include "Vector.h"
 
 namespace /* Tools */ {
@@ -28,12 +32,15 @@ struct FileEvent {
   CALLBACK;
 };
 
+/* Pending events for a 'FileListener', allocated from the resource given to its constructor. */
+typedef std::queue<FileEvent, std::pmr::deque<FileEvent>> FileEventQueue;
+
 class FileListener {
  private:
   int                   fd;
   int                   wd;
   pthread_t             thread;
-  std::queue<FileEvent> event_queue;
+  FileEventQueue        event_queue;
   pthread_mutex_t       queue_mutex;
   pthread_cond_t        queue_cond;
   bool                  running;
@@ -59,7 +66,8 @@ class FileListener {
   }
 
  public:
-  FileListener(void) {
+  FileListener(std::pmr::memory_resource *mr = std::pmr::get_default_resource())
+      : event_queue(std::pmr::polymorphic_allocator<FileEvent>(mr)) {
     fd = -1;
     wd = -1;
     running = TRUE;
@@ -150,7 +158,8 @@ class FileListenerHandler {
     Uint mask;
     CALLBACK;
   };
-  std::unordered_map<std::string, FileListenerThread *> _listeners;
+  /* Keyed by the interned path, which also keeps the path alive for the listener thread. */
+  MHashMap<str_id_t, FileListenerThread *> _listeners;
 
   static void *_handler(void *arg) {
     FileListenerThread *data = (FileListenerThread *)arg;
@@ -166,23 +175,30 @@ class FileListenerHandler {
   }
 
   void add_listener(const char *file_path, CALLBACK, Uint mask = DEFAULT_MASK) noexcept {
-    if (_listeners.count(file_path)) {
+    str_id_t id = str_intern(file_path);
+    auto [it, inserted] = _listeners.try_emplace(id, nullptr);
+    if (!inserted) {
       return;
     }
     FileListenerThread *data = new FileListenerThread();
-    data->file = file_path;
+    data->file = str_intern_cstr(id);
     data->mask = mask;
     data->callback = callback;
-    _listeners[file_path] = data;
+    it->second = data;
     pthread_create(&data->thread, NULL, _handler, data);
   }
 
   void stop_listener(const char *path) {
-    if (_listeners.count(path)) {
-      _listeners[path]->listener.stop();
-      pthread_join(_listeners[path]->thread, NULL);
-      delete _listeners[path];
-      _listeners.erase(path);
+    str_id_t id = str_intern_find(path);
+    if (id == STR_ID_NONE) {
+      return;
+    }
+    auto it = _listeners.find(id);
+    if (it != _listeners.end()) {
+      it->second->listener.stop();
+      pthread_join(it->second->thread, NULL);
+      delete it->second;
+      _listeners.erase(it);
     }
   }
 
@@ -205,7 +221,8 @@ typedef struct file_listener_t {
   DELETE_COPY_AND_MOVE_CONSTRUCTORS(file_listener_t);
 
  private:
-  char            *_file_path;
+  const char      *_file_path; /* Interned, never freed. */
+  str_id_t         _path_id;
   int              _fd;
   int              _wd;
   pthread_t        _callback_thread;
@@ -325,10 +342,8 @@ typedef struct file_listener_t {
     _callback_thread = 0;
     _listener_thread = 0;
     _flag.clear();
-    Ulong file_len = strlen(file);
-    _file_path = (char *)malloc(file_len + 1);
-    memcpy(_file_path, file, file_len);
-    _file_path[file_len] = '\0';
+    _path_id   = str_intern(file);
+    _file_path = str_intern_cstr(_path_id);
     pthread_mutex_init(&_mutex, NULL);
     pthread_cond_init(&_cond, NULL);
     _access_callback        = [](void *) {};
@@ -384,8 +399,6 @@ typedef struct file_listener_t {
     }
     pthread_mutex_destroy(&_mutex);
     pthread_cond_destroy(&_cond);
-    free(_file_path);
-    _file_path = NULL;
   }
 
   int start_listening(Uint mask = DEFAULT_MASK) _NO_THROW {
@@ -472,6 +485,10 @@ typedef struct file_listener_t {
   const char *const &get_file_path(void) const _NO_THROW {
     return _file_path;
   }
+
+  str_id_t get_path_id(void) const _NO_THROW {
+    return _path_id;
+  }
 } file_listener_t;
 
 static file_listener_t *make_file_listener(const char *file_path) _NO_THROW {
@@ -493,7 +510,7 @@ typedef struct file_listener_handler_t {
   DELETE_COPY_AND_MOVE_CONSTRUCTORS(file_listener_handler_t);
 
  private:
-  MVector<file_listener_t *> _data;
+  MSlotMap<file_listener_t *> _data;
 
  public:
   file_listener_handler_t(void) _NO_THROW {}
@@ -502,36 +519,62 @@ typedef struct file_listener_handler_t {
     stop_all();
   }
 
-  /* Do not add a listener without staring it after callbacks have been set.  Otherwise memory will leak */
-  file_listener_t *const &add_listener(const char *file_path) _NO_THROW {
-    return _data.push_back(make_file_listener(file_path)).back();
+  /* Do not add a listener without staring it after callbacks have been set.  Otherwise memory will leak.
+   * The returned handle stays valid until the listener is stopped, use it with 'get_listener()'. */
+  slot_handle_t add_listener(const char *file_path) _NO_THROW {
+    return _data.insert(make_file_listener(file_path));
   }
 
   /* If listener has been added but not started, this will leak memory. */
-  void stop_listener(const char *file_path) _NO_THROW {
-    file_listener_t *listener = get_listener(file_path);
+  void stop_listener(slot_handle_t handle) _NO_THROW {
+    file_listener_t *listener = get_listener(handle);
     if (!listener) {
-      logE("File listener for file: '%s' does not exist.", file_path);
+      logE("File listener handle: '%u' is stale.", handle);
       return;
     }
     free_file_listener(listener);
-    _data.erase(listener);
+    _data.remove(handle);
+  }
+
+  void stop_listener(const char *file_path) _NO_THROW {
+    slot_handle_t handle = find_listener(file_path);
+    if (handle == SLOT_HANDLE_NONE) {
+      logE("File listener for file: '%s' does not exist.", file_path);
+      return;
+    }
+    stop_listener(handle);
   }
 
   void stop_all(void) _NO_THROW {
-    for (Uint i = 0; i < _data.size(); ++i) {
-      free_file_listener(_data[i]);
+    for (file_listener_t *listener : _data) {
+      free_file_listener(listener);
     }
-    _data.resize(0);
+    _data.clear();
+  }
+
+  /* O(1), return`s NULL when the handle is stale. */
+  file_listener_t *get_listener(slot_handle_t handle) _NO_THROW {
+    file_listener_t **listener = _data.get(handle);
+    return (listener ? *listener : NULL);
   }
 
   file_listener_t *get_listener(const char *file_path) _NO_THROW {
-    for (const auto &listener : _data) {
-      if (strcmp(listener->get_file_path(), file_path) == 0) {
-        return listener;
+    return get_listener(find_listener(file_path));
+  }
+
+  /* Scan for the listener watching 'file_path', comparing interned ids.  Prefer keeping the handle
+   * from 'add_listener()'. */
+  slot_handle_t find_listener(const char *file_path) _NO_THROW {
+    str_id_t id = str_intern_find(file_path);
+    if (id == STR_ID_NONE) {
+      return SLOT_HANDLE_NONE;
+    }
+    for (Uint i = 0; i < _data.size(); ++i) {
+      if (_data.data()[i]->get_path_id() == id) {
+        return _data.handle_at(i);
       }
     }
-    return NULL;
+    return SLOT_HANDLE_NONE;
   }
 } file_listener_handler_t;
 
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "Attributes.h"
+#include "Mem_pool.h"
+#include "def.h"
+
+#include <utility>
+
+/* Size classes served by 'slab_alloc()'.  Anything larger goes straight to malloc. */
+#define SLAB_CLASS_COUNT 18
+#define SLAB_MAX_SIZE    4096UL
+/* How many objects a thread cache moves to or from the shared pool at once. */
+#define SLAB_BATCH       32
+
+#define __fixed_pool_t_attr __attr(__always_inline__, __nodebug__, __nothrow__)
+/* Free list pool for objects of a single size.  Objects are carved from mapped chunks on
+ * demand, and freed objects are reused first.  Both 'alloc()' and 'free()' are O(1).
+ * Not thread safe, see 'slab_alloc()' for the shared, thread cached variant. */
+class fixed_pool_t {
+  struct node_t {
+    node_t *next;
+  };
+
+  node_t           *_free;
+  char             *_cursor;
+  char             *_end;
+  mem_pool_chunk_t *_chunks;
+  Ulong             _obj_size;
+  Ulong             _chunk_size;
+  Uint              _flags;
+
+  /* Map the next chunk and start carving from it. */
+  void *__warn_unused __attr(__noinline__, __cold__) _grow(void) noexcept;
+
+ public:
+  /* 'obj_size' is rounded up to a multiple of 16, so every object is 16 byte aligned.
+   * 'flags' accepts 'MEM_POOL_HUGEPAGE' and 'MEM_POOL_POPULATE'. */
+  explicit fixed_pool_t(Ulong obj_size, Ulong chunk_size = (64 * 1024), Uint flags = 0) noexcept;
+  ~fixed_pool_t(void) noexcept;
+
+  DEL_CM_CONSTRUCTORS(fixed_pool_t);
+
+  __inline__ void *__warn_unused __fixed_pool_t_attr alloc(void) noexcept {
+    if (_free) {
+      node_t *node = _free;
+      _free        = node->next;
+      return node;
+    }
+    if ((_cursor + _obj_size) <= _end) [[likely]] {
+      void *ptr = _cursor;
+      _cursor += _obj_size;
+      return ptr;
+    }
+    return _grow();
+  }
+
+  __inline__ void __fixed_pool_t_attr free(void *ptr) noexcept {
+    node_t *node = (node_t *)ptr;
+    node->next   = _free;
+    _free        = node;
+  }
+
+  /* Pop up to 'count' objects as a linked list through their first word.  Return`s how many were taken. */
+  Ulong alloc_batch(void **first, Ulong count) noexcept;
+  /* Push a list of 'count' objects linked through their first word, ending at 'last'. */
+  void free_batch(void *first, void *last) noexcept;
+
+  __inline__ Ulong __fixed_pool_t_attr obj_size(void) const noexcept {
+    return _obj_size;
+  }
+};
+#undef __fixed_pool_t_attr
+
+/* Allocate 'size' bytes from the shared size class pools.  Each thread keeps a small cache
+ * per class, so the common case never takes a lock.  The memory is 16 byte aligned. */
+void *__warn_unused slab_alloc(Ulong size) noexcept;
+/* Release memory from 'slab_alloc()', 'size' must be the same size it was allocated with.
+ * Memory can be freed from any thread. */
+void slab_free(void *ptr, Ulong size) noexcept;
+
+template <typename T, typename... Args>
+__inline__ T *__warn_unused slab_new(Args &&...args) noexcept {
+  static_assert(alignof(T) <= 16, "slab_new does not support over aligned types.");
+  void *mem = slab_alloc(sizeof(T));
+  if (!mem) {
+    return nullptr;
+  }
+  return new (mem) T(std::forward<Args>(args)...);
+}
+
+template <typename T>
+__inline__ void slab_delete(T *ptr) noexcept {
+  if (!ptr) {
+    return;
+  }
+  ptr->~T();
+  slab_free(ptr, sizeof(T));
+}
+
+#define __obj_pool_t_attr __attr(__always_inline__, __nodebug__, __nothrow__)
+/* Typed, single threaded pool.  Use this when one owner creates and destroys many 'T`s. */
+template <typename T>
+class obj_pool_t {
+  static_assert(alignof(T) <= 16, "obj_pool_t does not support over aligned types.");
+
+  fixed_pool_t _pool;
+
+ public:
+  explicit obj_pool_t(Ulong chunk_size = (64 * 1024), Uint flags = 0) noexcept
+      : _pool(sizeof(T), chunk_size, flags) {
+  }
+
+  DEL_CM_CONSTRUCTORS(obj_pool_t);
+
+  template <typename... Args>
+  __inline__ T *__warn_unused __obj_pool_t_attr create(Args &&...args) noexcept {
+    void *mem = _pool.alloc();
+    if (!mem) {
+      return nullptr;
+    }
+    return new (mem) T(std::forward<Args>(args)...);
+  }
+
+  __inline__ void __obj_pool_t_attr destroy(T *ptr) noexcept {
+    if (!ptr) {
+      return;
+    }
+    ptr->~T();
+    _pool.free(ptr);
+  }
+};
+#undef __obj_pool_t_attr
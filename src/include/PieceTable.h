@@ -0,0 +1,136 @@
+#pragma once
+
+#include "Attributes.h"
+#include "Vector.h"
+#include "def.h"
+
+#include <string>
+
+#define PIECE_NONE ((Uint)-1)
+
+#define __piece_table_attr __attr(__always_inline__, __nodebug__, __nothrow__)
+/* Piece table text buffer.  A loaded file stays as one read-only mapping, every edit only appends
+ * the inserted text to a second buffer and splits or trims the pieces that refer into the two.
+ * Pieces live in a treap keyed by position, each node carrying the byte and newline totals of its
+ * subtree, so offset and line lookups as well as edits are O(log n) in the number of pieces.
+ * Nodes are indices into one 'MVector', so editing never calls malloc per piece or per line.
+ *
+ *   MPieceTable text;
+ *   text.load("main.cpp");
+ *   text.insert(text.line_offset(10), "// Hello\n", 9);
+ *   std::string line = text.line(10);
+ */
+class MPieceTable {
+  enum : Uchar {
+    ORIGINAL,
+    ADDED
+  };
+
+  struct node_t {
+    Ulong start;   /* Offset into the buffer. */
+    Ulong len;
+    Ulong sub_len; /* Total bytes in this subtree. */
+    Uint  nl;      /* Newlines inside this piece. */
+    Uint  sub_nl;  /* Total newlines in this subtree. */
+    Uint  left;
+    Uint  right;   /* Next free node while on the free list. */
+    Uint  prio;
+    Uchar buf;
+  };
+
+  const char     *_orig;
+  Ulong           _orig_len;
+  MVector<char>   _add;
+  MVector<Ulong>  _nl[2];    /* Position of every newline, per buffer, ascending. */
+  MVector<node_t> _nodes;
+  Uint            _root;
+  Uint            _free;
+  Uint            _seed;
+
+  __inline__ const char *__warn_unused __piece_table_attr _buf(Uchar buf) const noexcept {
+    return ((buf == ORIGINAL) ? _orig : _add.data());
+  }
+
+  __inline__ Ulong __warn_unused __piece_table_attr _sub_len(Uint n) const noexcept {
+    return ((n == PIECE_NONE) ? 0 : _nodes[n].sub_len);
+  }
+
+  __inline__ Uint __warn_unused __piece_table_attr _sub_nl(Uint n) const noexcept {
+    return ((n == PIECE_NONE) ? 0 : _nodes[n].sub_nl);
+  }
+
+  __inline__ void __piece_table_attr _update(Uint n) noexcept {
+    node_t &node = _nodes[n];
+    node.sub_len = (_sub_len(node.left) + node.len + _sub_len(node.right));
+    node.sub_nl  = (_sub_nl(node.left) + node.nl + _sub_nl(node.right));
+  }
+
+  /* Index of the first newline at or after 'pos' in 'buf'. */
+  Ulong _nl_rank(Uchar buf, Ulong pos) const noexcept;
+  Uint  _count_nl(Uchar buf, Ulong start, Ulong len) const noexcept;
+  Uint  _new_node(Uchar buf, Ulong start, Ulong len) noexcept;
+  void  _free_tree(Uint n) noexcept;
+  Uint  _merge(Uint l, Uint r) noexcept;
+  void  _split(Uint n, Ulong offset, Uint &l, Uint &r) noexcept;
+  bool  _extend_last(Uint n, Ulong start, Ulong len, Uint nl) noexcept;
+  Ulong _copy(Uint n, Ulong offset, Ulong len, char *out) const noexcept;
+  void  _reset(void) noexcept;
+
+  template <typename F>
+  void _walk(Uint n, F &f) const {
+    while (n != PIECE_NONE) {
+      _walk(_nodes[n].left, f);
+      const node_t &node = _nodes[n];
+      f((_buf(node.buf) + node.start), node.len);
+      n = node.right;
+    }
+  }
+
+ public:
+  MPieceTable(void) noexcept;
+  ~MPieceTable(void) noexcept;
+
+  DEL_CM_CONSTRUCTORS(MPieceTable);
+
+  /* Map 'path' as the original buffer, dropping any current content.  Return`s false if the file
+   * could not be opened or mapped, the table is then left empty. */
+  bool load(const char *path) noexcept;
+  /* Replace the content with a copy of 'str'. */
+  void assign(const char *str, Ulong len) noexcept;
+
+  void insert(Ulong offset, const char *str, Ulong len) noexcept;
+  void erase(Ulong offset, Ulong len) noexcept;
+
+  __inline__ Ulong __warn_unused __piece_table_attr size(void) const noexcept {
+    return _sub_len(_root);
+  }
+
+  /* A trailing line without a newline counts, so an empty buffer has one line. */
+  __inline__ Uint __warn_unused __piece_table_attr line_count(void) const noexcept {
+    return (_sub_nl(_root) + 1);
+  }
+
+  /* Offset of the first byte of 'line', 'size()' when 'line' is past the end. */
+  Ulong line_offset(Uint line) const noexcept;
+  /* Line that 'offset' is on. */
+  Uint line_of(Ulong offset) const noexcept;
+  /* Length of 'line' excluding its newline. */
+  Ulong line_length(Uint line) const noexcept;
+
+  char at(Ulong offset) const noexcept;
+  /* Copy atmost 'len' bytes starting at 'offset' into 'out', return`s the number copied. */
+  Ulong copy(Ulong offset, Ulong len, char *out) const noexcept;
+  /* 'line' without its newline. */
+  std::string line(Uint line) const;
+  /* The whole buffer as one string. */
+  std::string str(void) const;
+  /* Write the content to 'path', return`s false on failure. */
+  bool save(const char *path) const noexcept;
+
+  /* Call 'f(const char *data, Ulong len)' for every piece in order, without copying anything. */
+  template <typename F>
+  void for_each_piece(F &&f) const {
+    _walk(_root, f);
+  }
+};
+#undef __piece_table_attr
@@ -5,10 +5,13 @@
 #include <vector>
 
 #include "Attributes.h"
+#include "FlatMap.h"
+#include "Str_intern.h"
 #include "def.h"
 
 namespace Mlib::Profile {
   using std::map;
+  using std::pair;
   using std::string;
   using std::string_view;
   using std::vector;
@@ -44,16 +47,23 @@ namespace Mlib::Profile {
     vector<double> values;
   };
 
+  /* Per name statistics keyed by the interned name, so recording a sample only compares ids.
+   * Reports sort by the name text. */
+  typedef MFlatMap<str_id_t, ProfilerStats> ProfilerStatsMap;
+
   class GlobalProfiler {
    private:
-    map<string, ProfilerStats> stats;
+    ProfilerStatsMap           stats;
     string                     output_file;
     static GlobalProfiler     *instance;
     GlobalProfiler(void) noexcept;
     static void _destroy(void) noexcept;
+    /* Every entry of 'stats', ordered by name. */
+    vector<pair<string_view, const ProfilerStats *>> _by_name(void) const;
 
    public:
-    void record(const string &name, double duration);
+    void record(str_id_t name, double duration);
+    void record(string_view name, double duration);
     void report(void);
     void setOutputFile(string_view file_path);
 
@@ -67,11 +77,13 @@ namespace Mlib::Profile {
 
   class AutoTimer {
    private:
-    string name;
+    str_id_t name;
     time_point<high_resolution_clock> start;
 
    public:
-    AutoTimer(const string &name);
+    /* Pass an id interned once, 'PROFILE_CURRENT_SCOPE()' does that per call site. */
+    AutoTimer(str_id_t name);
+    AutoTimer(string_view name);
     ~AutoTimer(void);
   };
 
@@ -84,9 +96,13 @@ namespace Mlib::Profile {
   void setupReportGeneration(string_view file_path);
 }
 
+#define __PROFILE_CONCAT_(a, b)       a##b
+#define __PROFILE_CONCAT(a, b)        __PROFILE_CONCAT_(a, b)
 #define GLOBALPROFILER                Mlib::Profile::GlobalProfiler::Instance()
-#define PROFILE_CURRENT_SCOPE(__Name) Mlib::Profile::AutoTimer PROFILE_CURRENT_SCOPE__(__Name)
+/* Time the rest of the enclosing scope under '__Name'.  The name is interned once per call site,
+ * and the variables are named after the line, so several can share a scope. */
+#define PROFILE_CURRENT_SCOPE(__Name)                                                   \
+  static const str_id_t __PROFILE_CONCAT(__profile_id_, __LINE__) = str_intern(__Name); \
+  Mlib::Profile::AutoTimer __PROFILE_CONCAT(__profile_timer_, __LINE__)(__PROFILE_CONCAT(__profile_id_, __LINE__))
 #define PROFILE_FUNCTION              PROFILE_CURRENT_SCOPE(__FUNCTION__)
 #define PROFILE_SCOPE                 PROFILE_CURRENT_SCOPE(__PRETTY_FUNCTION__)
-
-PROFILE_CURRENT_SCOPE();
\ No newline at end of file
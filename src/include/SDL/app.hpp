@@ -9,6 +9,7 @@
 
 #include "../Attributes.h"
 #include "../Flag.h"
+#include "../Frame_alloc.h"
 #include "../Init_list.h"
 #include "../Mem_pool.h"
 #include "../Vector.h"
@@ -56,6 +57,8 @@ class app {
 
  public:
   mem_pool_t<8> mem_pool;
+  /* Scratch memory for the current frame, recycled by 'run()'. */
+  frame_alloc_t frame_alloc;
   window       *root;
 
   static app *__warn_unused  instance(void) noexcept;
@@ -5,7 +5,7 @@
 #include <functional>
 
 #include "../Attributes.h"
-#include "../Vector.h"
+#include "../SmallVector.h"
 #include "../def.h"
 
 constexpr Uint event_to_index(const Uint type) {
@@ -344,7 +344,8 @@ constexpr Uint event_to_index(const Uint type) {
 #define TOTAL_EVENTS 107
 
 using event_callback_t = std::function<void(SDL_Event ev)>;
-using event_vector_t   = MVector<event_callback_t>;
+/* Most events have at most a couple of actions, so keep those inline. */
+using event_vector_t   = MSmallVector<event_callback_t, 2>;
 
 class event_handler {
  private:
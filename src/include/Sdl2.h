@@ -15,6 +15,7 @@
 #        include <string>
 #        include <unordered_map>
 #        include <vector>
+#        include "HashMap.h"
 #        include "Vector.h"
 
 #        include "Debug.h"
@@ -157,7 +158,7 @@ namespace Mlib::Sdl2
         void onStaticObjCollision(Object2D const &obj, Vec2D velVecToApply);
     } Object2D;
 
-    using KeyMap = unordered_map<unsigned char, vector<function<void()>>>;
+    using KeyMap = MHashMap<unsigned char, vector<function<void()>>>;
     /* This Class Represents The Keyboard Object, it Is Used To Handle Keyboard
      * Events It Is The Interface Between The Keyboard And the Engine Note This
      * Class Is A Singleton Class, And Can Only Be Accessed Through The
@@ -0,0 +1,178 @@
+#pragma once
+/* clang-format off */
+
+#include "Attributes.h"
+#include "Debug.h"
+#include "Vector.h"
+#include "def.h"
+
+/* 32 bit handle into a 'MSlotMap'.  The low 'SLOT_HANDLE_INDEX_BITS' bits select the slot, the
+ * rest is the slot`s generation at the time of insertion, so a handle to a removed value never
+ * matches the value that later reuses its slot.  Generations start at one, so zero is never valid. */
+typedef Uint slot_handle_t;
+
+#define SLOT_HANDLE_INDEX_BITS 20
+#define SLOT_HANDLE_INDEX_MASK ((1u << SLOT_HANDLE_INDEX_BITS) - 1)
+#define SLOT_HANDLE_GEN_MASK   ((1u << (32 - SLOT_HANDLE_INDEX_BITS)) - 1)
+#define SLOT_HANDLE_NONE       ((slot_handle_t)0)
+
+namespace /* Defines. */ {
+  #define __type_ptr __inline__ T *__warn_unused __attribute((__always_inline__, __nothrow__, __nodebug__))
+  #define __bool __inline__ bool __warn_unused __attribute((__always_inline__, __nothrow__, __nodebug__))
+  #define __Uint __inline__ Uint __warn_unused __attribute((__always_inline__, __nothrow__, __nodebug__))
+  #define __handle __inline__ slot_handle_t __warn_unused __attribute((__always_inline__, __nothrow__, __nodebug__))
+}
+
+/* Generational slot map.  Values are stored densely, so iterating them is a plain array walk,
+ * while handles stay valid across removal of other values and lookup is O(1).  Removal moves
+ * the last value into the hole, so raw pointers into the map are not stable, handles are.
+ * Holds at most '1 << SLOT_HANDLE_INDEX_BITS' values at once. */
+template <class T>
+class MSlotMap {
+  struct slot_t {
+    Uint index; /* Dense index while live, next free slot while free. */
+    Uint gen;
+  };
+
+  MVector<T>      _values;
+  MVector<Uint>   _owner;    /* Slot of every dense value. */
+  MVector<slot_t> _slots;
+  Uint            _free_head;
+
+  __inline__ slot_t *__warn_unused __attribute((__always_inline__, __nothrow__, __nodebug__)) _lookup(slot_handle_t handle) {
+    Uint idx = (handle & SLOT_HANDLE_INDEX_MASK);
+    if (idx >= _slots.size() || _slots[idx].gen != (handle >> SLOT_HANDLE_INDEX_BITS) || handle == SLOT_HANDLE_NONE) {
+      return nullptr;
+    }
+    return &_slots[idx];
+  }
+
+  __inline__ const slot_t *__warn_unused __attribute((__always_inline__, __nothrow__, __nodebug__)) _lookup(slot_handle_t handle) const {
+    return const_cast<MSlotMap *>(this)->_lookup(handle);
+  }
+
+  /* Claim a slot for the value about to be placed at the end of '_values'. */
+  slot_handle_t _claim(void) {
+    Uint idx;
+    if (_free_head != (Uint)-1) {
+      idx        = _free_head;
+      _free_head = _slots[idx].index;
+    }
+    else {
+      idx = _slots.size();
+      if (idx > SLOT_HANDLE_INDEX_MASK) {
+        logE("MSlotMap is full, %u slots in use.", idx);
+        return SLOT_HANDLE_NONE;
+      }
+      _slots.push_back({0, 1});
+    }
+    _slots[idx].index = _values.size();
+    _owner.push_back(idx);
+    return ((_slots[idx].gen << SLOT_HANDLE_INDEX_BITS) | idx);
+  }
+
+ public:
+  MSlotMap(void) : _free_head((Uint)-1) {}
+
+  /* Return`s the handle for the new value, or 'SLOT_HANDLE_NONE' when the map is full. */
+  template <typename ...Args>
+  slot_handle_t emplace(Args &&...args) {
+    slot_handle_t handle = _claim();
+    if (handle != SLOT_HANDLE_NONE) {
+      _values.emplace_back(std::forward<Args>(args)...);
+    }
+    return handle;
+  }
+
+  __handle insert(const T &value) {
+    return emplace(value);
+  }
+
+  __handle insert(T &&value) {
+    return emplace((T &&)value);
+  }
+
+  /* Return`s nullptr when 'handle' is stale or was never valid. */
+  __type_ptr get(slot_handle_t handle) {
+    slot_t *slot = _lookup(handle);
+    return (slot ? &_values[slot->index] : nullptr);
+  }
+
+  const __type_ptr get(slot_handle_t handle) const {
+    const slot_t *slot = _lookup(handle);
+    return (slot ? &_values[slot->index] : nullptr);
+  }
+
+  __bool contains(slot_handle_t handle) const {
+    return (_lookup(handle) != nullptr);
+  }
+
+  /* Remove the value for 'handle', every handle to it goes stale.  Return`s false when the handle
+   * was already stale. */
+  bool remove(slot_handle_t handle) {
+    slot_t *slot = _lookup(handle);
+    if (!slot) {
+      return false;
+    }
+    Uint dense = slot->index;
+    Uint last  = (_values.size() - 1);
+    _values.swap_remove(dense);
+    _owner.swap_remove(dense);
+    if (dense != last) {
+      _slots[_owner[dense]].index = dense;
+    }
+    /* Generation zero is reserved for 'SLOT_HANDLE_NONE'. */
+    slot->gen   = (((slot->gen + 1) & SLOT_HANDLE_GEN_MASK) ? ((slot->gen + 1) & SLOT_HANDLE_GEN_MASK) : 1);
+    slot->index = _free_head;
+    _free_head  = (handle & SLOT_HANDLE_INDEX_MASK);
+    return true;
+  }
+
+  /* Remove every value, all handles go stale. */
+  void clear(void) {
+    while (!_values.empty()) {
+      remove(handle_at(_values.size() - 1));
+    }
+  }
+
+  __Uint size(void) const {
+    return _values.size();
+  }
+
+  __bool empty(void) const {
+    return _values.empty();
+  }
+
+  /* The handle of the value at dense position 'index', for use while iterating. */
+  __handle handle_at(Uint index) const {
+    Uint idx = _owner[index];
+    return ((_slots[idx].gen << SLOT_HANDLE_INDEX_BITS) | idx);
+  }
+
+  __type_ptr begin(void) {
+    return _values.begin();
+  }
+
+  const __type_ptr begin(void) const {
+    return _values.begin();
+  }
+
+  __type_ptr end(void) {
+    return _values.end();
+  }
+
+  const __type_ptr end(void) const {
+    return _values.end();
+  }
+
+  __type_ptr data(void) {
+    return _values.data();
+  }
+};
+
+namespace /* Undef defines. */ {
+  #undef __type_ptr
+  #undef __bool
+  #undef __Uint
+  #undef __handle
+}
@@ -0,0 +1,502 @@
+#pragma once
+/* clang-format off */
+
+#include "Attributes.h"
+#include "Debug.h"
+#include "def.h"
+
+#include <cstring>
+
+namespace /* Defines. */ {
+  #define __nothrow_default_constructor          noexcept(is_nothrow_default_constructible_v<T>)
+  #define __nothrow_destructible                 noexcept(is_nothrow_destructible_v<T>)
+  #define __nothrow_copy_constructible           noexcept(is_nothrow_copy_constructible_v<T>)
+  #define __nothrow_move_constructible           noexcept(is_nothrow_move_constructible_v<T>)
+  #define __nothrow_move_copy_constructible      noexcept(is_nothrow_move_constructible_v<T> && is_nothrow_copy_constructible_v<T>)
+  #define __nothrow_move_destruct_constructible  noexcept(is_nothrow_move_constructible_v<T> && is_nothrow_destructible_v<T>)
+
+  #define __ref  __inline__ MSmallVector & __attribute((__always_inline__, __nothrow__, __nodebug__))
+  #define __type_ref __inline__ T &__warn_unused __attribute((__always_inline__, __nothrow__, __nodebug__))
+  #define __type_ptr __inline__ T *__warn_unused __attribute((__always_inline__, __nothrow__, __nodebug__))
+  #define __bool __inline__ bool __warn_unused __attribute((__always_inline__, __nothrow__, __nodebug__))
+  #define __Uint __inline__ Uint __warn_unused __attribute((__always_inline__, __nothrow__, __nodebug__))
+  #define __void __inline__ void __attribute((__always_inline__, __nothrow__, __nodebug__))
+}
+
+/* Vector that keeps up to 'N' elements inline and only spills to the heap past that.
+ * The api matches 'MVector', so it can be swapped in where vectors are usually tiny.
+ * Note that pointers into the vector are invalidated when it spills, just like on growth. */
+template <class T, Uint N>
+class MSmallVector {
+  static_assert(N > 0, "MSmallVector needs atleast one inline element.");
+
+ private:
+  T   *_data;
+  Uint _len;
+  Uint _cap;
+  alignas(T) Uchar _inline[N * sizeof(T)];
+
+  __bool _is_inline(void) const {
+    return (_data == (T *)_inline);
+  }
+
+  /* Move every element into a new heap block of 'cap' elements. */
+  void __attribute((__noinline__)) _grow(Uint cap) __nothrow_move_destruct_constructible {
+    T *data = (T *)malloc(sizeof(T) * cap);
+    if (!data) {
+      logE("MSmallVector failed to grow to %u elements.", cap);
+      exit(1);
+    }
+    if constexpr (std::is_trivially_copyable_v<T>) {
+      memcpy(data, _data, (sizeof(T) * _len));
+    }
+    else {
+      for (Uint i = 0; i < _len; ++i) {
+        new (data + i) T((T &&)_data[i]);
+        _data[i].~T();
+      }
+    }
+    if (!_is_inline()) {
+      free(_data);
+    }
+    _data = data;
+    _cap  = cap;
+  }
+
+  __void _ensure_space(void) __nothrow_move_destruct_constructible {
+    if (_len == _cap) [[unlikely]] {
+      _grow(_cap * 2);
+    }
+  }
+
+  __void _destroy_all(void) __nothrow_destructible {
+    if constexpr (!is_trivially_destructible_v<T>) {
+      for (Uint i = 0; i < _len; ++i) {
+        _data[i].~T();
+      }
+    }
+    _len = 0;
+  }
+
+  /* Take over 'other`s elements, leaving it empty and inline. */
+  __void _steal(MSmallVector &other) __nothrow_move_constructible {
+    if (other._is_inline()) {
+      _data = (T *)_inline;
+      _cap  = N;
+      for (Uint i = 0; i < other._len; ++i) {
+        new (_data + i) T((T &&)other._data[i]);
+        other._data[i].~T();
+      }
+      _len = other._len;
+    }
+    else {
+      _data = other._data;
+      _len  = other._len;
+      _cap  = other._cap;
+    }
+    other._data = (T *)other._inline;
+    other._len  = 0;
+    other._cap  = N;
+  }
+
+ public:
+  template <typename ...Args>
+  __void emplace_back(Args &&...args) __nothrow_move_copy_constructible {
+    if (_len == _cap) [[unlikely]] {
+      /* 'args' may refer to our own elements, build the value before they move. */
+      T value{std::forward<Args>(args)...};
+      _grow(_cap * 2);
+      new (_data + _len) T((T &&)value);
+      ++_len;
+      return;
+    }
+    new (_data + _len) T{std::forward<Args>(args)...};
+    ++_len;
+  }
+
+  __ref push_back(const T &element) __nothrow_copy_constructible {
+    if (_len == _cap) [[unlikely]] {
+      /* 'element' may live in the storage we are about to release. */
+      T copy(element);
+      _grow(_cap * 2);
+      new (_data + _len) T((T &&)copy);
+      ++_len;
+      return *this;
+    }
+    new (_data + _len) T(element);
+    ++_len;
+    return *this;
+  }
+
+  __ref push_back(T &&element) __nothrow_move_constructible {
+    if (_len == _cap) [[unlikely]] {
+      T moved((T &&)element);
+      _grow(_cap * 2);
+      new (_data + _len) T((T &&)moved);
+      ++_len;
+      return *this;
+    }
+    new (_data + _len) T((T &&)element);
+    ++_len;
+    return *this;
+  }
+
+  __void pop_back(void) __nothrow_destructible {
+    if (_len > 0) {
+      --_len;
+      if constexpr (!is_trivially_destructible_v<T>) {
+        _data[_len].~T();
+      }
+    }
+  }
+
+  __void insert(Uint idx, const T &value) __nothrow_move_copy_constructible {
+    if (idx > _len) {
+      return;
+    }
+    /* 'value' may be one of our own elements, which growing releases and shifting moves. */
+    T copy(value);
+    _ensure_space();
+    if (idx == _len) {
+      new (_data + _len) T((T &&)copy);
+    }
+    else {
+      new (_data + _len) T((T &&)_data[_len - 1]);
+      for (Uint i = (_len - 1); i > idx; --i) {
+        _data[i] = (T &&)_data[i - 1];
+      }
+      _data[idx] = (T &&)copy;
+    }
+    ++_len;
+  }
+
+  template <typename Callback, typename ...Args>
+  __void foreach(Callback &&callback, Args &&...args) {
+    for (T *it = begin(); it != end(); ++it) {
+      callback(it, std::forward<Args>(args)...);
+    }
+  }
+
+  template <typename Callback, typename ...Args>
+  __void rforeach(Callback &&callback, Args &&...args) {
+    for (T *it = rbegin(); it != rend(); --it) {
+      callback(it, std::forward<Args>(args)...);
+    }
+  }
+
+  template <typename Callback, typename ...Args>
+  __void foreach(Callback &&callback, Args &&...args) const {
+    for (const T *it = begin(); it != end(); ++it) {
+      callback(it, std::forward<Args>(args)...);
+    }
+  }
+
+  template <typename Callback, typename ...Args>
+  __void rforeach(Callback &&callback, Args &&...args) const {
+    for (const T *it = rbegin(); it != rend(); --it) {
+      callback(it, std::forward<Args>(args)...);
+    }
+  }
+
+  __ref erase_at(Uint index) __nothrow_move_destruct_constructible {
+    if (index < _len) {
+      for (Uint i = index; i < (_len - 1); ++i) {
+        _data[i] = (T &&)_data[i + 1];
+      }
+      pop_back();
+    }
+    return *this;
+  }
+
+  __ref erase(const T *const &element) __nothrow_move_destruct_constructible {
+    Uint idx = index_of(element);
+    if (idx == (Uint)-1) {
+      return *this;
+    }
+    erase_at(idx);
+    return *this;
+  }
+
+  __ref erase(const T &element) __nothrow_move_destruct_constructible {
+    Uint idx = index_of(element);
+    if (idx == (Uint)-1) {
+      return *this;
+    }
+    erase_at(idx);
+    return *this;
+  }
+
+  /* Erase the elements in '[first, last)', moving the tail down once. */
+  __ref erase_range(Uint first, Uint last) __nothrow_move_destruct_constructible {
+    if (last > _len) {
+      last = _len;
+    }
+    if (first < last) {
+      Uint n = (last - first);
+      for (Uint i = last; i < _len; ++i) {
+        _data[i - n] = (T &&)_data[i];
+      }
+      if constexpr (!is_trivially_destructible_v<T>) {
+        for (Uint i = (_len - n); i < _len; ++i) {
+          _data[i].~T();
+        }
+      }
+      _len -= n;
+    }
+    return *this;
+  }
+
+  /* Erase the element at 'index' by moving the last element into its place, without keeping order. */
+  __ref swap_remove(Uint index) __nothrow_move_destruct_constructible {
+    if (index < _len) {
+      if (index != (_len - 1)) {
+        _data[index] = (T &&)_data[_len - 1];
+      }
+      pop_back();
+    }
+    return *this;
+  }
+
+  /* Same as 'MVector::remove_if()'. */
+  template <typename Pred>
+  __inline__ Uint __warn_unused __attribute((__always_inline__, __nodebug__)) remove_if(Pred &&pred) {
+    Uint keep = 0;
+    for (Uint i = 0; i < _len; ++i) {
+      if (!pred(_data[i])) {
+        if (keep != i) {
+          _data[keep] = (T &&)_data[i];
+        }
+        ++keep;
+      }
+    }
+    return keep;
+  }
+
+  /* Erase every element 'pred' accepts, in a single pass.  Return`s the number erased. */
+  template <typename Pred>
+  __inline__ Uint __attribute((__always_inline__, __nodebug__)) erase_if(Pred &&pred) {
+    Uint len  = _len;
+    Uint keep = remove_if((Pred &&)pred);
+    erase_range(keep, len);
+    return (len - keep);
+  }
+
+  /* Destroy all elements.  The storage is kept, so refilling it does not allocate. */
+  __ref clear(void) __nothrow_destructible {
+    _destroy_all();
+    return *this;
+  }
+
+  /* Move the elements back inline when they fit, otherwise trim the heap block. */
+  __void shrink_to_fit(void) __nothrow_move_destruct_constructible {
+    if (_is_inline() || _len == _cap) {
+      return;
+    }
+    if (_len <= N) {
+      T *heap = _data;
+      _data   = (T *)_inline;
+      for (Uint i = 0; i < _len; ++i) {
+        new (_data + i) T((T &&)heap[i]);
+        heap[i].~T();
+      }
+      free(heap);
+      _cap = N;
+    }
+    else {
+      _grow(_len);
+    }
+  }
+
+  __Uint size(void) const {
+    return _len;
+  }
+
+  __Uint capacity(void) const {
+    return _cap;
+  }
+
+  __bool empty(void) const {
+    return (_len == 0);
+  }
+
+  __ref resize(Uint newlen) __nothrow_default_constructor {
+    if (newlen < _len) {
+      if constexpr (!is_trivially_destructible_v<T>) {
+        for (Uint i = newlen; i < _len; ++i) {
+          _data[i].~T();
+        }
+      }
+      _len = newlen;
+    }
+    else if (newlen > _len) {
+      reserve(newlen);
+      for (Uint i = _len; i < newlen; ++i) {
+        new (_data + i) T();
+      }
+      _len = newlen;
+    }
+    return *this;
+  }
+
+  __ref reserve(Uint size) __nothrow_move_destruct_constructible {
+    if (size > _cap) {
+      _grow(size);
+    }
+    return *this;
+  }
+
+  __type_ref back(void) {
+    return (_len > 0) ? *(_data + (_len - 1)) : *_data;
+  }
+
+  const __type_ref back(void) const {
+    return (_len > 0) ? *(_data + (_len - 1)) : *_data;
+  }
+
+  __type_ptr data(void) {
+    return _data;
+  }
+
+  const __type_ptr data(void) const {
+    return _data;
+  }
+
+  __type_ptr begin(void) {
+    return _data;
+  }
+
+  const __type_ptr begin(void) const {
+    return _data;
+  }
+
+  __type_ptr end(void) {
+    return (_data + _len);
+  }
+
+  const __type_ptr end(void) const {
+    return (_data + _len);
+  }
+
+  __type_ptr rbegin(void) {
+    return (_len > 0) ? ((_data + _len) - 1) : _data;
+  }
+
+  const __type_ptr rbegin(void) const {
+    return (_len > 0) ? ((_data + _len) - 1) : _data;
+  }
+
+  __type_ptr rend(void) {
+    return (_len > 0) ? (_data - 1) : _data;
+  }
+
+  const __type_ptr rend(void) const {
+    return (_len > 0) ? (_data - 1) : _data;
+  }
+
+  /* Return`s the index of an element, or -1 on failure. */
+  __Uint index_of(const T *const &element) const {
+    return (element >= begin() && element < end()) ? (element - begin()) : (Uint)-1;
+  }
+
+  /* Return`s the index of an element, or -1 on failure. */
+  __Uint index_of(const T &element) const {
+    for (Uint i = 0; i < _len; ++i) {
+      if (element == _data[i]) {
+        return i;
+      }
+    }
+    return (Uint)-1;
+  }
+
+  /* Constructors. */
+  MSmallVector(void) noexcept : _data((T *)_inline), _len(0), _cap(N) {}
+
+  MSmallVector(initializer_list<T> list) __nothrow_copy_constructible : MSmallVector() {
+    reserve(list.size());
+    for (const auto &it : list) {
+      push_back(it);
+    }
+  }
+
+  /* Copy Constructor. */
+  MSmallVector(const MSmallVector &other) __nothrow_copy_constructible : MSmallVector() {
+    reserve(other._len);
+    for (Uint i = 0; i < other._len; ++i) {
+      new (_data + i) T(other._data[i]);
+    }
+    _len = other._len;
+  }
+
+  /* Move Constructor. */
+  MSmallVector(MSmallVector &&other) __nothrow_move_constructible {
+    _steal(other);
+  }
+
+  /* Destructor. */
+  ~MSmallVector(void) __nothrow_destructible {
+    _destroy_all();
+    if (!_is_inline()) {
+      free(_data);
+    }
+  }
+
+  /* Copy Assignment Operator. */
+  __ref operator=(const MSmallVector &other) __nothrow_copy_constructible {
+    if (this != &other) {
+      _destroy_all();
+      reserve(other._len);
+      for (Uint i = 0; i < other._len; ++i) {
+        new (_data + i) T(other._data[i]);
+      }
+      _len = other._len;
+    }
+    return *this;
+  }
+
+  /* Move Assignment Operator. */
+  __ref operator=(MSmallVector &&other) __nothrow_move_constructible {
+    if (this != &other) {
+      _destroy_all();
+      if (!_is_inline()) {
+        free(_data);
+      }
+      _steal(other);
+    }
+    return *this;
+  }
+
+  __ref operator<<(const T &element) __nothrow_copy_constructible {
+    push_back(element);
+    return *this;
+  }
+
+  __ref operator<<(T &&element) __nothrow_move_constructible {
+    push_back((T &&)element);
+    return *this;
+  }
+
+  /* Operator. */
+  __type_ref operator[](Uint index) {
+    return _data[index];
+  }
+
+  const __type_ref operator[](Uint index) const {
+    return _data[index];
+  }
+};
+
+namespace /* Undef defines. */ {
+  #undef __nothrow_default_constructor
+  #undef __nothrow_destructible
+  #undef __nothrow_copy_constructible
+  #undef __nothrow_move_constructible
+  #undef __nothrow_move_copy_constructible
+  #undef __nothrow_move_destruct_constructible
+
+  #undef __ref
+  #undef __type_ref
+  #undef __type_ptr
+  #undef __bool
+  #undef __Uint
+  #undef __void
+}
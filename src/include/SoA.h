@@ -0,0 +1,247 @@
+#pragma once
+/* clang-format off */
+
+#include "Attributes.h"
+#include "Debug.h"
+#include "def.h"
+
+#include <cstring>
+#include <tuple>
+
+namespace /* Defines. */ {
+  #define __ref  __inline__ MSoA & __attribute((__always_inline__, __nothrow__, __nodebug__))
+  #define __bool __inline__ bool __warn_unused __attribute((__always_inline__, __nothrow__, __nodebug__))
+  #define __Uint __inline__ Uint __warn_unused __attribute((__always_inline__, __nothrow__, __nodebug__))
+  #define __void __inline__ void __attribute((__always_inline__, __nothrow__, __nodebug__))
+}
+
+/* Alignment of every 'MSoA' column, matches the 256 bit '__avx' vectors in 'simd.h'. */
+#define MSOA_COLUMN_ALIGN 32
+
+/* Structure of arrays.  Every field lives in its own contiguous column, so a loop that only
+ * touches one field streams through just that column.  Columns are 'MSOA_COLUMN_ALIGN' aligned
+ * and their capacity is a multiple of 'MSOA_COLUMN_ALIGN' elements, zero filled past 'size()',
+ * so '__avx' kernels may load and store whole vectors up to 'padded_size()' without a scalar tail.
+ * Fields must be trivially copyable, growth is a plain 'memcpy' per column.
+ *
+ *   MSoA<vec2, vec2, Uint> objects;  // position, velocity, state.
+ *   objects.push_back(pos, vel, 0);
+ *   float *x = (float *)objects.column<0>();
+ */
+template <class ...Fields>
+class MSoA {
+  static_assert(sizeof...(Fields) > 0, "MSoA needs atleast one field.");
+  static_assert((std::is_trivially_copyable_v<Fields> && ...), "MSoA fields must be trivially copyable.");
+  static_assert(((alignof(Fields) <= MSOA_COLUMN_ALIGN) && ...), "MSoA fields can not be over aligned.");
+
+ public:
+  template <Uint I>
+  using field_t = std::tuple_element_t<I, std::tuple<Fields...>>;
+
+  /* View of one row, every member refers into its column. */
+  using row_t       = std::tuple<Fields &...>;
+  using const_row_t = std::tuple<const Fields &...>;
+
+ private:
+  static constexpr Uint FIELDS = sizeof...(Fields);
+  static constexpr Ulong SIZES[FIELDS] = { sizeof(Fields)... };
+
+  Uchar *_block;
+  Uchar *_cols[FIELDS];
+  Uint   _len;
+  Uint   _cap;
+
+  static constexpr Uint _round_cap(Uint cap) noexcept {
+    return ((cap + (MSOA_COLUMN_ALIGN - 1)) & ~(Uint)(MSOA_COLUMN_ALIGN - 1));
+  }
+
+  /* All columns share one block, each starts on a 'MSOA_COLUMN_ALIGN' boundary.  Since 'cap' is a
+   * multiple of the alignment every column size is too, so no padding is needed between them. */
+  void __attribute((__noinline__)) _grow(Uint cap) noexcept {
+    cap = _round_cap(cap);
+    Ulong bytes = 0;
+    for (Uint i = 0; i < FIELDS; ++i) {
+      bytes += (SIZES[i] * cap);
+    }
+    Uchar *block = (Uchar *)aligned_alloc(MSOA_COLUMN_ALIGN, bytes);
+    if (!block) {
+      logE("MSoA failed to grow to %u rows.", cap);
+      exit(1);
+    }
+    Uchar *col = block;
+    for (Uint i = 0; i < FIELDS; ++i) {
+      if (_len) {
+        memcpy(col, _cols[i], (SIZES[i] * _len));
+      }
+      memset((col + (SIZES[i] * _len)), 0, (SIZES[i] * (cap - _len)));
+      _cols[i] = col;
+      col += (SIZES[i] * cap);
+    }
+    free(_block);
+    _block = block;
+    _cap   = cap;
+  }
+
+  template <Ulong ...I>
+  __void _store(Uint row, std::index_sequence<I...>, const Fields &...values) noexcept {
+    ((column<I>()[row] = values), ...);
+  }
+
+  template <Ulong ...I>
+  __inline__ row_t __attribute((__always_inline__, __nothrow__, __nodebug__)) _row(Uint row, std::index_sequence<I...>) noexcept {
+    return row_t(column<I>()[row]...);
+  }
+
+  template <Ulong ...I>
+  __inline__ const_row_t __attribute((__always_inline__, __nothrow__, __nodebug__)) _row(Uint row, std::index_sequence<I...>) const noexcept {
+    return const_row_t(column<I>()[row]...);
+  }
+
+ public:
+  /* Constructors. */
+  MSoA(void) noexcept : _block(nullptr), _cols{}, _len(0), _cap(0) {}
+
+  explicit MSoA(Uint cap) noexcept : MSoA() {
+    reserve(cap);
+  }
+
+  MSoA(const MSoA &other) noexcept : MSoA() {
+    *this = other;
+  }
+
+  MSoA(MSoA &&other) noexcept : _block(other._block), _len(other._len), _cap(other._cap) {
+    memcpy(_cols, other._cols, sizeof(_cols));
+    other._block = nullptr;
+    other._len   = 0;
+    other._cap   = 0;
+  }
+
+  /* Destructor. */
+  ~MSoA(void) noexcept {
+    free(_block);
+  }
+
+  __ref operator=(const MSoA &other) noexcept {
+    if (this != &other) {
+      clear();
+      reserve(other._len);
+      for (Uint i = 0; i < FIELDS && other._len; ++i) {
+        memcpy(_cols[i], other._cols[i], (SIZES[i] * other._len));
+      }
+      _len = other._len;
+    }
+    return *this;
+  }
+
+  __ref operator=(MSoA &&other) noexcept {
+    if (this != &other) {
+      free(_block);
+      _block = other._block;
+      _len   = other._len;
+      _cap   = other._cap;
+      memcpy(_cols, other._cols, sizeof(_cols));
+      other._block = nullptr;
+      other._len   = 0;
+      other._cap   = 0;
+    }
+    return *this;
+  }
+
+  /* Append a row, return`s its index, which callers are free to ignore. */
+  __inline__ Uint __attribute((__always_inline__, __nothrow__, __nodebug__)) push_back(const Fields &...values) noexcept {
+    if (_len == _cap) {
+      _grow(_cap ? (_cap * 2) : MSOA_COLUMN_ALIGN);
+    }
+    _store(_len, std::index_sequence_for<Fields...>{}, values...);
+    return _len++;
+  }
+
+  /* Remove row 'row' by moving the last row into its place.  O(1), but rows are not kept in
+   * order, so any stored row index of the last row now refers to 'row'. */
+  __void swap_remove(Uint row) noexcept {
+    if (row >= _len) {
+      return;
+    }
+    --_len;
+    for (Uint i = 0; i < FIELDS; ++i) {
+      if (row != _len) {
+        memcpy((_cols[i] + (SIZES[i] * row)), (_cols[i] + (SIZES[i] * _len)), SIZES[i]);
+      }
+      memset((_cols[i] + (SIZES[i] * _len)), 0, SIZES[i]);
+    }
+  }
+
+  __void pop_back(void) noexcept {
+    if (_len) {
+      swap_remove(_len - 1);
+    }
+  }
+
+  __void clear(void) noexcept {
+    for (Uint i = 0; i < FIELDS && _len; ++i) {
+      memset(_cols[i], 0, (SIZES[i] * _len));
+    }
+    _len = 0;
+  }
+
+  __ref reserve(Uint cap) noexcept {
+    if (cap > _cap) {
+      _grow(cap);
+    }
+    return *this;
+  }
+
+  __Uint size(void) const noexcept {
+    return _len;
+  }
+
+  /* 'size()' rounded up to a multiple of 'MSOA_COLUMN_ALIGN' rows, every column is readable up to it. */
+  __Uint padded_size(void) const noexcept {
+    return _round_cap(_len);
+  }
+
+  __Uint capacity(void) const noexcept {
+    return _cap;
+  }
+
+  __bool empty(void) const noexcept {
+    return (_len == 0);
+  }
+
+  /* Raw pointer to column 'I', aligned to 'MSOA_COLUMN_ALIGN'.  Invalidated by growth. */
+  template <Uint I>
+  __inline__ field_t<I> *__warn_unused __attribute((__always_inline__, __nothrow__, __nodebug__)) column(void) noexcept {
+    return (field_t<I> *)__builtin_assume_aligned(_cols[I], MSOA_COLUMN_ALIGN);
+  }
+
+  template <Uint I>
+  __inline__ const field_t<I> *__warn_unused __attribute((__always_inline__, __nothrow__, __nodebug__)) column(void) const noexcept {
+    return (const field_t<I> *)__builtin_assume_aligned(_cols[I], MSOA_COLUMN_ALIGN);
+  }
+
+  /* Field 'I' of row 'row'. */
+  template <Uint I>
+  __inline__ field_t<I> &__warn_unused __attribute((__always_inline__, __nothrow__, __nodebug__)) get(Uint row) noexcept {
+    return column<I>()[row];
+  }
+
+  template <Uint I>
+  __inline__ const field_t<I> &__warn_unused __attribute((__always_inline__, __nothrow__, __nodebug__)) get(Uint row) const noexcept {
+    return column<I>()[row];
+  }
+
+  __inline__ row_t __warn_unused __attribute((__always_inline__, __nothrow__, __nodebug__)) operator[](Uint row) noexcept {
+    return _row(row, std::index_sequence_for<Fields...>{});
+  }
+
+  __inline__ const_row_t __warn_unused __attribute((__always_inline__, __nothrow__, __nodebug__)) operator[](Uint row) const noexcept {
+    return _row(row, std::index_sequence_for<Fields...>{});
+  }
+};
+
+namespace /* Undef defines. */ {
+  #undef __ref
+  #undef __bool
+  #undef __Uint
+  #undef __void
+}
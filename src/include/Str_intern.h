@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Attributes.h"
+#include "def.h"
+
+#include <string_view>
+
+/* Global string interning.  Every distinct string gets one stable 32 bit id, so code that keeps
+ * comparing or hashing the same names, like profiler scopes, log call sites or watched paths, can
+ * do that on the id instead.  The characters are copied once into an arena that is never freed,
+ * so the view of an id stays valid for the rest of the program and is always nul terminated.
+ *
+ * Interning is safe from any thread.  The table is split into shards by hash, each behind its own
+ * lock, and looking up the text of an id takes no lock at all.
+ *
+ *   static const str_id_t id = str_intern(__PRETTY_FUNCTION__);
+ *   if (id == other) {}
+ *   printf("%s\n", str_intern_cstr(id));
+ */
+typedef Uint str_id_t;
+
+/* Never a valid id, return`d by 'str_intern_find()' for strings that were never interned. */
+#define STR_ID_NONE ((str_id_t)-1)
+
+/* Return`s the id of 'str', interning it first if this is the first time it is seen. */
+str_id_t str_intern(std::string_view str) noexcept;
+/* Like 'str_intern()', but never adds 'str', return`s 'STR_ID_NONE' when it is not interned. */
+str_id_t str_intern_find(std::string_view str) noexcept;
+/* The text of 'id', which must have come from 'str_intern()'. */
+std::string_view str_intern_view(str_id_t id) noexcept;
+/* Number of distinct strings interned so far. */
+Uint str_intern_count(void) noexcept;
+
+__inline__ const char *__warn_unused __attr(__always_inline__, __nodebug__, __nothrow__) str_intern_cstr(str_id_t id) noexcept {
+  return str_intern_view(id).data();
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Attributes.h"
+#include "def.h"
+
+/* String primitives with one implementation per instruction set, the best one the cpu supports is
+ * put into 'str_prim' before 'main()' runs.  Every vector load is aligned to its own width, so a
+ * load never crosses into a page the string does not touch and scanning for a terminator can not
+ * fault, no matter where the string ends.  Those scans are not instrumented by AddressSanitizer,
+ * which would report the bytes past the end.  The table starts out on sse2, which every x86_64 cpu
+ * has, so calls made during static initialization are safe as well. */
+struct str_prim_t {
+  const char  *isa;
+  Ulong       (*strlen)(const char *str) noexcept;
+  Ulong       (*strnlen)(const char *str, Ulong maxlen) noexcept;
+  const void *(*memchr)(const void *ptr, int c, Ulong len) noexcept;
+  const void *(*memrchr)(const void *ptr, int c, Ulong len) noexcept;
+  const char *(*strchr)(const char *str, int c) noexcept;
+  int         (*memcmp)(const void *a, const void *b, Ulong len) noexcept;
+};
+
+extern str_prim_t str_prim;
+
+/* Switch the table to 'isa', one of "sse2", "avx2" or "avx512", or to the best supported one when
+ * 'isa' is nullptr.  Return`s false and leaves the table as is when the cpu lacks 'isa'.  Only
+ * meant for tests and benchmarks, nothing else may be using the table at the same time. */
+bool str_prim_select(const char *isa) noexcept;
+
+namespace /* Defines. */ {
+  #define __str_prim_attr __attr(__always_inline__, __nodebug__, __nothrow__)
+}
+
+__inline__ Ulong __warn_unused __pure __str_prim_attr __no_null(1) mstrlen(const char *str) noexcept {
+  return str_prim.strlen(str);
+}
+
+__inline__ Ulong __warn_unused __pure __str_prim_attr __no_null(1) mstrnlen(const char *str, Ulong maxlen) noexcept {
+  return str_prim.strnlen(str, maxlen);
+}
+
+__inline__ const void *__warn_unused __pure __str_prim_attr mmemchr(const void *ptr, int c, Ulong len) noexcept {
+  return str_prim.memchr(ptr, c, len);
+}
+
+/* Last 'c' in the 'len' bytes at 'ptr'. */
+__inline__ const void *__warn_unused __pure __str_prim_attr mmemrchr(const void *ptr, int c, Ulong len) noexcept {
+  return str_prim.memrchr(ptr, c, len);
+}
+
+/* Like 'strchr()', searching for '\0' return`s the terminator. */
+__inline__ const char *__warn_unused __pure __str_prim_attr __no_null(1) mstrchr(const char *str, int c) noexcept {
+  return str_prim.strchr(str, c);
+}
+
+__inline__ int __warn_unused __pure __str_prim_attr mmemcmp(const void *a, const void *b, Ulong len) noexcept {
+  return str_prim.memcmp(a, b, len);
+}
+
+namespace /* Undefs. */ {
+  #undef __str_prim_attr
+}
@@ -3,36 +3,175 @@
 
 #include <stdarg.h>
 #include <string.h>
+#include <bit>
 #include <string>
+#include <string_view>
 
 #include "def.h"
 #include "Attributes.h"
+#include "Debug.h"
+#include "Str_prim.h"
+#include "Vector.h"
 #include "constexpr.hpp"
 
 using std::pair;
 using std::string;
 using std::vector;
 
+class MStringBuilder;
+
 namespace Mlib::String {
   size_t                       findN(const string &str, const string &search, size_t n);
   string                       replaceAll(const string &str, const string &search, const string &replace);
   string                       replaceN(const string &str, const string &search, const string &replace, size_t n);
+  /* Append 'str' with every match of 'search' replaced by 'replace' to 'out', return`s the number
+   * of matches replaced.  The matches are collected first, so 'out' grows once to the exact size
+   * and every byte is copied once, an empty 'search' matches nothing.  'str' must not point into
+   * 'out'.  The builder overloads only record the slices, the caller writes them when done. */
+  Ulong                        replaceAll(std::string_view str, std::string_view search, std::string_view replace, string &out);
+  Ulong                        replaceAll(std::string_view str, std::string_view search, std::string_view replace, MStringBuilder &out);
+  /* Same as 'replaceAll()', replacing atmost the first 'n' matches. */
+  Ulong                        replaceN(std::string_view str, std::string_view search, std::string_view replace, size_t n, string &out);
+  Ulong                        replaceN(std::string_view str, std::string_view search, std::string_view replace, size_t n, MStringBuilder &out);
   vector<pair<string, string>> parse_variables(const string &input);
 }
 
-size_t __warn_unused __pure __no_debug __no_throw __no_null(1) mstrlen(const char *str) noexcept;
-size_t __warn_unused __pure __no_debug __no_throw __no_null(1) mstrnlen(const char *str, size_t maxlen) noexcept;
 char * __warn_unused __pure __no_debug __no_throw __no_null(1) mstrndup(const char *str, size_t maxlen) noexcept;
+/* Return`s the first occurrence of 'needle' in the 'hay_len' bytes at 'hay', or nullptr.  Neither
+ * needs to be terminated.  Candidates are found 32 bytes at a time by matching the first two and the
+ * last needle byte with avx2, or 16 at a time with sse2 on cpu`s without it, picked on the first call. */
+const char * __warn_unused __pure __no_debug __no_throw mstrmem(const char *hay, size_t hay_len, const char *needle, size_t needle_len) noexcept;
+
+/* Walks every non overlapping occurrence of a needle, each call continues where the last match
+ * ended, so the haystack is scanned once in total.
+ *
+ *   mstr_search_t it(text, len, "foo", 3);
+ *   for (Ulong pos; (pos = it.next()) != (Ulong)-1;) {}
+ */
+struct mstr_search_t {
+  const char *hay;
+  Ulong       hay_len;
+  const char *needle;
+  Ulong       needle_len;
+  Ulong       pos;
+
+  mstr_search_t(const char *hay, Ulong hay_len, const char *needle, Ulong needle_len, Ulong from = 0) noexcept
+      : hay(hay), hay_len(hay_len), needle(needle), needle_len(needle_len), pos(from) {
+  }
+
+  /* Return`s the offset of the next match, or '(Ulong)-1' once there are no more. */
+  __inline__ Ulong __warn_unused __attribute((__always_inline__, __nothrow__, __nodebug__)) next(void) noexcept {
+    if (pos > hay_len) {
+      return (Ulong)-1;
+    }
+    const char *found = mstrmem((hay + pos), (hay_len - pos), needle, needle_len);
+    if (!found) {
+      pos = (hay_len + 1);
+      return (Ulong)-1;
+    }
+    Ulong at = (found - hay);
+    /* An empty needle matches everywhere, step past it so iteration ends. */
+    pos = (at + (needle_len ? needle_len : 1));
+    return at;
+  }
+};
+
+/* Collects slices of text that live elsewhere, keeping only a pointer and length for each, so the
+ * exact size of the result is known before a single byte is copied.  Writing it out then grows the
+ * destination once and does one 'memcpy' per slice.  Every slice must stay valid until the last
+ * write, and 'clear()' keeps the slice buffer, so a reused builder stops allocating.
+ *
+ *   MStringBuilder sb;
+ *   sb.append("Hello, ");
+ *   sb.append(name);
+ *   std::string out = sb.str();
+ */
+class MStringBuilder {
+  struct slice_t {
+    const char *data;
+    Ulong       len;
+  };
+
+  MVector<slice_t> _slices;
+  Ulong            _size = 0;
+
+ public:
+  MStringBuilder &append(const char *str, Ulong len) noexcept {
+    if (!len) {
+      return *this;
+    }
+    /* Text that directly continues the last slice, like the gaps between matches of an empty
+     * replacement, extends it instead of adding another. */
+    if (!_slices.empty() && (_slices.back().data + _slices.back().len) == str) {
+      _slices.back().len += len;
+    }
+    else {
+      _slices.push_back({str, len});
+    }
+    _size += len;
+    return *this;
+  }
+
+  MStringBuilder &append(std::string_view str) noexcept {
+    return append(str.data(), str.size());
+  }
+
+  /* Total bytes, without any terminator. */
+  __inline__ Ulong __warn_unused __attribute((__always_inline__, __nothrow__, __nodebug__)) size(void) const noexcept {
+    return _size;
+  }
+
+  __inline__ bool __warn_unused __attribute((__always_inline__, __nothrow__, __nodebug__)) empty(void) const noexcept {
+    return !_size;
+  }
+
+  void clear(void) noexcept {
+    _slices.clear();
+    _size = 0;
+  }
+
+  /* Copy every slice to 'out', which must hold 'size()' bytes, nothing is terminated.  Return`s
+   * 'size()'. */
+  Ulong write(char *out) const noexcept {
+    for (const slice_t &slice : _slices) {
+      memcpy(out, slice.data, slice.len);
+      out += slice.len;
+    }
+    return _size;
+  }
+
+  /* Append the result to 'out', growing it exactly once. */
+  void append_to(string &out) const {
+    Ulong len = out.size();
+    out.resize(len + _size);
+    write(out.data() + len);
+  }
+
+  string str(void) const {
+    string ret;
+    append_to(ret);
+    return ret;
+  }
+};
+
+/* Characters 'MString' keeps inline before it allocates, the terminator shares the last byte. */
+#define MSTRING_SSO_CAP 23
+
+inline constexpr char mstring_alloc_tag[] = "MString";
+/* Default allocator for 'MString', the same one 'MVector' uses under its own stats tag, so
+ * 'mem_pool_alloc_t' and 'pmr_alloc_t' from 'Mem_resource.h' can back a string with an arena
+ * instead. */
+typedef mlib_malloc_t<mstring_alloc_tag> mstring_malloc_t;
 
 namespace /* Defines */ {
-  #define __constructor(...) __inline__ constexpr MString(__VA_ARGS__) __attribute((__always_inline__, __nothrow__, __nodebug__))
-  #define __destructor __inline__ ~MString(void) __attribute((__always_inline__, __nothrow__, __nodebug__))
-  #define __ref __inline__ constexpr MString & __attribute((__always_inline__, __nothrow__, __nodebug__))
-  #define __copy __inline__ MString __attribute((__always_inline__, __nothrow__, __nodebug__, __const__))
-  #define __bool __inline__ constexpr bool __warn_unused __attribute((__always_inline__, __nothrow__, __nodebug__, __const__))
-  #define __Uint __inline__ constexpr bool __warn_unused __attribute((__always_inline__, __nothrow__, __nodebug__, __const__))
-  #define __char_ref __inline__ constexpr char & __warn_unused __attribute((__always_inline__, __nothrow__, __nodebug__, __const__))
-  #define __char_ptr __inline__ constexpr char * __warn_unused __attribute((__always_inline__, __nothrow__, __nodebug__, __const__))
+  #define __constructor(...) __inline__ MBasicString(__VA_ARGS__) __attribute((__always_inline__, __nothrow__, __nodebug__))
+  #define __destructor __inline__ ~MBasicString(void) __attribute((__always_inline__, __nothrow__, __nodebug__))
+  #define __ref __inline__ MBasicString & __attribute((__always_inline__, __nothrow__, __nodebug__))
+  #define __copy __inline__ MBasicString __attribute((__always_inline__, __nothrow__, __nodebug__))
+  #define __bool __inline__ bool __warn_unused __attribute((__always_inline__, __nothrow__, __nodebug__))
+  #define __Uint __inline__ Uint __warn_unused __attribute((__always_inline__, __nothrow__, __nodebug__))
+  #define __char_ref __inline__ char & __warn_unused __attribute((__always_inline__, __nothrow__, __nodebug__))
+  #define __char_ptr __inline__ char * __warn_unused __attribute((__always_inline__, __nothrow__, __nodebug__))
   #define __constexpr_func(ret) __inline__ constexpr ret __warn_unused __attribute((__always_inline__, __nothrow__, __nodebug__, __const__))
   /* clang-format off */
 }
@@ -52,146 +191,277 @@ namespace /* Helpers. */ {
   }
 }
 
-class MString {
- private:
-  char *_data;
-  Uint _len;
-  Uint _cap;
+/* Strings of upto 'MSTRING_SSO_CAP' characters live inside the object and never touch the
+ * allocator.  Longer ones move to a block from 'Alloc'.  The last inline byte holds the spare
+ * inline capacity, which is zero and so doubles as the terminator when the inline buffer is
+ * full, while a heap string sets its top bit through the high byte of the capacity. */
+template <class Alloc = mstring_malloc_t>
+class MBasicString {
+  static_assert(sizeof(char *) == 8, "MBasicString expects 64 bit pointers.");
+  static_assert(std::endian::native == std::endian::little, "MBasicString keeps its flag in the high byte of the capacity.");
 
- public:
-  __constructor(const char *str = "") : _len(const_strlen(str)), _cap(_len ? (_len * 2) : 30) {
-    _data = (char *)malloc(_cap);
-    for (Uint i = 0; i < _len; ++i) {
-      *(_data + i) = (char &&)*(str + i);
+  static constexpr Ulong HEAP_FLAG = (1ul << 63);
+
+  union {
+    struct {
+      char *ptr;
+      Ulong len;
+      Ulong cap; /* Usable characters, excluding the terminator, ored with 'HEAP_FLAG'. */
+    } _heap;
+    char _sso[MSTRING_SSO_CAP + 1];
+  };
+  [[no_unique_address]] Alloc _alloc;
+
+  __bool _is_heap(void) const {
+    return (_sso[MSTRING_SSO_CAP] & 0x80);
+  }
+
+  __inline__ void __attribute((__always_inline__, __nothrow__, __nodebug__)) _set_len(Uint len) {
+    if (_is_heap()) {
+      _heap.len = len;
+      _heap.ptr[len] = '\0';
+    }
+    else {
+      _sso[MSTRING_SSO_CAP] = (MSTRING_SSO_CAP - len);
+      _sso[len] = '\0';
     }
-    *(_data + _len) = '\0';
   }
 
-  __constructor(const char *str, Uint len) : _len(len), _cap(len * 2) {
-    _data = (char *)malloc(_cap);
-    for (Uint i = 0; i < _len; ++i) {
-      *(_data + i) = (char &&)*(str + i);
+  /* Make room for atleast 'cap' characters, keeping the content. */
+  void __attribute((__noinline__)) _grow(Uint cap) {
+    Uint len  = size();
+    Uint ncap = ((cap < (capacity() * 2)) ? (capacity() * 2) : cap);
+    char *data;
+    if (_is_heap()) {
+      data = (char *)_alloc.reallocate(_heap.ptr, (capacity() + 1), (ncap + 1), 1);
+    }
+    else if ((data = (char *)_alloc.allocate((ncap + 1), 1))) {
+      memcpy(data, _sso, (len + 1));
+    }
+    if (!data) {
+      logE("MString failed to grow to %u bytes.", ncap);
+      exit(1);
     }
-    *(_data + _len) = '\0';
+    _heap.ptr = data;
+    _heap.len = len;
+    _heap.cap = (ncap | HEAP_FLAG);
   }
 
-  /* Copy. */
-  __constructor(const MString &other) : _len(other._len), _cap(other._cap) {
-    _data = (char *)malloc(_cap);
-    for (Uint i = 0; i < _len; ++i) {
-      *(_data + i) = (char &&)*(other._data + i);
+  __inline__ void __attribute((__always_inline__, __nothrow__, __nodebug__)) _release(void) {
+    if (_is_heap()) {
+      _alloc.deallocate(_heap.ptr, (capacity() + 1), 1);
+    }
+  }
+
+  __inline__ void __attribute((__always_inline__, __nothrow__, __nodebug__)) _init(const char *str, Uint len) {
+    _sso[0]               = '\0';
+    _sso[MSTRING_SSO_CAP] = MSTRING_SSO_CAP;
+    if (len > MSTRING_SSO_CAP) {
+      _grow(len);
     }
-    *(_data + _len) = '\0';
+    memcpy(data(), str, len);
+    _set_len(len);
+  }
+
+  /* Steal the buffer of 'other', which must not share it. */
+  __inline__ void __attribute((__always_inline__, __nothrow__, __nodebug__)) _take(MBasicString &other) {
+    memcpy((void *)_sso, (const void *)other._sso, sizeof(_sso));
+    other._sso[0]               = '\0';
+    other._sso[MSTRING_SSO_CAP] = MSTRING_SSO_CAP;
   }
 
-  /* Move. */
-  __constructor(MString &&other) : _data(other._data), _len(other._len), _cap(other._cap) {
-    other._data = nullptr;
-    other._len = 0;
-    other._cap = 0;
+ public:
+  __constructor(const char *str = "", const Alloc &alloc = Alloc()) : _alloc(alloc) {
+    _init(str, const_strlen(str));
+  }
+
+  __constructor(const char *str, Uint len, const Alloc &alloc = Alloc()) : _alloc(alloc) {
+    _init(str, len);
+  }
+
+  /* Copy. */
+  __constructor(const MBasicString &other) : _alloc(other._alloc) {
+    _init(other.data(), other.size());
+  }
+
+  /* Move, only the object is copied. */
+  __constructor(MBasicString &&other) : _alloc(other._alloc) {
+    _take(other);
   }
 
   __destructor {
-    if (_data) {
-      free(_data);
-      _data = nullptr;
+    _release();
+  }
+
+  __ref assign(const char *str, Uint len) {
+    if (len > capacity()) {
+      /* 'str' may point into our own buffer, which '_grow()' can move. */
+      Ulong offset = ((Ulong)str - (Ulong)data());
+      bool  inside = (offset <= size());
+      _grow(len);
+      if (inside) {
+        str = (data() + offset);
+      }
     }
+    memmove(data(), str, len);
+    _set_len(len);
+    return *this;
   }
 
   __ref operator=(const char *str) {
-    _len = const_strlen(str);
-    if (_len >= _cap) {
-      _cap = (_len * 2);
-      _data = (char *)realloc(_data, _cap);
-    }
-    for (Uint i = 0; i < _len; ++i) {
-      *(_data + i) = (char &&)*(str + i);
+    return assign(str, const_strlen(str));
+  }
+
+  __ref operator=(const MBasicString &other) {
+    if (this != &other) {
+      assign(other.data(), other.size());
     }
-    *(_data + _len) = '\0';
     return *this;
   }
 
-  __ref operator=(const MString &other) {
+  __ref operator=(MBasicString &&other) {
     if (this != &other) {
-      _len = other._len;
-      if (_len >= _cap) {
-        _cap = (_len * 2);
-        _data = (char *)realloc(_data, _cap);
-      }
-      for (Uint i = 0; i < _len; ++i) {
-        *(_data + i) = (char &&)*(other._data + i);
-      }
-      *(_data + _len) = '\0';    
+      _release();
+      _alloc = other._alloc;
+      _take(other);
     }
     return *this;
   }
 
-  __ref operator+=(const MString &other) {
-    if (this != &other) {
-      Uint nlen = _len + other._len;
-      if (nlen >= _cap) {
-        _cap = (nlen * 2);
-        _data = (char *)realloc(_data, _cap);
-      }
-      for (Uint i = 0; i < other._len; ++i) {
-        *(_data + (_len + i)) = (char &&)*(other._data + i);
+  /* Append 'len' bytes of 'str', which may point into this string. */
+  __ref append(const char *str, Uint len) {
+    Uint nlen = (size() + len);
+    if (nlen > capacity()) {
+      Ulong offset = ((Ulong)str - (Ulong)data());
+      bool  inside = (offset <= size());
+      _grow(nlen);
+      if (inside) {
+        str = (data() + offset);
       }
-      *(_data + nlen) = '\0';
-      _len = nlen;
     }
+    memmove((data() + size()), str, len);
+    _set_len(nlen);
     return *this;
   }
 
-  __copy operator+(const MString &other) const {
-    Uint nlen = (_len + other._len);
-    MString ret;
-    ret._len = nlen;
-    ret._cap = (nlen * 2);
-    ret._data = (char *)malloc(ret._cap);
-    for (Uint i = 0; i < _len; ++i) {
-      *(ret._data + i) = (char &&)*(_data + i);
-    }
-    for (Uint i = 0; i < other._len; ++i) {
-      *(ret._data + (_len + i)) = *(other._data + i);
-    }
-    *(ret._data + nlen) = '\0';
+  __ref operator+=(const MBasicString &other) {
+    return append(other.data(), other.size());
+  }
+
+  __ref operator+=(const char *str) {
+    return append(str, const_strlen(str));
+  }
+
+  __ref operator+=(char c) {
+    return append(&c, 1);
+  }
+
+  /* A fresh string sized for both parts, allocated once. */
+  __copy operator+(const MBasicString &other) const & {
+    MBasicString ret(_alloc);
+    ret.reserve(size() + other.size());
+    ret.append(data(), size());
+    ret.append(other.data(), other.size());
     return ret;
   }
 
+  /* On a temporary, so chains like 'a + b + c' keep growing the first result. */
+  __copy operator+(const MBasicString &other) && {
+    append(other.data(), other.size());
+    return std::move(*this);
+  }
+
+  __copy operator+(const char *str) const & {
+    Uint         len = const_strlen(str);
+    MBasicString ret(_alloc);
+    ret.reserve(size() + len);
+    ret.append(data(), size());
+    ret.append(str, len);
+    return ret;
+  }
+
+  __copy operator+(const char *str) && {
+    append(str, const_strlen(str));
+    return std::move(*this);
+  }
+
   __bool operator==(const char *str) const {
-    if (const_strcmp(_data, str) == 0) {
-      return true;
-    }
-    return false;
+    return (const_strcmp(data(), str) == 0);
+  }
+
+  __bool operator==(const MBasicString &other) const {
+    return (size() == other.size() && !memcmp(data(), other.data(), size()));
   }
 
   __char_ref operator[](Uint index) {
-    if (index > _len) {
-      return *(_data + _len);
+    if (index > size()) {
+      return data()[size()];
     }
-    return *(_data + index);
+    return data()[index];
   }
 
   const __char_ref operator[](Uint index) const {
-    if (index > _len) {
-      return *(_data + _len);
+    if (index > size()) {
+      return data()[size()];
+    }
+    return data()[index];
+  }
+
+  __ref reserve(Uint cap) {
+    if (cap > capacity()) {
+      _grow(cap);
     }
-    return *(_data + index);
+    return *this;
+  }
+
+  /* Drop the content, keeping any heap buffer for reuse. */
+  __ref clear(void) {
+    _set_len(0);
+    return *this;
+  }
+
+  __char_ptr data(void) {
+    return (_is_heap() ? _heap.ptr : _sso);
+  }
+
+  const __char_ptr data(void) const {
+    return (_is_heap() ? _heap.ptr : _sso);
   }
 
   __char_ptr c_str(void) {
-    return _data;
+    return data();
   }
 
   const __char_ptr c_str(void) const {
-    return _data;
+    return data();
   }
 
   __Uint size(void) const {
-    return _len;
+    return (_is_heap() ? (Uint)_heap.len : (MSTRING_SSO_CAP - _sso[MSTRING_SSO_CAP]));
+  }
+
+  __Uint capacity(void) const {
+    return (_is_heap() ? (Uint)(_heap.cap & ~HEAP_FLAG) : MSTRING_SSO_CAP);
+  }
+
+  __bool empty(void) const {
+    return !size();
+  }
+
+  /* True while the characters are stored inside the object. */
+  __bool is_inline(void) const {
+    return !_is_heap();
+  }
+
+ private:
+  explicit MBasicString(const Alloc &alloc) : _alloc(alloc) {
+    _sso[0]               = '\0';
+    _sso[MSTRING_SSO_CAP] = MSTRING_SSO_CAP;
   }
 };
 
+using MString = MBasicString<>;
+
 namespace /* Undefs */ {
   #undef __constructor
   #undef __destructor
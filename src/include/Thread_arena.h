@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Attributes.h"
+#include "Mem_pool.h"
+#include "def.h"
+
+/* Every slab is a single 2MB huge-page chunk.  The alignment leaves the low bits of a
+ * slab address free, the shared list uses them as an ABA tag. */
+#define THREAD_ARENA_SLAB_SIZE MEM_POOL_HUGEPAGE_SIZE
+
+/* Pop a slab from the shared lock-free list, mapping a new one when it is empty. */
+mem_pool_chunk_t *__warn_unused thread_arena_slab_pop(void) noexcept;
+/* Push the chain 'first' -> ... -> 'last' onto the shared list in one operation. */
+void thread_arena_slab_push(mem_pool_chunk_t *first, mem_pool_chunk_t *last) noexcept;
+
+#define __thread_arena_t_attr __attr(__always_inline__, __nodebug__, __nothrow__)
+/* Per thread bump allocator.  It never takes a lock and never calls malloc, full slabs
+ * are refilled from the shared list and handed back to it on 'reset()'.
+ * Memory is only valid until the owning thread calls 'reset()'. */
+class thread_arena_t {
+  char             *_pool;
+  Ulong             _pool_size;
+  Ulong             _offset;
+  Ulong             _retired_used;
+  mem_pool_chunk_t *_current;
+  mem_pool_chunk_t *_retired;
+  mem_pool_chunk_t *_large;
+
+  void *__warn_unused __attr(__noinline__, __cold__) _refill(Ulong size, Ulong alignment) noexcept;
+
+  constexpr thread_arena_t(void) noexcept
+      : _pool(nullptr)
+      , _pool_size(0)
+      , _offset(0)
+      , _retired_used(0)
+      , _current(nullptr)
+      , _retired(nullptr)
+      , _large(nullptr) {
+  }
+
+ public:
+  ~thread_arena_t(void) noexcept;
+
+  DEL_CM_CONSTRUCTORS(thread_arena_t);
+
+  /* The calling thread`s arena. */
+  static __inline__ thread_arena_t &__thread_arena_t_attr local(void) noexcept {
+    static thread_local thread_arena_t arena;
+    return arena;
+  }
+
+  __inline__ void *__warn_unused __thread_arena_t_attr alloc(Ulong size, Ulong alignment = 16) noexcept {
+    Ulong current_offset = (Ulong)(_pool + _offset);
+    Ulong aligned_offset = (current_offset + alignment - 1) & ~(alignment - 1);
+    Ulong aligned_size   = aligned_offset - current_offset;
+    if (_offset + aligned_size + size > _pool_size) [[unlikely]] {
+      return _refill(size, alignment);
+    }
+    _offset += aligned_size + size;
+    return (void *)aligned_offset;
+  }
+
+  template <typename T, typename... Args>
+  __inline__ T *__warn_unused __thread_arena_t_attr make(Args &&...args) noexcept {
+    void *mem = alloc(sizeof(T), alignof(T));
+    if (!mem) {
+      return nullptr;
+    }
+    return new (mem) T(std::forward<Args>(args)...);
+  }
+
+  /* Hand every full slab back to the shared list and start over in the current one. */
+  void reset(void) noexcept;
+
+  __inline__ Ulong __thread_arena_t_attr used_memory(void) const noexcept {
+    return (_retired_used + _offset);
+  }
+};
+#undef __thread_arena_t_attr
+
+/* Shorthand for the calling thread`s arena. */
+#define THREAD_ARENA thread_arena_t::local()
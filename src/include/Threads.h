@@ -3,6 +3,7 @@
 #include <condition_variable>
 #include <functional>
 #include <future>
+#include <memory_resource>
 #include <mutex>
 #include <queue>
 #include <thread>
@@ -17,11 +18,15 @@ namespace Mlib::Threads {
     return pool.enqueue(FORWARD<Func>(func), FORWARD<Args>(args)...);
   }
 
+  /* Pending tasks, allocated from the resource given to the 'ThreadPool' constructor. */
+  typedef std::queue<std::function<void()>, std::pmr::deque<std::function<void()>>> TaskQueue;
+
   class ThreadPool {
    public:
-    ThreadPool(u64 threads);
+    ThreadPool(u64 threads, std::pmr::memory_resource *mr = std::pmr::get_default_resource());
     ~ThreadPool();
 
+    /* Tasks can take scratch memory from 'THREAD_ARENA' without locking, it is released when the task returns. */
     template <class Callback, class... Args>
     auto enqueue(Callback &&f, Args &&...args) -> FUTURE<typename INVOKE_RESULT<Callback, Args...>::type> {
       using namespace std;
@@ -43,7 +48,7 @@ namespace Mlib::Threads {
 
    private:
     VECTOR<THREAD>               workers;
-    std::queue<std::function<void()>> tasks;
+    TaskQueue                    tasks;
     MUTEX                        queueMutex;
     CONDITION_VARIABLE           condition;
     bool                         stop;
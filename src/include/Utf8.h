@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Attributes.h"
+#include "def.h"
+
+/* Bulk utf-8 processing.  Every function walks the input 32 bytes at a time with avx2 when the cpu
+ * has it, and a block that is all ascii is handled with a couple of vector instructions, only
+ * blocks holding multi byte sequences fall back to decoding one codepoint at a time.  None of them
+ * need 'str' to be terminated.
+ *
+ *   Ulong len = strlen(line);
+ *   if (utf8_validate(line, len)) {
+ *     Ulong cols = utf8_width(line, len);
+ *   }
+ */
+
+/* Return`s true when the 'len' bytes at 'str' are well formed utf-8, rejecting overlong forms,
+ * surrogates, codepoints past U+10FFFF and truncated sequences. */
+bool utf8_validate(const char *str, Ulong len) noexcept;
+/* Number of codepoints in 'str', which must be valid. */
+Ulong utf8_count(const char *str, Ulong len) noexcept;
+/* Decode 'str' into 'out', which must have room for 'len' codepoints, as no byte decodes to more
+ * then one.  Malformed bytes decode to U+FFFD one byte at a time.  Return`s the number written. */
+Ulong utf8_to_utf32(const char *str, Ulong len, char32_t *out) noexcept;
+/* Decode the codepoint at 'str' into 'cp', return`s its length in bytes.  'len' must be atleast
+ * one.  A malformed sequence gives U+FFFD and a length of one. */
+Uint utf8_decode(const char *str, Ulong len, char32_t *cp) noexcept;
+
+/* Terminal columns taken by 'cp', table driven with the same results as 'constexpr_wcwidth()',
+ * zero for combining marks, two for wide east asian forms and -1 for control characters. */
+int mwcwidth(char32_t cp) noexcept;
+/* Columns taken by all of 'str', control characters count as zero. */
+Ulong utf8_width(const char *str, Ulong len) noexcept;
+/* Length in bytes of the longest prefix of 'str' that fits in 'cols' columns, never splitting a
+ * codepoint.  Zero width marks after the last character that fits are included. */
+Ulong utf8_prefix_for_width(const char *str, Ulong len, Ulong cols) noexcept;
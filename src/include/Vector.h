@@ -2,8 +2,11 @@
 /* clang-format off */
 
 #include "Attributes.h"
+#include "Debug.h"
 #include "def.h"
 
+#include <cstring>
+
 namespace /* Defines. */ {
   #define __nothrow_default_constructor          noexcept(is_nothrow_default_constructible_v<T>)
   #define __nothrow_destructible                 noexcept(is_nothrow_destructible_v<T>)
@@ -21,19 +24,151 @@ namespace /* Defines. */ {
   #define __void __inline__ constexpr void __attribute((__always_inline__, __nothrow__, __nodebug__))
 }
 
+/* Types that can be moved to a new address with 'memcpy', leaving nothing to destroy at the
+ * old one.  Specialize this for types that are not trivially copyable but still qualify,
+ * 'MVector' then grows them with 'realloc' instead of moving element by element. */
 template <class T>
+struct mlib_trivially_relocatable : std::bool_constant<std::is_trivially_copyable_v<T>> {};
+
+/* Malloc backed allocator, the default for 'MVector' and 'MString'.  'Tag' names the site its
+ * allocations are counted under when 'MLIB_ALLOC_STATS' is on.  Any allocator must provide these
+ * three functions, 'reallocate' is only ever called for trivially relocatable element types. */
+template <const char *Tag>
+struct mlib_malloc_t {
+  __inline__ void *__warn_unused __attribute((__always_inline__, __nothrow__, __nodebug__)) allocate(Ulong bytes, Ulong) noexcept {
+    ALLOC_STATS_ALLOC(Tag, bytes, 0);
+    return malloc(bytes);
+  }
+
+  __inline__ void *__warn_unused __attribute((__always_inline__, __nothrow__, __nodebug__)) reallocate(void *ptr, Ulong old_bytes, Ulong new_bytes, Ulong) noexcept {
+    ALLOC_STATS_REALLOC(Tag, old_bytes, new_bytes);
+    return realloc(ptr, new_bytes);
+  }
+
+  __inline__ void __attribute((__always_inline__, __nothrow__, __nodebug__)) deallocate(void *ptr, Ulong bytes, Ulong) noexcept {
+    ALLOC_STATS_FREE(Tag, (ptr ? bytes : 0));
+    free(ptr);
+  }
+};
+
+inline constexpr char mvector_alloc_tag[] = "MVector";
+/* The default allocator for 'MVector'. */
+typedef mlib_malloc_t<mvector_alloc_tag> mvector_malloc_t;
+
+/* Growth when full, in percent of the current capacity.  The default doubles. */
+#define MVECTOR_DEFAULT_GROWTH 200
+/* Capacity of the first allocation.  Default constructed vectors do not allocate. */
+#define MVECTOR_INITIAL_CAP    10
+
+template <class T, class Alloc = mvector_malloc_t, Uint GrowthPercent = MVECTOR_DEFAULT_GROWTH>
 class MVector {
+  static_assert(GrowthPercent > 100, "MVector growth must be above 100 percent.");
+
  private:
   T   *_data;
   Uint _len;
   Uint _cap;
+  [[no_unique_address]] Alloc _alloc;
+
+  /* Move the elements to a block of exactly 'cap' elements, 'cap' must be atleast '_len'. */
+  void __attribute((__noinline__)) _relocate(Uint cap) __nothrow_move_destruct_constructible {
+    T *data;
+    if constexpr (mlib_trivially_relocatable<T>::value) {
+      data = (T *)(_data ? _alloc.reallocate(_data, (sizeof(T) * _cap), (sizeof(T) * cap), alignof(T)) : _alloc.allocate((sizeof(T) * cap), alignof(T)));
+      if (!data) {
+        logE("MVector failed to grow to %u elements.", cap);
+        exit(1);
+      }
+    }
+    else {
+      data = (T *)_alloc.allocate((sizeof(T) * cap), alignof(T));
+      if (!data) {
+        logE("MVector failed to grow to %u elements.", cap);
+        exit(1);
+      }
+      for (Uint i = 0; i < _len; ++i) {
+        new (data + i) T((T &&)_data[i]);
+        _data[i].~T();
+      }
+      _alloc.deallocate(_data, (sizeof(T) * _cap), alignof(T));
+    }
+    _data = data;
+    _cap  = cap;
+  }
+
+  __void _grow(void) __nothrow_move_destruct_constructible {
+    Ulong cap = (((Ulong)_cap * GrowthPercent) / 100);
+    _relocate(_cap ? ((cap > _cap) ? cap : (_cap + 1)) : MVECTOR_INITIAL_CAP);
+  }
+
+  __void _destroy(Uint from, Uint to) __nothrow_destructible {
+    if constexpr (!is_trivially_destructible_v<T>) {
+      for (Uint i = from; i < to; ++i) {
+        _data[i].~T();
+      }
+    }
+  }
+
+  __void _release(void) __nothrow_destructible {
+    _destroy(0, _len);
+    if (_data) {
+      _alloc.deallocate(_data, (sizeof(T) * _cap), alignof(T));
+    }
+  }
+
+  /* Move 'n' elements from 'src' to the uninitialized slots at 'dst', leaving 'src' uninitialized.
+   * The ranges may overlap. */
+  __void _relocate_range(T *dst, T *src, Uint n) __nothrow_move_destruct_constructible {
+    if constexpr (mlib_trivially_relocatable<T>::value) {
+      memmove((void *)dst, (const void *)src, (sizeof(T) * n));
+    }
+    else if (dst < src) {
+      for (Uint i = 0; i < n; ++i) {
+        new (dst + i) T((T &&)src[i]);
+        src[i].~T();
+      }
+    }
+    else {
+      for (Uint i = n; i > 0; --i) {
+        new (dst + (i - 1)) T((T &&)src[i - 1]);
+        src[i - 1].~T();
+      }
+    }
+  }
+
+  /* Make room for atleast 'need' elements, growing by 'GrowthPercent' so repeated small
+   * increases stay amortized constant. */
+  __void _grow_to(Ulong need) __nothrow_move_destruct_constructible {
+    if (need > _cap) {
+      Ulong cap = (((Ulong)_cap * GrowthPercent) / 100);
+      _relocate((need > cap) ? need : cap);
+    }
+  }
+
+  /* Open a gap of 'n' uninitialized slots at 'idx', '_len' already accounts for it on return. */
+  __void _open_gap(Uint idx, Uint n) __nothrow_move_destruct_constructible {
+    _grow_to((Ulong)_len + n);
+    _relocate_range((_data + idx + n), (_data + idx), (_len - idx));
+    _len += n;
+  }
+
+  __void _insert_copies(Uint idx, const T *src, Uint n) __nothrow_move_copy_constructible {
+    _open_gap(idx, n);
+    if constexpr (std::is_trivially_copyable_v<T>) {
+      memcpy((void *)(_data + idx), (const void *)src, (sizeof(T) * n));
+    }
+    else {
+      for (Uint i = 0; i < n; ++i) {
+        new (_data + idx + i) T(src[i]);
+      }
+    }
+  }
 
  public:
   template <typename ...Args>
   __void emplace_back(Args &&...args) __nothrow_move_copy_constructible {
     if (_len == _cap) {
-      _cap *= 2;
-      _data = AREALLOC_ARRAY(_data, _cap);
+      _grow();
     }
     new (_data + _len) T{std::forward<Args>(args)...};
     ++_len;
@@ -41,21 +176,18 @@ class MVector {
 
   __void shrink_to_fit(void) {
     if (_len < _cap) {
-      _cap = _len;
-      _data = AREALLOC_ARRAY(_data, _cap);
+      if (!_len) {
+        _release();
+        _data = nullptr;
+        _cap  = 0;
+        return;
+      }
+      _relocate(_len);
     }
   }
 
   __void insert(Uint idx, const T &value) __nothrow_move_copy_constructible {
-    if (_len == _cap) {
-      _cap *= 2;
-      _data = AREALLOC_ARRAY(_data, _cap);
-    }
-    ++_len;
-    for (Uint i = _len; i > idx; --i) {
-      _data[i] = (T &&)_data[i - 1];
-    }
-    new (_data + idx) T(value);
+    insert_range(idx, &value, 1);
   }
 
   __void insert(const T *const &at, const T &value) __nothrow_move_copy_constructible {
@@ -63,15 +195,34 @@ class MVector {
     if (idx == (Uint)-1) {
       return;
     }
-    if (_len == _cap) {
-      _cap *= 2;
-      _data = AREALLOC_ARRAY(_data, _cap);
+    insert_range(idx, &value, 1);
+  }
+
+  /* Copy 'n' elements from 'src' into the vector before 'idx'.  The trailing elements are
+   * moved once, by 'memmove' for trivially relocatable types. */
+  __void insert_range(Uint idx, const T *src, Uint n) __nothrow_move_copy_constructible {
+    if (idx > _len || !n) {
+      return;
     }
-    ++_len;
-    for (Uint i = _len; i > idx; --i) {
-      _data[i] = (T &&)_data[i - 1];
+    /* The source is inside this vector, so take a copy before the storage moves. */
+    if (element_in_range(src)) {
+      MVector copy(src, n, _alloc);
+      _insert_copies(idx, copy.data(), n);
+    }
+    else {
+      _insert_copies(idx, src, n);
     }
-    new (_data + idx) T(value);
+  }
+
+  /* Copy 'n' elements from 'src' to the end of the vector. */
+  __ref append(const T *src, Uint n) __nothrow_move_copy_constructible {
+    insert_range(_len, src, n);
+    return *this;
+  }
+
+  __ref append(const MVector &other) __nothrow_move_copy_constructible {
+    insert_range(_len, other._data, other._len);
+    return *this;
   }
 
   template <typename Callback, typename ...Args>
@@ -104,8 +255,15 @@ class MVector {
 
   __ref push_back(const T &element) __nothrow_copy_constructible {
     if (_len == _cap) {
-      _cap *= 2;
-      _data = AREALLOC_ARRAY(_data, _cap);
+      /* 'element' may live in the storage we are about to release. */
+      if (element_in_range(&element)) {
+        T copy(element);
+        _grow();
+        new (_data + _len) T((T &&)copy);
+        ++_len;
+        return *this;
+      }
+      _grow();
     }
     new (_data + _len) T(element);
     ++_len;
@@ -114,42 +272,85 @@ class MVector {
 
   __ref push_back(T &&element) __nothrow_move_constructible {
     if (_len == _cap) {
-      _cap *= 2;
-      _data = AREALLOC_ARRAY(_data, _cap);
+      if (element_in_range(&element)) {
+        T moved((T &&)element);
+        _grow();
+        new (_data + _len) T((T &&)moved);
+        ++_len;
+        return *this;
+      }
+      _grow();
     }
-    *(_data + _len) = (T &&)element;
+    new (_data + _len) T((T &&)element);
     ++_len;
     return *this;
   }
 
+  /* Drop the first 'newstart' elements, moving the rest to the front. */
   __ref reorder_from(Uint newstart) __nothrow_move_destruct_constructible {
     if (newstart < _len) {
-      for (Uint i = newstart; i < _len; ++i) {
-        if constexpr (!is_trivially_destructible_v<T>) {
-          /* Call destructor for object. */
-          _data[i - newstart].~T();
-        }
-        /* Then move new object into the correct place. */
-        _data[i - newstart] = (T &&)_data[i];
-      }
-      _len -= newstart;
+      erase_range(0, newstart);
     }
     return *this;
   }
 
   __ref erase_at(Uint index) __nothrow_move_destruct_constructible {
+    return erase_range(index, (index + 1));
+  }
+
+  /* Erase the elements in '[first, last)', moving the tail down once. */
+  __ref erase_range(Uint first, Uint last) __nothrow_move_destruct_constructible {
+    if (last > _len) {
+      last = _len;
+    }
+    if (first < last) {
+      _destroy(first, last);
+      _relocate_range((_data + first), (_data + last), (_len - last));
+      _len -= (last - first);
+    }
+    return *this;
+  }
+
+  /* Erase the element at 'index' by moving the last element into its place.  O(1), but the
+   * order of the elements is not kept. */
+  __ref swap_remove(Uint index) __nothrow_move_destruct_constructible {
     if (index < _len) {
-      if constexpr (!is_trivially_destructible_v<T>) {
-        _data[index].~T();
+      --_len;
+      if (index != _len) {
+        _data[index] = (T &&)_data[_len];
       }
-      for (Uint i = index; i < (_len - 1); ++i) {
-        _data[i] = (T &&)_data[i + 1];
+      if constexpr (!is_trivially_destructible_v<T>) {
+        _data[_len].~T();
       }
-      _len -= 1;
     }
     return *this;
   }
 
+  /* Move every element 'pred' rejects to the front, keeping their order, in a single pass.
+   * Return`s the new logical size, elements past it are left moved from.  See 'erase_if()'. */
+  template <typename Pred>
+  __inline__ constexpr Uint __warn_unused __attribute((__always_inline__, __nodebug__)) remove_if(Pred &&pred) {
+    Uint keep = 0;
+    for (Uint i = 0; i < _len; ++i) {
+      if (!pred(_data[i])) {
+        if (keep != i) {
+          _data[keep] = (T &&)_data[i];
+        }
+        ++keep;
+      }
+    }
+    return keep;
+  }
+
+  /* Erase every element 'pred' accepts, in a single pass.  Return`s the number erased. */
+  template <typename Pred>
+  __inline__ constexpr Uint __attribute((__always_inline__, __nodebug__)) erase_if(Pred &&pred) {
+    Uint len  = _len;
+    Uint keep = remove_if((Pred &&)pred);
+    erase_range(keep, len);
+    return (len - keep);
+  }
+
   __ref erase(const T *const &element) __nothrow_move_destruct_constructible {
     Uint idx = index_of(element);
     if (idx == (Uint)-1) {
@@ -168,19 +369,11 @@ class MVector {
     return *this;
   }
 
-  /* Note that this does not free any elements in the array
-   * it only free`s the current array and set`s '_len' to 0
-   * then mallocs the '_data' ptr again. */
+  /* Destroy all elements.  The storage is kept, so refilling the vector does not allocate.
+   * Use 'shrink_to_fit()' afterwards to release it. */
   __ref clear(void) __nothrow_destructible {
-    if constexpr (!is_trivially_destructible_v<T>) {
-      for (Uint i = 0; i < _len; i++) {
-        _data[i].~T();
-      }
-    }
-    free(_data);
-    _len  = 0;
-    _cap  = 10;
-    _data = (T *)calloc(_cap, sizeof(T));
+    _destroy(0, _len);
+    _len = 0;
     return *this;
   }
 
@@ -192,43 +385,45 @@ class MVector {
     return (_len == 0);
   }
 
+  __Uint capacity(void) const {
+    return _cap;
+  }
+
   __ref resize(Uint newlen) __nothrow_default_constructor {
     if (newlen < _len) {
+      _destroy(newlen, _len);
       _len = newlen;
     }
     else if (newlen > _len) {
-      if (newlen > _cap) {
-        _cap = newlen;
-        _data = (T *)realloc(_data, (_cap * sizeof(T)));
-      }
+      _grow_to(newlen);
       for (Uint i = _len; i < newlen; ++i) {
-        if constexpr (is_trivially_constructible_v<T>) {
-          *(_data + i) = T{};
-        }
-        else {
-          new (_data + i) T();
-        }
+        new (_data + i) T{};
       }
       _len = newlen;
     }
     return *this;
   }
 
-  __ref reserve(Uint size) __nothrow_default_constructor {
+  /* Make room for atleast 'size' elements without constructing any of them. */
+  __ref reserve(Uint size) __nothrow_move_destruct_constructible {
     if (size > _cap) {
-      Uint save_size = _len;
-      resize(size);
-      resize(save_size);
+      _relocate(size);
     }
     return *this;
   }
 
+  /* Return`s the allocator this vector draws from. */
+  __inline__ constexpr Alloc &__attribute((__always_inline__, __nothrow__, __nodebug__)) allocator(void) {
+    return _alloc;
+  }
+
+  /* The last element, the vector must not be empty. */
   __type_ref back(void) {
-    return (_len > 0) ? *(_data + (_len - 1)) : *_data;
+    return _data[_len - 1];
   }
 
   const __type_ref back(void) const {
-    return (_len > 0) ? *(_data + (_len - 1)) : *_data;
+    return _data[_len - 1];
   }
 
   __type_ptr data(void) {
@@ -271,6 +466,11 @@ class MVector {
     return (_len > 0) ? (_data - 1) : _data;
   }
 
+  /* Return`s true when 'element' points into this vector`s storage. */
+  __inline__ constexpr bool __warn_unused __attribute((__always_inline__, __nothrow__, __nodebug__)) element_in_range(const T *element) const {
+    return (_data && element >= _data && element < (_data + _cap));
+  }
+
   /* Return`s the index of an element, or -1 on failure. */
   __Uint index_of(const T *const &element) const {
     return (element >= begin() && element < end()) ? (element - begin()) : (Uint)-1;
@@ -287,62 +487,51 @@ class MVector {
   }
 
   /* Constructors. */
-  MVector(void) noexcept : _len(0), _cap(10) {
-    _data = (T *)calloc(_cap, sizeof(T));
-  }
+  MVector(void) noexcept : _data(nullptr), _len(0), _cap(0), _alloc() {}
 
-  MVector(Uint n) __nothrow_default_constructor : _len(n), _cap(n) {
-    _data = (T *)calloc(_cap, sizeof(T));
-    for (Uint i = 0; i < n; ++i) {
-      if constexpr (!is_trivially_constructible_v<T>) {
-        new (_data + i) T();
-      }
-      else {
-        *(_data + i) = T{};
-      }
-    }
+  explicit MVector(const Alloc &alloc) noexcept : _data(nullptr), _len(0), _cap(0), _alloc(alloc) {}
+
+  MVector(Uint n, const Alloc &alloc = Alloc()) __nothrow_default_constructor : _data(nullptr), _len(0), _cap(0), _alloc(alloc) {
+    resize(n);
   }
 
-  MVector(Uint n, const T &value) __nothrow_copy_constructible : _len(n), _cap(n) {
-    _data = (T *)calloc(_cap, sizeof(T));
+  MVector(Uint n, const T &value, const Alloc &alloc = Alloc()) __nothrow_copy_constructible : _data(nullptr), _len(0), _cap(0), _alloc(alloc) {
+    reserve(n);
     for (Uint i = 0; i < n; ++i) {
-      *(_data + i) = value;
+      new (_data + i) T(value);
     }
+    _len = n;
   }
 
-  MVector(initializer_list<T> list) __nothrow_move_constructible : _len(0), _cap(list.size() * 2) {
-    _data = (T *)calloc(_cap, sizeof(T));
+  MVector(initializer_list<T> list, const Alloc &alloc = Alloc()) __nothrow_copy_constructible : _data(nullptr), _len(0), _cap(0), _alloc(alloc) {
+    reserve(list.size());
     for (const auto &it : list) {
-      push_back(it);
+      new (_data + _len++) T(it);
     }
   }
 
-  MVector(const T *array, Uint size) __nothrow_default_constructor : _len(0), _cap(size + 1) {
-    _data = (T *)calloc(_cap, sizeof(T));
+  MVector(const T *array, Uint size, const Alloc &alloc = Alloc()) __nothrow_copy_constructible : _data(nullptr), _len(0), _cap(0), _alloc(alloc) {
+    reserve(size);
     for (Uint i = 0; i < size; ++i) {
-      push_back(array[i]);
+      new (_data + _len++) T(array[i]);
     }
   }
 
   template<Uint N>
-  MVector(const T(&array)[N]) __nothrow_default_constructor : _len(0), _cap(N + 1) {
-    _data = (T *)calloc(_cap, sizeof(T));
-    for (Uint i = 0; i < N; ++i) {
-      push_back(array[i]);
-    }
-  }
+  MVector(const T(&array)[N]) __nothrow_copy_constructible : MVector(array, N) {}
 
-  /* Copy Constructor. */
-  MVector(const MVector &other) __nothrow_copy_constructible : _len(other._len), _cap(other._cap) {
-    _data = (T *)calloc(_cap, sizeof(T));
-    for (Uint i = 0; i < _len; ++i) {
+  /* Copy Constructor.  The copy uses the same allocator. */
+  MVector(const MVector &other) __nothrow_copy_constructible : _data(nullptr), _len(0), _cap(0), _alloc(other._alloc) {
+    reserve(other._len);
+    for (Uint i = 0; i < other._len; ++i) {
       /* Use copy constructor of T */
       new (_data + i) T(*(other._data + i));
     }
+    _len = other._len;
   }
 
   /* Move Constructor. */
-  MVector(MVector &&other) __nothrow_move_constructible : _data(other._data), _len(other._len), _cap(other._cap) {
+  MVector(MVector &&other) noexcept : _data(other._data), _len(other._len), _cap(other._cap), _alloc((Alloc &&)other._alloc) {
     other._data = nullptr;
     other._len  = 0;
     other._cap  = 0;
@@ -350,49 +539,30 @@ class MVector {
   
   /* Destructor. */
   ~MVector(void) __nothrow_destructible {
-    if constexpr (!is_trivially_destructible_v<T>) {
-      for (Uint i = 0; i < _len; ++i) {
-        _data[i].~T();
-      }
-    }
-    free(_data);
+    _release();
   }
 
-  /* Copy Assignment Operator. */
+  /* Copy Assignment Operator.  Keeps this vector`s allocator. */
   __ref operator=(const MVector &other) __nothrow_copy_constructible {
     if (this != &other) {
-      /* Clean up the current object */
-      if constexpr (!is_trivially_destructible_v<T>) {
-        for (Uint i = 0; i < _len; ++i) {
-          _data[i].~T();
-        }
-      }
-      free(_data);
-      /* Allocate new memory and copy elements from 'other' */
-      _len  = other._len;
-      _cap  = other._cap;
-      _data = (T *)calloc(_cap, sizeof(T));
-      for (Uint i = 0; i < _len; ++i) {
+      clear();
+      reserve(other._len);
+      for (Uint i = 0; i < other._len; ++i) {
         new (_data + i) T(*(other._data + i));
       }
+      _len = other._len;
     }
     return *this;
   }
 
   /* Move Assignment Operator. */
-  __ref operator=(MVector &&other) __nothrow_move_constructible {
+  __ref operator=(MVector &&other) noexcept {
     if (this != &other) {
-      /* Clean up the current vector */
-      if constexpr (!is_trivially_destructible_v<T>) {
-        for (Uint i = 0; i < _len; ++i) {
-          _data[i].~T();
-        }
-      }
-      free(_data);
-      /* Move _data from other */
-      _data = other._data;
-      _len  = other._len;
-      _cap  = other._cap;
+      _release();
+      _data  = other._data;
+      _len   = other._len;
+      _cap   = other._cap;
+      _alloc = (Alloc &&)other._alloc;
       /* Reset the other vector */
       other._data = nullptr;
       other._len  = 0;
@@ -407,7 +577,7 @@ class MVector {
   }
 
   __ref operator<<(T &&element) __nothrow_move_constructible {
-    push_back(element);
+    push_back((T &&)element);
     return *this;
   }
   
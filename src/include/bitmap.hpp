@@ -1,3 +1,6 @@
+#pragma once
+
+#include "Bitset.h"
 #include "Debug.h"
 #include "def.h"
 #include <csetjmp>
@@ -7,30 +10,274 @@
 
 #include <pngconf.h>
 #include <vector>
+#ifdef __AVX2__
+#    include <immintrin.h>
+#endif
+
+/* How 'Bitmap::blit' combines the source bits with the ones already there. */
+typedef enum
+{
+    BITMAP_COPY,
+    BITMAP_OR,
+    BITMAP_AND,
+    BITMAP_XOR,
+    BITMAP_ANDNOT
+} bitmap_op_t;
 
+/* One bit per pixel, every row padded to a whole number of 256 bit blocks and all rows in a
+ * single 'MBitset'.  Spans and blits work a 64 bit word at a time, combining whole bitmaps runs
+ * through the avx2 operators of 'MBitset', and export expands 32 pixels per shuffle.  Pixel
+ * 'x' of a row is bit 'x % 64' of word 'x / 64', padding bits are always clear. */
 class Bitmap
 {
 private:
     /** @c Variabels */
-    int width, height;
-    std::vector<std::vector<bool>>(bitmap);
+    int     width, height;
+    Ulong   stride; /* Words per row. */
+    MBitset bits;
+
+    /** @c Helpers   */
+    Ulong *
+    row_words(int y)
+    {
+        return (bits.data() + (y * stride));
+    }
+
+    const Ulong *
+    row_words(int y) const
+    {
+        return (bits.data() + (y * stride));
+    }
+
+    /* The 64 bits of 'row' starting at 'bit', bits past the row read as clear. */
+    static Ulong
+    read_bits(const Ulong *row, Ulong row_len, Ulong bit)
+    {
+        Ulong w     = (bit / 64);
+        Uint  shift = (bit % 64);
+        Ulong value = (row[w] >> shift);
+        if (shift && (w + 1) < row_len)
+        {
+            value |= (row[w + 1] << (64 - shift));
+        }
+        return value;
+    }
+
+    static void
+    apply(Ulong &word, Ulong value, Ulong mask, bitmap_op_t op)
+    {
+        value &= mask;
+        switch (op)
+        {
+            case BITMAP_COPY :
+                word = ((word & ~mask) | value);
+                break;
+            case BITMAP_OR :
+                word |= value;
+                break;
+            case BITMAP_AND :
+                word &= (value | ~mask);
+                break;
+            case BITMAP_XOR :
+                word ^= value;
+                break;
+            case BITMAP_ANDNOT :
+                word &= ~value;
+                break;
+        }
+    }
+
+    /* Combine the low 'n' bits of 'value' into 'row' starting at 'bit'. */
+    static void
+    write_bits(Ulong *row, Ulong bit, Ulong value, Uint n, bitmap_op_t op)
+    {
+        Ulong mask  = ((n == 64) ? ~0ul : ((1ul << n) - 1));
+        Ulong w     = (bit / 64);
+        Uint  shift = (bit % 64);
+        apply(row[w], (value << shift), (mask << shift), op);
+        if ((shift + n) > 64)
+        {
+            apply(row[w + 1], (value >> (64 - shift)), (mask >> (64 - shift)), op);
+        }
+    }
+
+    bool
+    same_size(const Bitmap &other) const
+    {
+        if (width != other.width || height != other.height)
+        {
+            logE("Bitmap sizes differ, %dx%d and %dx%d", width, height, other.width, other.height);
+            return false;
+        }
+        return true;
+    }
 
 public:
     /** @c Methods   */
-    void modify(int row, int startCol, int endCol, bool value)
+    int
+    get_width(void) const
+    {
+        return width;
+    }
+
+    int
+    get_height(void) const
+    {
+        return height;
+    }
+
+    bool
+    get(int x, int y) const
+    {
+        return bits.is_set((y * stride * 64) + x);
+    }
+
+    void
+    set(int x, int y, bool value)
+    {
+        value ? bits.set((y * stride * 64) + x) : bits.unset((y * stride * 64) + x);
+    }
+
+    /* Set or clear the columns '[startCol, endCol)' of 'row'. */
+    void
+    modify(int row, int startCol, int endCol, bool value)
     {
         if (row < 0 || row >= height || startCol < 0 || endCol > width)
         {
             logE("Invalid row or column indices");
+            return;
         }
+        Ulong base = (row * stride * 64);
+        value ? bits.set_range((base + startCol), (base + endCol)) : bits.unset_range((base + startCol), (base + endCol));
+    }
 
-        for (int i = startCol; i < endCol; ++i)
+    /* Set or clear a rectangle, clipped to the bitmap. */
+    void
+    fill_rect(int x, int y, int w, int h, bool value)
+    {
+        int x0 = ((x < 0) ? 0 : x), x1 = (((x + w) > width) ? width : (x + w));
+        int y0 = ((y < 0) ? 0 : y), y1 = (((y + h) > height) ? height : (y + h));
+        for (int row = y0; row < y1 && x0 < x1; ++row)
         {
-            bitmap[row][i] = value;
+            modify(row, x0, x1, value);
         }
     }
 
-    void exportToPng(const char* file_name) const
+    void
+    clear(void)
+    {
+        bits.clear();
+    }
+
+    /* Number of set pixels. */
+    Ulong
+    count(void) const
+    {
+        return bits.count();
+    }
+
+    /* Combine 'src' into this bitmap with its top left corner at 'dx', 'dy', clipped to both. */
+    void
+    blit(const Bitmap &src, int dx, int dy, bitmap_op_t op = BITMAP_COPY)
+    {
+        int x0 = ((dx < 0) ? 0 : dx), x1 = (((dx + src.width) > width) ? width : (dx + src.width));
+        int y0 = ((dy < 0) ? 0 : dy), y1 = (((dy + src.height) > height) ? height : (dy + src.height));
+        for (int y = y0; y < y1 && x0 < x1; ++y)
+        {
+            const Ulong *from = src.row_words(y - dy);
+            Ulong       *to   = row_words(y);
+            for (int x = x0; x < x1; x += 64)
+            {
+                Uint n = (((x1 - x) < 64) ? (x1 - x) : 64);
+                write_bits(to, x, read_bits(from, src.stride, (x - dx)), n, op);
+            }
+        }
+    }
+
+    /* Whole bitmap combines, both must have the same size. */
+    Bitmap &
+    operator|=(const Bitmap &other)
+    {
+        if (same_size(other))
+        {
+            bits |= other.bits;
+        }
+        return *this;
+    }
+
+    Bitmap &
+    operator&=(const Bitmap &other)
+    {
+        if (same_size(other))
+        {
+            bits &= other.bits;
+        }
+        return *this;
+    }
+
+    Bitmap &
+    operator^=(const Bitmap &other)
+    {
+        if (same_size(other))
+        {
+            bits ^= other.bits;
+        }
+        return *this;
+    }
+
+    Bitmap &
+    andnot(const Bitmap &other)
+    {
+        if (same_size(other))
+        {
+            bits.andnot(other.bits);
+        }
+        return *this;
+    }
+
+    /* Expand row 'y' to one byte per pixel, 0xFF when set and 0x00 when clear.  'out' must hold
+     * 'width' rounded up to a multiple of 64 bytes. */
+    void
+    expand_row(int y, Uchar *out) const
+    {
+        const Ulong *row   = row_words(y);
+        Ulong        words = ((width + 63) / 64);
+#ifdef __AVX2__
+        /* Broadcast 32 bits, route byte 'i / 8' of them to output byte 'i', keep bit 'i % 8'. */
+        const __m256i route = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+        const __m256i bit   = _mm256_set1_epi64x(0x8040201008040201);
+        for (Ulong i = 0; i < (words * 2); ++i)
+        {
+            __m256i v = _mm256_shuffle_epi8(_mm256_set1_epi32(((const Uint *)row)[i]), route);
+            _mm256_storeu_si256((__m256i *)(out + (i * 32)), _mm256_cmpeq_epi8(_mm256_and_si256(v, bit), bit));
+        }
+#else
+        /* Eight pixels per lookup. */
+        static constexpr auto table = []
+        {
+            struct
+            {
+                Ulong v[256];
+            } t {};
+            for (Uint b = 0; b < 256; ++b)
+            {
+                for (Uint i = 0; i < 8; ++i)
+                {
+                    t.v[b] |= (((b >> i) & 1) ? (0xFFul << (i * 8)) : 0);
+                }
+            }
+            return t;
+        }();
+        const Uchar *bytes = (const Uchar *)row;
+        for (Ulong i = 0; i < (words * 8); ++i)
+        {
+            memcpy((out + (i * 8)), &table.v[bytes[i]], 8);
+        }
+#endif
+    }
+
+    void
+    exportToPng(const char* file_name) const
     {
         FILE* fp = fopen(file_name, "wb");
         if (!fp)
@@ -56,6 +303,8 @@ public:
             return;
         }
 
+        /* Allocated before 'setjmp', so the error path can free it. */
+        std::vector<png_byte> row(stride * 64);
         if (setjmp(png_jmpbuf(png_ptr)))
         {
             fclose(fp);
@@ -69,24 +318,20 @@ public:
                      PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE);
         png_write_info(png_ptr, info_ptr);
 
-        png_bytep row = new png_byte[width];
         for (int y = 0; y < height; y++)
         {
-            for (int x = 0; x < width; x++)
-            {
-                row[x] = bitmap[y][x] ? 0xFF : 0x00;
-            }
-
-            png_write_row(png_ptr, row);
+            expand_row(y, row.data());
+            png_write_row(png_ptr, row.data());
         }
 
-        delete[] row;
         png_write_end(png_ptr, nullptr);
         fclose(fp);
         png_destroy_write_struct(&png_ptr, &info_ptr);
     }
 
-    Bitmap(int width, int height) : width(width), height(height), bitmap(height, std::vector<bool>(width, false))
+    Bitmap(int width, int height)
+        : width(width), height(height), stride((((width + 63) / 64) + (MBITSET_BLOCK_WORDS - 1)) & ~(Ulong)(MBITSET_BLOCK_WORDS - 1)),
+          bits(height * stride * 64)
     {}
 };
 
@@ -485,7 +485,11 @@ sse_simd_width(void) noexcept {
 #define AUTO_OBJ_MALLOC(obj)      obj = AMALLOC(obj)
 #define ACALLOC_ARRAY(obj, size)  (decltype(obj))calloc(size, sizeof(*obj)) 
 #define AMALLOC_ARRAY(obj, size)  (decltype(obj))malloc(sizeof(*obj) * size)
-#define AREALLOC_ARRAY(obj, size) (decltype(obj))realloc(obj, sizeof(*obj) * size)
+#ifdef MLIB_ALLOC_STATS
+#  define AREALLOC_ARRAY(obj, size) (ALLOC_STATS_RESIZE(__PRETTY_FUNCTION__, (sizeof(*obj) * size)), (decltype(obj))realloc(obj, sizeof(*obj) * size))
+#else
+#  define AREALLOC_ARRAY(obj, size) (decltype(obj))realloc(obj, sizeof(*obj) * size)
+#endif
 
 #define LOG_AMALLOC(obj)      \
   do {                        \
@@ -555,3 +559,4 @@ sse_simd_width(void) noexcept {
 
 #include "Mint.h"
 #include "Mbool.h"
+#include "Alloc_stats.h"
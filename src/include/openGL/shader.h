@@ -2,6 +2,7 @@
 /* clang-format off */
 #include "../Mint.h"
 #include "../Mbool.h"
+#include "../HashMap.h"
 #include "../Vector.h"
 #include "../Pair.h"
 #include "../Error.h"
@@ -243,7 +244,9 @@ inline namespace GlSsbo {
     }
 
     void resize(Uint new_size) {
-      _data = MVector<T>(new_size);
+      /* Reuse the existing storage, the contents still start out value initialized. */
+      _data.clear();
+      _data.resize(new_size);
       glBindBuffer(GL_SHADER_STORAGE_BUFFER, _buffer);
       glBufferData(GL_SHADER_STORAGE_BUFFER, (_data.size() * sizeof(T)), _data.data(), GL_STATIC_DRAW);
       glBindBufferBase(GL_SHADER_STORAGE_BUFFER, Binding, _buffer);
@@ -295,7 +298,7 @@ template<typename T>
 class gridmapstruct {
  private:
   int cell_size;
-  std::unordered_map<ivec2, MVector<T>, cordinathashstruct> grid;
+  MHashMap<ivec2, MVector<T>, cordinathashstruct> grid;
 
   ivec2 to_grid_pos(const ivec2 &pos) const {
     return ivec2(pos / cell_size);
@@ -321,11 +324,7 @@ class gridmapstruct {
   void remove(const ivec2 &pos, T e) {
     ivec2 at_pos = to_grid_pos(pos);
     auto &vector = grid.at(at_pos);
-    for (Uint i = 0; i < vector.size(); ++i) {
-      if (grid.at(at_pos)[i] == e) {
-        vector.erase(&vector[i--]);
-      }
-    }
+    vector.erase_if([e](const T &it) { return it == e; });
     if (vector.empty()) {
       grid.erase(at_pos);
     }
@@ -339,11 +338,7 @@ class gridmapstruct {
       for (int y = start.y; y <= end.y; ++y) {
         ivec2 at_pos(x, y);
         auto &vector = grid.at(at_pos);
-        for (Uint i = 0; i < vector.size(); ++i) {
-          if (vector[i] == e) {
-            vector.erase(&vector[i--]);
-          }
-        }
+        vector.erase_if([e](const T &it) { return it == e; });
         if (vector.empty()) {
           grid.erase(at_pos);
         }
@@ -427,16 +427,20 @@ namespace /* __sse undef. */ {
   #undef __operator_ret
 }
 
+/* Loads are aligned to 16 bytes, so none of them can cross into a page after the terminator.  The
+ * bytes before 'str' in the first block are masked off. */
 inline Ulong SSE2_strlen(const char *str) {
   const __m128i zero = _mm_setzero_si128();
-  const char *ptr = str;
+  const char *ptr = (const char *)((Ulong)str & ~15ul);
+  int mask = (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128((const __m128i *)ptr), zero)) >> (str - ptr));
+  if (mask) {
+    return __builtin_ctz(mask);
+  }
   while (true) {
-    __m128i chunk = _mm_loadu_si128((const __m128i *)ptr);
-    __m128i result = _mm_cmpeq_epi8(chunk, zero);
-    int mask = _mm_movemask_epi8(result);
+    ptr += 16;
+    mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128((const __m128i *)ptr), zero));
     if (mask) {
       return ((ptr - str) + __builtin_ctz(mask));
     }
-    ptr += 16;
   }
 }
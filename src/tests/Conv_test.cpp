@@ -0,0 +1,74 @@
+/** @file Conv_test.cpp
+ *
+ * Parsing terminated strings with 'CONV_TERMINATED', meant to be run under AddressSanitizer.  Every
+ * string sits at the very end of its own heap allocation, so the eight byte loads that may pass the
+ * terminator are seen.  Return`s non zero on the first failure.
+ *
+ *   g++ -std=c++23 -g -fsanitize=address,undefined -include cstdarg -Iinclude tests/Conv_test.cpp \
+ *     cpp/Conv.cpp -o conv_test && ./conv_test
+ */
+#include "../include/Conv.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed.\n", __FILE__, __LINE__, #cond); \
+      return 1;                                                       \
+    }                                                                 \
+  } while (0)
+
+/* A copy of 'text' that ends its allocation, with 'offset' bytes in front of it. */
+static char *test_copy(const char *text, Ulong offset, char **block) {
+  Ulong len = strlen(text);
+  *block    = (char *)malloc(offset + len + 1);
+  memcpy((*block + offset), text, (len + 1));
+  return (*block + offset);
+}
+
+/* "12" in a three byte allocation, the case that used to read past it. */
+static int test_short(void) {
+  char *str = (char *)malloc(3);
+  memcpy(str, "12", 3);
+  Ulong value;
+  Ulong used;
+  CHECK(conv_parse_u64(str, CONV_TERMINATED, &value, &used));
+  CHECK(value == 12 && used == 2);
+  free(str);
+  return 0;
+}
+
+/* Every digit count upto 19 at every offset within a word, against 'strtoul()', and the same
+ * with a leading '-'. */
+static int test_lengths(void) {
+  const char *digits = "-1234567890123456789";
+  char        text[32];
+  for (Ulong n = 1; n <= 19; ++n) {
+    for (Ulong offset = 0; offset < 8; ++offset) {
+      memcpy(text, digits, (n + 1));
+      text[n + 1] = '\0';
+      char *block;
+      char *str = test_copy(text, offset, &block);
+      Ulong value;
+      Ulong used;
+      CHECK(conv_parse_u64((str + 1), CONV_TERMINATED, &value, &used));
+      CHECK(value == strtoul((text + 1), nullptr, 10) && used == n);
+      long ivalue;
+      CHECK(conv_parse_i64(str, CONV_TERMINATED, &ivalue, &used));
+      CHECK(ivalue == strtol(text, nullptr, 10) && used == (n + 1));
+      free(block);
+    }
+  }
+  return 0;
+}
+
+int main(void) {
+  if (test_short() || test_lengths()) {
+    return 1;
+  }
+  printf("Conv tests passed.\n");
+  return 0;
+}
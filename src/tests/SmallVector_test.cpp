@@ -0,0 +1,86 @@
+/** @file SmallVector_test.cpp
+ *
+ * Regression tests for 'MSmallVector', meant to be run under AddressSanitizer.  Return`s non zero
+ * on the first failure.
+ *
+ *   g++ -std=c++23 -g -fsanitize=address,undefined -include cstdarg -Iinclude tests/SmallVector_test.cpp \
+ *     cpp/Debug.cpp cpp/Sys.cpp cpp/Error.cpp cpp/Io.cpp cpp/Str_prim.cpp cpp/Str_intern.cpp cpp/Profile.cpp \
+ *     cpp/Mem_resource.cpp cpp/Obj_pool.cpp cpp/Mem_pool.cpp cpp/Conv.cpp cpp/Utf8.cpp cpp/Alloc_stats.cpp \
+ *     -lpthread -o smallvector_test && ./smallvector_test
+ */
+#include "../include/SmallVector.h"
+
+#include <cstdio>
+#include <string>
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed.\n", __FILE__, __LINE__, #cond); \
+      return 1;                                                       \
+    }                                                                 \
+  } while (0)
+
+/* Strings long enough to live on the heap, so a stale reference is a real use after free. */
+static std::string test_str(int i) {
+  return (std::string(32, 'x') + std::to_string(i));
+}
+
+/* Inserting one of its own elements into a full vector, both while inline and once spilled. */
+static int test_self_insert_at_capacity(void) {
+  MSmallVector<std::string, 4> v;
+  for (int i = 0; i < 4; ++i) {
+    v.push_back(test_str(i));
+  }
+  v.insert(0, v[1]);
+  CHECK(v.size() == 5);
+  CHECK(v[0] == test_str(1));
+  CHECK(v[1] == test_str(0));
+  CHECK(v[2] == test_str(1));
+  CHECK(v[4] == test_str(3));
+  while (v.size() < 8) {
+    v.push_back(test_str(v.size()));
+  }
+  v.insert(3, v[7]);
+  CHECK(v.size() == 9);
+  CHECK(v[3] == test_str(7));
+  CHECK(v[8] == test_str(7));
+  return 0;
+}
+
+/* With room to spare the shift still moves the element 'value' refers to. */
+static int test_self_insert_with_room(void) {
+  MSmallVector<std::string, 8> v;
+  for (int i = 0; i < 3; ++i) {
+    v.push_back(test_str(i));
+  }
+  v.insert(0, v[1]);
+  CHECK(v.size() == 4);
+  CHECK(v[0] == test_str(1));
+  CHECK(v[2] == test_str(1));
+  return 0;
+}
+
+/* 'emplace_back()' from one of its own elements at capacity, while inline and once spilled. */
+static int test_self_emplace_at_capacity(void) {
+  MSmallVector<std::string, 2> v;
+  v.push_back(test_str(0));
+  v.push_back(test_str(1));
+  v.emplace_back(v[0]);
+  CHECK(v.size() == 3);
+  CHECK(v[2] == v[0]);
+  v.emplace_back(v[1]);
+  CHECK(v[3] == test_str(1));
+  v.emplace_back(v[2]);
+  CHECK(v.size() == 5);
+  CHECK(v[4] == test_str(0));
+  return 0;
+}
+
+int main(void) {
+  if (test_self_insert_at_capacity() || test_self_insert_with_room() || test_self_emplace_at_capacity()) {
+    return 1;
+  }
+  printf("SmallVector tests passed.\n");
+  return 0;
+}
@@ -0,0 +1,79 @@
+/** @file Str_prim_test.cpp
+ *
+ * Every string primitive of every instruction set the cpu has, against the c library, on heap
+ * buffers of every length upto 'TEST_MAX_LEN' at every offset within a vector width.  Meant to be
+ * run under AddressSanitizer, the buffers are exactly as large as the string so any read that is
+ * not exempt from checking is reported.  Return`s non zero on the first failure.
+ *
+ *   g++ -std=c++23 -g -fsanitize=address,undefined -include cstdarg -Iinclude tests/Str_prim_test.cpp \
+ *     cpp/Str_prim.cpp -o str_prim_test && ./str_prim_test
+ */
+#include "../include/Str_prim.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed.\n", __FILE__, __LINE__, #cond); \
+      return 1;                                                       \
+    }                                                                 \
+  } while (0)
+
+#define TEST_MAX_LEN 200
+
+/* A string of 'len' bytes and its terminator at offset 'offset' of its own allocation, so the
+ * allocation ends right after the terminator.  The only 'x' in it is the middle byte. */
+static char *test_str(Ulong len, Ulong offset, char **block) {
+  *block    = (char *)malloc(offset + len + 1);
+  char *str = (*block + offset);
+  for (Ulong i = 0; i < len; ++i) {
+    str[i] = (char)('a' + (i % 23));
+  }
+  if (len) {
+    str[len / 2] = 'x';
+  }
+  str[len] = '\0';
+  return str;
+}
+
+static int test_isa(void) {
+  for (Ulong len = 0; len <= TEST_MAX_LEN; ++len) {
+    for (Ulong offset = 0; offset < 64; ++offset) {
+      char *block;
+      char *str = test_str(len, offset, &block);
+      CHECK(mstrlen(str) == len);
+      CHECK(mstrnlen(str, len) == len);
+      CHECK(mstrnlen(str, (len / 2)) == (len / 2));
+      CHECK(mstrnlen(str, (len + 100)) == len);
+      CHECK(mstrchr(str, 'x') == strchr(str, 'x'));
+      CHECK(mstrchr(str, 'z') == strchr(str, 'z'));
+      CHECK(mstrchr(str, '\0') == (str + len));
+      CHECK(mmemchr(str, 'x', len) == memchr(str, 'x', len));
+      CHECK(mmemchr(str, 'z', len) == memchr(str, 'z', len));
+      CHECK(mmemrchr(str, 'a', len) == memrchr(str, 'a', len));
+      CHECK(mmemrchr(str, 'z', len) == memrchr(str, 'z', len));
+      CHECK(mmemcmp(str, str, len) == 0);
+      free(block);
+    }
+  }
+  return 0;
+}
+
+int main(void) {
+  const char *isas[] = {"sse2", "avx2", "avx512", "libc"};
+  for (const char *isa : isas) {
+    if (!str_prim_select(isa)) {
+      printf("%s: not supported, skipped.\n", isa);
+      continue;
+    }
+    if (test_isa()) {
+      fprintf(stderr, "%s: failed.\n", isa);
+      return 1;
+    }
+    printf("%s: passed.\n", isa);
+  }
+  return 0;
+}
@@ -0,0 +1,73 @@
+/** @file Vector_test.cpp
+ *
+ * Regression tests for 'MVector', meant to be run under AddressSanitizer.  Return`s non zero on the
+ * first failure.
+ *
+ *   g++ -std=c++23 -g -fsanitize=address,undefined -include cstdarg -Iinclude tests/Vector_test.cpp \
+ *     cpp/Debug.cpp cpp/Sys.cpp cpp/Error.cpp cpp/Io.cpp cpp/Str_prim.cpp cpp/Str_intern.cpp cpp/Profile.cpp \
+ *     cpp/Mem_resource.cpp cpp/Obj_pool.cpp cpp/Mem_pool.cpp cpp/Conv.cpp cpp/Utf8.cpp cpp/Alloc_stats.cpp \
+ *     -lpthread -o vector_test && ./vector_test
+ */
+#include "../include/Mem_resource.h"
+#include "../include/Vector.h"
+
+#include <cstdio>
+#include <string>
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed.\n", __FILE__, __LINE__, #cond); \
+      return 1;                                                       \
+    }                                                                 \
+  } while (0)
+
+typedef mem_pool_alloc_t<16> pool_alloc_t;
+
+/* Every insert and append overload with an allocator that has no default constructor, including
+ * inserting a range of the vector into itself, which takes a copy through the allocator. */
+static int test_pool_insert_append(void) {
+  mem_pool_t<16> pool(4096);
+  MVector<int, pool_alloc_t> v {pool_alloc_t(pool)};
+  MVector<int, pool_alloc_t> w {pool_alloc_t(pool)};
+  const int src[] = {1, 2, 3};
+  v.append(src, 3);
+  v.insert(0u, 0);
+  v.insert_range(4, v.data(), 4);
+  w.append(v);
+  CHECK(w.size() == 8);
+  const int want[] = {0, 1, 2, 3, 0, 1, 2, 3};
+  for (Uint i = 0; i < 8; ++i) {
+    CHECK(w[i] == want[i]);
+  }
+  MVector<std::string, pool_alloc_t> s {pool_alloc_t(pool)};
+  s.push_back(std::string(40, 'a'));
+  s.push_back(std::string(40, 'b'));
+  s.insert(0u, s[1]);
+  CHECK(s.size() == 3);
+  CHECK(s[0] == std::string(40, 'b'));
+  CHECK(s[2] == std::string(40, 'b'));
+  return 0;
+}
+
+/* Growing one element at a time through 'resize()' reallocates a logarithmic number of times. */
+static int test_resize_growth(void) {
+  MVector<int> v;
+  Uint         reallocs = 0;
+  for (Uint i = 0; i < 100000; ++i) {
+    Uint cap = v.capacity();
+    v.resize(v.size() + 1);
+    reallocs += (v.capacity() != cap);
+  }
+  CHECK(v.size() == 100000);
+  CHECK(reallocs < 40);
+  return 0;
+}
+
+int main(void) {
+  if (test_pool_insert_append() || test_resize_growth()) {
+    return 1;
+  }
+  printf("Vector tests passed.\n");
+  return 0;
+}